@@ -345,6 +345,11 @@ OPTXT *create_opcode(CSOUND *csound, TREE *root, INSTRTXT *ip,
     //tp->linenum = root->line; tp->locn = root->locn;
     // ip->mdepends |= tp->oentry->flags;
     ip->opdstot += tp->oentry->dsblksiz;
+    /* bind a perf function specialised for ksmps where there is one */
+    if (tp->oentry->thread & 02) {
+      tp->perf = aops_ksmps_variant((SUBR) tp->oentry->kopadr,
+                                    (uint32_t) csound->ksmps);
+    }
 
     /* BUILD ARG LISTS */
     {
@@ -1297,6 +1302,9 @@ void insert_instrtxt(CSOUND *csound, INSTRTXT *instrtxt, int32 instrNum,
     /* inherit active & maxalloc flags */
     instrtxt->active = engineState->instrtxtp[instrNum]->active;
     instrtxt->maxalloc = engineState->instrtxtp[instrNum]->maxalloc;
+    instrtxt->steal = engineState->instrtxtp[instrNum]->steal;
+    instrtxt->stealfade = engineState->instrtxtp[instrNum]->stealfade;
+    instrtxt->stolen = engineState->instrtxtp[instrNum]->stolen;
 
     /* here we should move the old instrument definition into a deadpool
        which will be checked for active instances and freed when there are no
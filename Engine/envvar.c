@@ -26,6 +26,7 @@
 #include "envvar.h"
 #include <ctype.h>
 #include <math.h>
+#include <inttypes.h>
 
 #if defined(MSVC)
 #include <fcntl.h>
@@ -73,9 +74,62 @@ typedef struct CSFILE_ {
     int             pos;
     MYFLT           *buf;
     int             bufsize;
+    void            *wr;        /* background writer (async CSFILE_SND_W) */
+    void            *capture;   /* index of a capture file, or NULL */
     char            fullName[1];
 } CSFILE;
 
+/* A sound file written by file_iothread: the performance thread only
+   copies into a lock-free ring, which the I/O thread empties into the
+   file.  A block that does not fit is dropped whole and counted. */
+
+typedef struct SFWRITER_ {
+    struct SFWRITER_ *nxt;
+    SNDFILE         *sf;
+    char            *name;
+    char            *ring;
+    uint32_t        size;       /* in samples, a power of two */
+    volatile uint32_t wp, rp;   /* free running sample counts */
+    int             type;       /* AE_SHORT, AE_LONG, AE_FLOAT or 0: MYFLT */
+    int             smpsize, nchnls, rewrite;
+    uint32_t        peak;       /* most samples waiting at once */
+    int             overflows;
+    int64_t         dropped;    /* sample frames */
+    int             errors;
+} SFWRITER;
+
+/* A stream decoded ahead by file_iothread: the I/O thread calls the
+   source's read function to fill a lock-free ring of sample frames, and
+   the reader only copies out of it.  Reading ahead of the ring skips;
+   with CS_STREAM_BACK half of the ring is kept behind the reader, so
+   reads going back a little find their frames too.  Any other seek is
+   posted to the I/O thread (seekgen) and the reader gets nothing until
+   it is done (ackgen), the ring being emptied in between. */
+
+typedef struct SFREADER_ {
+    struct SFREADER_ *nxt;
+    char            *name;
+    int             (*read)(void *, MYFLT *, int);
+    int             (*seek)(void *, int64_t);
+    void            *data;
+    MYFLT           *ring;
+    uint32_t        size;       /* in sample frames, a power of two */
+    volatile uint32_t wp, rp;   /* free running frame counts */
+    int             nchnls, flags;
+    int64_t         length;     /* in sample frames, or -1 if not known */
+    int64_t         pos;        /* reader: frame at rp */
+    int64_t         seekpos;
+    volatile int    seekgen, ackgen;
+    volatile int    eof;
+    int64_t         srcpos;     /* I/O thread: frame at wp */
+    uint32_t        hist;       /* frames kept behind rp (CS_STREAM_BACK) */
+    uint32_t        lo, hi;     /* reader: rp at the last seek, highest rp
+                                   since; frames from max(lo, hi - hist)
+                                   are still in the ring */
+    int64_t         skip;       /* reader: frames to skip after a seek */
+    int             underruns;
+} SFREADER;
+
 #if defined(MSVC)
 #define RD_OPTS  _O_RDONLY | _O_BINARY
 #define WR_OPTS  _O_TRUNC | _O_CREAT | _O_WRONLY | _O_BINARY,_S_IWRITE
@@ -1088,6 +1142,10 @@ void *csoundFileOpenWithType(CSOUND *csound, void *fd, int type,
     p->fd = tmp_fd;
     p->f = tmp_f;
     p->sf = (SNDFILE*) NULL;
+    p->cb = NULL;
+    p->wr = NULL;
+    p->capture = NULL;
+    p->async_flag = 0;
     strcpy(&(p->fullName[0]), fullName);
     if (env != NULL) {
       csound->Free(csound, fullName);
@@ -1101,6 +1159,9 @@ void *csoundFileOpenWithType(CSOUND *csound, void *fd, int type,
       break;
     case CSFILE_SND_R:                        /* sound file read */
       memcpy(&sfinfo, param, sizeof(SF_INFO));
+      /* a capture has no header, but its index says what it holds */
+      if (SF2TYPE(sfinfo.format) == 0)
+        csoundCaptureInfo(csound, p->fullName, &sfinfo);
       p->sf = sf_open_fd(tmp_fd, SFM_READ, &sfinfo, 0);
       if (p->sf == (SNDFILE*) NULL) {
         int   extPos;
@@ -1151,10 +1212,13 @@ void *csoundFileOpenWithType(CSOUND *csound, void *fd, int type,
       *((SNDFILE**) fd) = p->sf;
       break;
     case CSFILE_SND_W:                        /* sound file write */
+      p->capture = csoundCaptureOpen(csound, p->fullName, param);
       p->sf = sf_open_fd(tmp_fd, SFM_WRITE, (SF_INFO*) param, 0);
       if (UNLIKELY(p->sf == (SNDFILE*) NULL)) {
           csound->Warning(csound, Str("Failed to open %s: %s\n"),
                           fullName, sf_strerror(NULL));
+        if (p->capture != NULL)
+          csoundCaptureClose(csound, p->capture, 1);
         goto err_return;
       }
       sf_command(p->sf, SFC_SET_CLIPPING, NULL, SF_TRUE);
@@ -1284,6 +1348,9 @@ int csoundFileClose(CSOUND *csound, void *fd)
     CSFILE  *p = (CSFILE*) fd;
     int     retval = -1;
     if (p->async_flag == ASYNC_GLOBAL) {
+      if (p->wr != NULL)          /* write what is still waiting first */
+        csoundSndfileCloseAsync(csound, p->wr);
+      p->wr = NULL;
       csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
       /* close file */
       switch (p->type) {
@@ -1312,7 +1379,8 @@ int csoundFileClose(CSOUND *csound, void *fd)
         p->nxt->prv = p->prv;
       if (p->buf != NULL) csound->Free(csound, p->buf);
       p->bufsize = 0;
-      csound->DestroyCircularBuffer(csound, p->cb);
+      if (p->cb != NULL)
+        csound->DestroyCircularBuffer(csound, p->cb);
       csound->NotifyThreadLock(csound->file_io_threadlock);
     } else {
       /* close file */
@@ -1339,6 +1407,8 @@ int csoundFileClose(CSOUND *csound, void *fd)
       if (p->nxt != NULL)
         p->nxt->prv = p->prv;
     }
+    if (p->capture != NULL)
+      csoundCaptureClose(csound, p->capture, 0);
     /* free allocated memory */
     csound->Free(csound, fd);
 
@@ -1346,18 +1416,50 @@ int csoundFileClose(CSOUND *csound, void *fd)
     return retval;
 }
 
+/* Counts frames written to a file opened with csoundFileOpen(), for the
+   index of a capture file; does nothing for other files. */
+
+void csoundFileCaptureWrite(CSOUND *csound, void *fd, int nframes)
+{
+    CSFILE  *p = (CSFILE*) fd;
+    if (p != NULL && p->capture != NULL)
+      csoundCaptureWrite(csound, p->capture, nframes);
+}
+
+/* Adds a marker at score sample 'sample' to the index of a capture file
+   opened with csoundFileOpen(), or of the -o output if fd is NULL.
+   Returns -1 if the file is not a capture. */
+
+int csoundFileCaptureMarker(CSOUND *csound, void *fd, int64_t sample,
+                            const char *label)
+{
+    void    *capture = (fd == NULL ? csound->libsndStatics.capture :
+                        ((CSFILE*) fd)->capture);
+    if (capture == NULL)
+      return -1;
+    csoundCaptureMarker(csound, capture, sample, label);
+    return 0;
+}
+
 /* Close all open files; called by csoundReset(). */
 
 void close_all_files(CSOUND *csound)
 {
+    while (csound->asyncWriters != NULL)
+      csoundSndfileCloseAsync(csound, csound->asyncWriters);
+    while (csound->asyncReaders != NULL)
+      csoundStreamClose(csound, csound->asyncReaders);
     while (csound->open_files != NULL)
       csoundFileClose(csound, csound->open_files);
-    if (csound->file_io_start) {
+    if (csound->file_io_thread != NULL) {
 #ifndef __EMSCRIPTEN__
       csound->JoinThread(csound->file_io_thread);
 #endif
-      if (csound->file_io_threadlock != NULL)
-        csound->DestroyThreadLock(csound->file_io_threadlock);
+      csound->file_io_thread = NULL;
+    }
+    if (csound->file_io_threadlock != NULL) {
+      csound->DestroyThreadLock(csound->file_io_threadlock);
+      csound->file_io_threadlock = NULL;
     }
 }
 
@@ -1395,6 +1497,24 @@ void *fopen_path(CSOUND *csound, FILE **fp, char *name, char *basename,
 
 uintptr_t file_iothread(void *p);
 
+/* starts the I/O thread if it is not running, and takes its lock */
+
+static void lock_iothread(CSOUND *csound)
+{
+    if (csound->file_io_threadlock == NULL) {
+      csound->file_io_threadlock = csound->CreateThreadLock();
+      csound->NotifyThreadLock(csound->file_io_threadlock);
+    }
+    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+    if (csound->file_io_start == 0) {
+      if (csound->file_io_thread != NULL)   /* ran out of files earlier */
+        csound->JoinThread(csound->file_io_thread);
+      csound->file_io_start = 1;
+      csound->file_io_thread =
+        csound->CreateThread(file_iothread, (void *) csound);
+    }
+}
+
 void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
                                    const char *name, void *param, const char *env,
                                    int csFileType, int buffsize, int isTemporary)
@@ -1405,14 +1525,14 @@ void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
                                                csFileType,isTemporary)) == NULL)
       return NULL;
 
-    if (csound->file_io_start == 0) {
-      csound->file_io_start = 1;
-      csound->file_io_threadlock = csound->CreateThreadLock();
-      csound->NotifyThreadLock(csound->file_io_threadlock);
-      csound->file_io_thread =
-        csound->CreateThread(file_iothread, (void *) csound);
+    if (type == CSFILE_SND_W) {
+      /* written through a ring of its own, see csoundSndfileOpenAsync() */
+      p->wr = csoundSndfileOpenAsync(csound, p->sf, p->fullName, 0,
+                                     ((SF_INFO*) param)->channels, 0);
+      p->async_flag = ASYNC_GLOBAL;
+      return (void *) p;
     }
-    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+    lock_iothread(csound);
     p->async_flag = ASYNC_GLOBAL;
 
     p->cb = csound->CreateCircularBuffer(csound, buffsize*4, sizeof(MYFLT));
@@ -1446,8 +1566,8 @@ unsigned int csoundWriteAsync(CSOUND *csound, void *handle,
                               MYFLT *buf, int items)
 {
     CSFILE *p = handle;
-    if (p != NULL &&  p->cb != NULL)
-      return csound->WriteCircularBuffer(csound, p->cb, buf, items);
+    if (p != NULL &&  p->wr != NULL)
+      return csoundSndfileWriteAsync(csound, p->wr, buf, items);
     else return 0;
 }
 
@@ -1464,6 +1584,8 @@ int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence){
       break;
     case CSFILE_SND_R:
     case CSFILE_SND_W:
+      if (p->cb == NULL)          /* background writes cannot seek */
+        break;
       ret = sf_seek(p->sf,pos,whence);
       //csoundMessage(csound, "seek set %d\n", pos);
       csound->FlushCircularBuffer(csound, p->cb);
@@ -1475,11 +1597,452 @@ int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence){
 }
 
 
+/* Registers an open sound file to be written by the I/O thread, with a
+   ring of --write-buffer sample frames (one second by default).  'type'
+   is the sample type passed to csoundSndfileWriteAsync(): AE_SHORT,
+   AE_LONG (or AE_24INT), AE_FLOAT, or 0 for MYFLT.  If 'rewrite' is
+   non-zero the header is updated after every write.  Returns NULL if
+   there is no I/O thread; the file should then be written directly. */
+
+void *csoundSndfileOpenAsync(CSOUND *csound, void *sf, const char *name,
+                             int type, int nchnls, int rewrite)
+{
+#ifndef __EMSCRIPTEN__
+    SFWRITER  *w;
+    int64_t   frames = csound->oparms->writeBuffer;
+    uint32_t  size = 1024;
+
+    if (sf == NULL || nchnls < 1)
+      return NULL;
+    if (frames <= 0)
+      frames = (int64_t) (csound->esr > FL(0.0) ? csound->esr : FL(44100.0));
+    while ((int64_t) size < frames * nchnls && size < 0x40000000U)
+      size <<= 1;
+    w = (SFWRITER*) csound->Calloc(csound, sizeof(SFWRITER));
+    w->sf = (SNDFILE*) sf;
+    w->name = cs_strdup(csound, (char*) (name != NULL ? name : ""));
+    w->type = type;
+    switch (type) {
+    case AE_SHORT:  w->smpsize = (int) sizeof(short); break;
+    case AE_24INT:
+    case AE_LONG:   w->smpsize = (int) sizeof(int);   break;
+    case AE_FLOAT:  w->smpsize = (int) sizeof(float); break;
+    default:        w->type = 0;
+                    w->smpsize = (int) sizeof(MYFLT); break;
+    }
+    w->ring = (char*) csound->Malloc(csound, (size_t) size * w->smpsize);
+    w->size = size;
+    w->nchnls = nchnls;
+    w->rewrite = rewrite;
+    lock_iothread(csound);
+    w->nxt = (SFWRITER*) csound->asyncWriters;
+    csound->asyncWriters = (void*) w;
+    csound->NotifyThreadLock(csound->file_io_threadlock);
+    return (void*) w;
+#else
+    return NULL;
+#endif
+}
+
+/* Queues 'nsmps' interleaved samples for writing, without blocking.  A
+   block that does not fit in the ring is dropped whole, so that the
+   channels stay aligned, and counted.  Returns the number of samples
+   queued. */
+
+int csoundSndfileWriteAsync(CSOUND *csound, void *handle,
+                            const void *buf, int nsmps)
+{
+    SFWRITER  *w = (SFWRITER*) handle;
+    uint32_t  wp, fill, ofs, n1;
+    IGN(csound);
+    if (UNLIKELY(w == NULL || nsmps <= 0))
+      return 0;
+    wp = w->wp;
+    fill = wp - ATOMIC_GET(w->rp);
+    if (UNLIKELY((uint32_t) nsmps > w->size - fill)) {
+      w->overflows++;
+      w->dropped += nsmps / w->nchnls;
+      return 0;
+    }
+    ofs = wp & (w->size - 1);
+    n1 = w->size - ofs;
+    n1 = (n1 < (uint32_t) nsmps ? n1 : (uint32_t) nsmps);
+    memcpy(w->ring + (size_t) ofs * w->smpsize, buf, (size_t) n1 * w->smpsize);
+    if (n1 < (uint32_t) nsmps)
+      memcpy(w->ring, (const char*) buf + (size_t) n1 * w->smpsize,
+             (size_t) (nsmps - n1) * w->smpsize);
+    fill += (uint32_t) nsmps;
+    if (fill > w->peak)
+      w->peak = fill;
+    ATOMIC_SET(w->wp, wp + (uint32_t) nsmps);
+    return nsmps;
+}
+
+/* writes what is waiting in the ring; called with the I/O thread lock */
+
+static int sfwriter_flush(SFWRITER *w)
+{
+    uint32_t  rp = w->rp, avail = ATOMIC_GET(w->wp) - rp;
+    int       done = (avail > 0);
+
+    while (avail > 0) {
+      uint32_t  ofs = rp & (w->size - 1);
+      uint32_t  n = w->size - ofs;
+      sf_count_t  m;
+      void      *p = (void*) (w->ring + (size_t) ofs * w->smpsize);
+      n = (n < avail ? n : avail);
+      switch (w->type) {
+      case AE_SHORT:  m = sf_write_short(w->sf, (short*) p, n);   break;
+      case AE_24INT:
+      case AE_LONG:   m = sf_write_int(w->sf, (int*) p, n);       break;
+      case AE_FLOAT:  m = sf_write_float(w->sf, (float*) p, n);   break;
+      default:        m = sf_write_MYFLT(w->sf, (MYFLT*) p, n);   break;
+      }
+      if (UNLIKELY(m != (sf_count_t) n))
+        w->errors++;
+      rp += n;
+      avail -= n;
+      ATOMIC_SET(w->rp, rp);
+    }
+    if (done && w->rewrite)
+      sf_command(w->sf, SFC_UPDATE_HEADER_NOW, NULL, 0);
+    return done;
+}
+
+/* Writes what is left of a file registered with csoundSndfileOpenAsync()
+   and stops writing it; the SNDFILE itself is not closed. */
+
+void csoundSndfileCloseAsync(CSOUND *csound, void *handle)
+{
+    SFWRITER  *w = (SFWRITER*) handle, **pp;
+
+    if (w == NULL)
+      return;
+    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+    sfwriter_flush(w);
+    for (pp = (SFWRITER**) &(csound->asyncWriters); *pp != NULL;
+         pp = &((*pp)->nxt)) {
+      if (*pp == w) {
+        *pp = w->nxt;
+        break;
+      }
+    }
+    csound->NotifyThreadLock(csound->file_io_threadlock);
+    if (UNLIKELY(w->overflows))
+      csound->Warning(csound, Str("%s: background write buffer overflowed "
+                                  "%d times, %" PRId64 " sample frames "
+                                  "dropped (try a larger --write-buffer)"),
+                      w->name, w->overflows, w->dropped);
+    if (UNLIKELY(w->errors))
+      csound->Warning(csound, Str("%s: %d background writes failed"),
+                      w->name, w->errors);
+    if (UNLIKELY((csound->oparms->msglevel & 7) == 7))
+      csound->Message(csound, Str("%s: background write buffer peak %.1f%% "
+                                  "of %u samples\n"), w->name,
+                      100.0 * (double) w->peak / (double) w->size, w->size);
+    csound->Free(csound, w->ring);
+    csound->Free(csound, w->name);
+    csound->Free(csound, w);
+}
+
+/* Registers a stream to be decoded ahead by the I/O thread into a ring of
+   'frames' sample frames (one second if zero or less).  read() returns
+   the number of frames it decoded into its buffer, zero at the end;
+   seek() goes to a frame and returns zero on success.  'length' is the
+   number of frames in the stream, or -1 if not known.  With CS_STREAM_LOOP
+   decoding starts again from the beginning at the end, and frame positions
+   wrap at 'length'.  With CS_STREAM_WAIT a read waits for the I/O thread
+   instead of returning what is there; use it where not real-time.
+   CS_STREAM_BACK is for readers that may go backwards (see SFREADER).
+   As this is called at i-time, it waits until the start of the stream
+   is decoded, so that the first k-cycles do not wait or underrun. */
+
+void *csoundStreamOpen(CSOUND *csound, const char *name, int nchnls,
+                       int64_t length, int frames,
+                       int (*read)(void *, MYFLT *, int),
+                       int (*seek)(void *, int64_t), void *data, int flags)
+{
+#ifndef __EMSCRIPTEN__
+    SFREADER  *r;
+    uint32_t  size = 256;
+
+    if (read == NULL || nchnls < 1)
+      return NULL;
+    if (frames <= 0)
+      frames = (int) (csound->esr > FL(0.0) ? csound->esr : FL(44100.0));
+    while ((int) size < frames && size < 0x1000000U)
+      size <<= 1;
+    r = (SFREADER*) csound->Calloc(csound, sizeof(SFREADER));
+    r->name = cs_strdup(csound, (char*) (name != NULL ? name : ""));
+    r->read = read;
+    r->seek = seek;
+    r->data = data;
+    r->ring = (MYFLT*) csound->Malloc(csound, (size_t) size * nchnls
+                                              * sizeof(MYFLT));
+    r->size = size;
+    r->nchnls = nchnls;
+    r->length = length;
+    r->flags = (length > 0 && seek != NULL ? flags : flags & ~CS_STREAM_LOOP);
+    if ((r->flags & CS_STREAM_BACK) && seek != NULL)
+      r->hist = size / 2;
+    lock_iothread(csound);
+    r->nxt = (SFREADER*) csound->asyncReaders;
+    csound->asyncReaders = (void*) r;
+    csound->NotifyThreadLock(csound->file_io_threadlock);
+    while (ATOMIC_GET(r->wp) < size - r->hist && !ATOMIC_GET(r->eof))
+      csoundSleep(1);                           /* prefill */
+    return (void*) r;
+#else
+    return NULL;
+#endif
+}
+
+static int sfstream_read(void *sf, MYFLT *buf, int nframes)
+{
+    sf_count_t  n = sf_readf_MYFLT((SNDFILE*) sf, buf, (sf_count_t) nframes);
+    return (n > 0 ? (int) n : 0);
+}
+
+static int sfstream_seek(void *sf, int64_t frame)
+{
+    return (sf_seek((SNDFILE*) sf, (sf_count_t) frame, SEEK_SET) < 0 ? -1 : 0);
+}
+
+/* csoundStreamOpen() for a sound file opened for reading, decoded from
+   its current position */
+
+void *csoundSndfileStreamOpen(CSOUND *csound, void *sf, const char *name,
+                              int nchnls, int64_t length, int frames,
+                              int flags)
+{
+    return csoundStreamOpen(csound, name, nchnls, length, frames,
+                            sfstream_read, sfstream_seek, sf, flags);
+}
+
+/* Reads up to 'nframes' interleaved sample frames starting at 'frame', or
+   at the end of the last read if 'frame' is negative.  Returns the number
+   of frames read; fewer at the end of the stream, or if the I/O thread is
+   behind (counted as an underrun) and CS_STREAM_WAIT was not given. */
+
+int csoundStreamRead(CSOUND *csound, void *handle, int64_t frame,
+                     MYFLT *buf, int nframes)
+{
+    SFREADER  *r = (SFREADER*) handle;
+    uint32_t  rp, avail, n;
+    int       got = 0, wait;
+
+    if (UNLIKELY(r == NULL || nframes <= 0))
+      return 0;
+    rp = r->rp;
+    if (frame >= 0 && frame != r->pos) {
+      avail = ATOMIC_GET(r->wp) - rp;
+      if (ATOMIC_GET(r->ackgen) == r->seekgen && r->skip == 0 &&
+          frame > r->pos && frame - r->pos < (int64_t) avail) {
+        rp += (uint32_t) (frame - r->pos);      /* skip what is decoded */
+        ATOMIC_SET(r->rp, rp);
+      }
+      else if (ATOMIC_GET(r->ackgen) == r->seekgen && r->skip == 0 &&
+               frame < r->pos && r->hist > 0 &&
+               r->pos - frame <= (int64_t) (rp - r->lo) &&
+               r->pos - frame <= (int64_t) (rp - (r->hi - r->hist))) {
+        rp -= (uint32_t) (r->pos - frame);      /* still in the ring */
+        ATOMIC_SET(r->rp, rp);
+      }
+      else if (r->seek != NULL) {
+        int64_t ofs = 0;
+        /* going backwards: decode from further back, so that the reads
+           that follow are in the ring */
+        if (r->hist > 0 && frame < r->pos) {
+          ofs = (int64_t) r->hist - nframes;
+          ofs = (ofs < frame ? ofs : frame);
+          ofs = (ofs > 0 ? ofs : 0);
+        }
+        r->seekpos = frame - ofs;
+        r->skip = ofs;
+        r->lo = r->hi = rp;
+        ATOMIC_SET(r->seekgen, r->seekgen + 1);
+      }
+      r->pos = frame;
+    }
+    wait = (r->flags & CS_STREAM_WAIT);
+    while (got < nframes) {
+      if (ATOMIC_GET(r->ackgen) != r->seekgen) {
+        if (!wait) {
+          r->underruns++;
+          break;
+        }
+        csoundSleep(1);
+        continue;
+      }
+      avail = ATOMIC_GET(r->wp) - rp;
+      if (UNLIKELY(r->skip > 0)) {              /* to the frame asked for */
+        n = (r->skip < (int64_t) avail ? (uint32_t) r->skip : avail);
+        rp += n;
+        r->skip -= n;
+        ATOMIC_SET(r->rp, rp);
+        if (r->skip > 0) {
+          if (ATOMIC_GET(r->eof))
+            r->skip = 0;
+          else if (!wait) {
+            r->underruns++;
+            break;
+          }
+          else
+            csoundSleep(1);
+        }
+        continue;
+      }
+      if (avail == 0) {
+        if (ATOMIC_GET(r->eof)) {
+          if (ATOMIC_GET(r->wp) == rp)
+            break;
+          continue;
+        }
+        if (!wait) {
+          r->underruns++;
+          break;
+        }
+        csoundSleep(1);
+        continue;
+      }
+      n = r->size - (rp & (r->size - 1));
+      n = (n < avail ? n : avail);
+      n = (n < (uint32_t) (nframes - got) ? n : (uint32_t) (nframes - got));
+      memcpy(buf + (size_t) got * r->nchnls,
+             r->ring + (size_t) (rp & (r->size - 1)) * r->nchnls,
+             (size_t) n * r->nchnls * sizeof(MYFLT));
+      rp += n;
+      got += (int) n;
+      ATOMIC_SET(r->rp, rp);
+      r->pos += n;
+      if ((r->flags & CS_STREAM_LOOP) && r->pos >= r->length)
+        r->pos -= r->length;
+    }
+    if ((int32_t) (rp - r->hi) > 0)
+      r->hi = rp;
+    IGN(csound);
+    return got;
+}
+
+/* Goes to 'frame' at i-time, waiting until the frames from there on (and
+   with CS_STREAM_BACK, those just before it) are decoded, so that reading
+   from a start position other than the beginning does not underrun. */
+
+void csoundStreamSeek(CSOUND *csound, void *handle, int64_t frame)
+{
+    SFREADER  *r = (SFREADER*) handle;
+    uint32_t  rp, avail, n;
+    int64_t   ofs;
+
+    if (r == NULL || r->seek == NULL || frame < 0 || frame == r->pos)
+      return;
+    ofs = ((int64_t) r->hist < frame ? (int64_t) r->hist : frame);
+    rp = r->rp;
+    r->seekpos = frame - ofs;
+    r->skip = ofs;
+    r->lo = r->hi = rp;
+    r->pos = frame;
+    ATOMIC_SET(r->seekgen, r->seekgen + 1);
+    while (ATOMIC_GET(r->ackgen) != r->seekgen)
+      csoundSleep(1);
+    while (r->skip > 0) {
+      avail = ATOMIC_GET(r->wp) - rp;
+      n = (r->skip < (int64_t) avail ? (uint32_t) r->skip : avail);
+      rp += n;
+      r->skip -= n;
+      ATOMIC_SET(r->rp, rp);
+      if (r->skip > 0) {
+        if (ATOMIC_GET(r->eof))
+          r->skip = 0;
+        else
+          csoundSleep(1);
+      }
+    }
+    r->hi = rp;
+    while (ATOMIC_GET(r->wp) - rp < r->size - r->hist && !ATOMIC_GET(r->eof))
+      csoundSleep(1);
+    IGN(csound);
+}
+
+/* decodes into the ring until it is full; called with the I/O thread
+   lock */
+
+static int sfreader_fill(SFREADER *r)
+{
+    int       gen = ATOMIC_GET(r->seekgen), done = 0, m;
+    uint32_t  wp = r->wp, space, ofs, n;
+
+    if (gen != r->ackgen) {
+      /* the reader waits for the seek, so rp does not move */
+      r->eof = (r->seek(r->data, r->seekpos) != 0);
+      r->srcpos = r->seekpos;
+      wp = ATOMIC_GET(r->rp);
+      ATOMIC_SET(r->wp, wp);
+      ATOMIC_SET(r->ackgen, gen);
+      done = 1;
+    }
+    /* the reader may move rp back by up to hist frames */
+    while (!r->eof &&
+           wp - ATOMIC_GET(r->rp) < r->size - r->hist) {
+      space = r->size - r->hist - (wp - ATOMIC_GET(r->rp));
+      ofs = wp & (r->size - 1);
+      n = r->size - ofs;
+      n = (n < space ? n : space);
+      m = r->read(r->data, r->ring + (size_t) ofs * r->nchnls, (int) n);
+      if (m <= 0) {
+        if ((r->flags & CS_STREAM_LOOP) && r->srcpos > 0 &&
+            r->seek(r->data, 0) == 0) {
+          r->srcpos = 0;
+          continue;
+        }
+        ATOMIC_SET(r->eof, 1);
+        break;
+      }
+      wp += (uint32_t) m;
+      r->srcpos += m;
+      ATOMIC_SET(r->wp, wp);
+      done = 1;
+    }
+    return done;
+}
+
+/* Stops decoding a stream opened with csoundStreamOpen(); the source
+   itself is not closed. */
+
+void csoundStreamClose(CSOUND *csound, void *handle)
+{
+    SFREADER  *r = (SFREADER*) handle, **pp;
+
+    if (r == NULL)
+      return;
+    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+    for (pp = (SFREADER**) &(csound->asyncReaders); *pp != NULL;
+         pp = &((*pp)->nxt)) {
+      if (*pp == r) {
+        *pp = r->nxt;
+        break;
+      }
+    }
+    csound->NotifyThreadLock(csound->file_io_threadlock);
+    if (UNLIKELY(r->underruns && (csound->oparms->msglevel & WARNMSG)))
+      csound->Warning(csound, Str("%s: decoding fell behind %d times"),
+                      r->name, r->underruns);
+    csound->Free(csound, r->ring);
+    csound->Free(csound, r->name);
+    csound->Free(csound, r);
+}
+
 static int read_files(CSOUND *csound){
     CSFILE *current = (CSFILE *) csound->open_files;
-    if (current == NULL) return 0;
+    SFWRITER *w = (SFWRITER *) csound->asyncWriters;
+    SFREADER *r = (SFREADER *) csound->asyncReaders;
+    if (current == NULL && w == NULL && r == NULL) return 0;
+    for ( ; w != NULL; w = w->nxt)
+      sfwriter_flush(w);
+    for ( ; r != NULL; r = r->nxt)
+      sfreader_fill(r);
     while (current) {
-      if (current->async_flag == ASYNC_GLOBAL) {
+      if (current->async_flag == ASYNC_GLOBAL && current->cb != NULL) {
         int m = current->pos, l, n = current->items;
         int items = current->bufsize;
         MYFLT *buf = current->buf;
@@ -1501,11 +2064,6 @@ static int read_files(CSOUND *csound){
           current->items = n;
           current->pos = m;
           break;
-        case CSFILE_SND_W:
-          items = csound->ReadCircularBuffer(csound, current->cb, buf, items);
-          if (items == 0) { csoundSleep(10); break;}
-          sf_write_MYFLT(current->sf, buf, items);
-          break;
         }
       }
       current = current->nxt;
@@ -1513,9 +2071,6 @@ static int read_files(CSOUND *csound){
     return 1;
 }
 
-
-
-
 uintptr_t file_iothread(void *p){
     int res = 1;
     CSOUND *csound = p;
@@ -1526,8 +2081,9 @@ uintptr_t file_iothread(void *p){
       csoundSleep(wakeup);
       csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
       res = read_files(csound);
+      if (!res)                   /* restarted by the next async open */
+        csound->file_io_start = 0;
       csound->NotifyThreadLock(csound->file_io_threadlock);
     }
-    csound->file_io_start = 0;
     return (uintptr_t)NULL;
 }
@@ -130,6 +130,66 @@ static inline unsigned int isPowerOfTwo (unsigned int x) {
  * Returns zero on success.
  */
 
+/* Tables shared with a template instance (see csoundSetTemplate()): an
+   instance asking for a table its template made from the same GEN
+   arguments gets the template's table, read-only, instead of making its
+   own.  Shared tables belong to the template and are never freed here. */
+
+static int ftshared(CSOUND *csound, FUNC *ftp)
+{
+    CSOUND  *t = csound->ftTemplate;
+    return (t != NULL && ftp != NULL && ftp->fno > 0 &&
+            ftp->fno <= t->maxfnum && t->flist[ftp->fno] == ftp);
+}
+
+/* Only GENs that make a table from their own p-fields can share it:
+   the ones reading a file or another table (1, 4, 18, 23, 24, 28, 30-34,
+   40, 43, 44, 49, 52, 53) may give a different table for the same
+   arguments, as does the random GEN21, and named GENs are unknown. */
+
+static int ftshareable(int32 genum)
+{
+    switch (genum) {
+    case 2: case 3: case 5: case 6: case 7: case 8: case 9: case 10:
+    case 11: case 12: case 13: case 14: case 15: case 16: case 17:
+    case 19: case 20: case 25: case 27: case 41: case 42: case 51:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+static FUNC *ftshare(const FGDATA *ff)
+{
+    CSOUND  *t = ff->csound->ftTemplate;
+    FUNC    *ftp;
+    int     n = ff->e.pcnt - 3;
+
+    if (ff->fno > t->maxfnum || (ftp = t->flist[ff->fno]) == NULL ||
+        ftp->argcnt != n || n > PMAX - 4 || ftp->gensize != ff->e.p[3] ||
+        memcmp(ftp->args, &(ff->e.p[4]), n * sizeof(MYFLT)) != 0)
+      return NULL;
+    if ((ftp->genstr == NULL) != (ff->e.strarg == NULL) ||
+        (ftp->genstr != NULL && strcmp(ftp->genstr, ff->e.strarg) != 0))
+      return NULL;
+    return ftp;
+}
+
+/* keep what a table was made from, for ftshare() */
+static void ftrecord(const FGDATA *ff, FUNC *ftp)
+{
+    CSOUND  *csound = ff->csound;
+
+    ftp->gensize = ff->e.p[3];
+    csound->Free(csound, ftp->genstr);
+    ftp->genstr = NULL;
+    if (ff->e.strarg != NULL) {
+      size_t  n = strlen(ff->e.strarg) + 1;
+      ftp->genstr = (char*) csound->Malloc(csound, n);
+      memcpy(ftp->genstr, ff->e.strarg, n);
+    }
+}
+
 int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
 {
     int32    genum, ltest;
@@ -166,7 +226,10 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
         return fterror(&ff, Str("ftable does not exist"));
       }
       csound->flist[ff.fno] = NULL;
-      csound->Free(csound, (void*) ftp);
+      if (!ftshared(csound, ftp)) {           /*  shared: just detach     */
+        csound->Free(csound, ftp->genstr);
+        csound->Free(csound, (void*) ftp);
+      }
       if (UNLIKELY(msg_enabled))
         csoundMessage(csound, Str("ftable %d now deleted\n"), ff.fno);
       return 0;
@@ -223,6 +286,17 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
         return fterror(&ff, Str("illegal gen number"));
       }
     }
+    if (csound->ftTemplate != NULL && ftshareable(genum) &&
+        (csound->flist[ff.fno] == NULL ||
+         ftshared(csound, csound->flist[ff.fno])) &&
+        (ftp = ftshare(&ff)) != NULL) {
+      if (UNLIKELY(msg_enabled))
+        csoundMessage(csound, Str("ftable %d: shared with template\n"),
+                      ff.fno);
+      csound->flist[ff.fno] = ftp;
+      *ftpp = ftp;
+      return 0;
+    }
     ff.flen = (int32) MYFLT2LRND(ff.e.p[3]);
     if (!ff.flen) {
       /* defer alloc to gen01|gen23|gen28 */
@@ -240,6 +314,8 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
         csound->Free(csound, ftp);
         return -1;
       }
+      if (ftp != NULL)
+        ftrecord(&ff, ftp);
       *ftpp = ftp;
       return 0;
     }
@@ -306,6 +382,7 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
       /*for (k=0; k < size; k++)
         csound->Message(csound, "%f\n", ftp->args[k]);*/
     }
+    ftrecord(&ff, ftp);
     return 0;
 }
 
@@ -335,8 +412,10 @@ int csoundFTAlloc(CSOUND *csound, int tableNum, int len)
     /* allocate space for table */
     size = (int) (len * (int) sizeof(MYFLT));
     ftp = csound->flist[tableNum];
+    if (ftshared(csound, ftp))                  /* never write the template's */
+      csound->flist[tableNum] = ftp = NULL;
     if (ftp == NULL) {
-      csound->flist[tableNum] = (FUNC*) csound->Malloc(csound, sizeof(FUNC));
+      csound->flist[tableNum] = (FUNC*) csound->Calloc(csound, sizeof(FUNC));
       csound->flist[tableNum]->ftable =
         (MYFLT*)csound->Malloc(csound, sizeof(MYFLT)*(len+1));
     }
@@ -348,8 +427,12 @@ int csoundFTAlloc(CSOUND *csound, int tableNum, int len)
                                         "may find this disturbing"), tableNum);
       }
       csound->flist[tableNum] = NULL;
+      csound->Free(csound, ftp->genstr);
+      csound->Free(csound, ftp->ftable);
       csound->Free(csound, ftp);
-      csound->flist[tableNum] = (FUNC*) csound->Malloc(csound, (size_t) size);
+      csound->flist[tableNum] = (FUNC*) csound->Calloc(csound, sizeof(FUNC));
+      csound->flist[tableNum]->ftable =
+        (MYFLT*)csound->Malloc(csound, (size_t) size + sizeof(MYFLT));
     }
     /* initialise table header */
     ftp = csound->flist[tableNum];
@@ -386,7 +469,10 @@ int csoundFTDelete(CSOUND *csound, int tableNum)
     if (UNLIKELY(ftp == NULL))
       return -1;
     csound->flist[tableNum] = NULL;
-    csound->Free(csound, ftp);
+    if (!ftshared(csound, ftp)) {
+      csound->Free(csound, ftp->genstr);
+      csound->Free(csound, ftp);
+    }
 
     return 0;
 }
@@ -2369,7 +2455,10 @@ static CS_NOINLINE FUNC *ftalloc(const FGDATA *ff)
 
     if (UNLIKELY(ftp != NULL)) {
       csound->Warning(csound, Str("replacing previous ftable %d"), ff->fno);
-      if (ff->flen != (int32)ftp->flen) {       /* if redraw & diff len, */
+      if (ftshared(csound, ftp))                /* the template's: detach */
+        csound->flist[ff->fno] = ftp = NULL;
+      else if (ff->flen != (int32)ftp->flen) {  /* if redraw & diff len, */
+        csound->Free(csound, ftp->genstr);
         csound->Free(csound, ftp->ftable);
         csound->Free(csound, (void*) ftp);             /*   release old space   */
         csound->flist[ff->fno] = ftp = NULL;
@@ -2382,6 +2471,7 @@ static CS_NOINLINE FUNC *ftalloc(const FGDATA *ff)
       else {
                                     /* else clear it to zero */
         MYFLT *tmp = ftp->ftable;
+        csound->Free(csound, ftp->genstr);
         memset((void*) ftp->ftable, 0, sizeof(MYFLT)*(ff->flen+1));
         memset((void*) ftp, 0, sizeof(FUNC));
         ftp->ftable = tmp; /* restore table pointer */
@@ -3474,6 +3564,9 @@ int resize_table(CSOUND *csound, RESIZE *p)
     }
     if (UNLIKELY((ftp = csound->FTFind(csound, p->fn)) == NULL))
       return NOTOK;
+    if (UNLIKELY(ftshared(csound, ftp)))
+      return csound->InitError(csound, Str("resize: table %d is shared "
+                                           "with a template"), fno);
     if (ftp->flen<fsize)
       ftp->ftable = (MYFLT *) csound->ReAlloc(csound, ftp->ftable,
                                               sizeof(MYFLT)*(fsize+1));
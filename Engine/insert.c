@@ -33,6 +33,7 @@
 #include "interlocks.h"
 #include "csound_type_system.h"
 #include "csound_standard_types.h"
+#include "twheel.h"
 #include <inttypes.h>
 
 static  void    showallocs(CSOUND *);
@@ -42,7 +43,7 @@ void    beatexpire(CSOUND *, double);
 void    timexpire(CSOUND *, double);
 static  void    instance(CSOUND *, int);
 extern int argsRequired(char* argString);
-static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn,
+static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, uint32 ofs,
                        MEVENT *mep);
 static int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp);
 
@@ -205,7 +206,8 @@ uintptr_t event_insert_thread(void *p) {
         }
         if(inst[rp].type == 1) {
           csoundSpinLock(&csound->alloc_spinlock);
-          insert_midi(csound, inst[rp].insno, inst[rp].chn, &inst[rp].mep);
+          insert_midi(csound, inst[rp].insno, inst[rp].chn,
+                      inst[rp].ksmps_offset, &inst[rp].mep);
           csoundSpinUnLock(&csound->alloc_spinlock);
         }
        if(inst[rp].type == 0)  {
@@ -398,9 +400,11 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     ip->onedkr = csound->onedkr;
     ip->kicvt = csound->kicvt;
     ip->pds = NULL;
+    ip->outms = ip->outacc = FL(0.0);
     /* Add an active instrument */
     tp->active++;
     tp->instcnt++;
+    ip->voiceno = (uint32) tp->instcnt;
     csound->dag_changed++;      /* Need to remake DAG */
     nxtp = &(csound->actanchor);    /* now splice into activ lst */
     while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
@@ -573,7 +577,60 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
 
 /* insert a MIDI instr copy into active list */
 /*  then run an init pass                    */
+/* Free a voice of instrument tp for a new MIDI note, as set by maxalloc:
+   the victim is faded out over tp->stealfade seconds by the out opcodes
+   and then deactivated, going back to the free instance chain for the
+   next note.  With no fade it is turned off at once, and the new note
+   takes over its INSDS.  Returns zero if no voice could be stolen. */
+
+static int steal_voice(CSOUND *csound, INSTRTXT *tp, MCHNBLK *chn,
+                       MEVENT *mep)
+{
+  INSDS   *ip, *victim = NULL;
+  int     ncyc;
+
+  for (ip = tp->instance; ip != NULL; ip = ip->nxtinstance) {
+    if (!ip->actflg || ip->stealcyc)
+      continue;                         /* free, or already fading out */
+    if (tp->steal == VOICE_STEAL_SAMENOTE &&
+        ip->m_chnbp == chn && ip->m_pitch == (unsigned char) mep->dat1) {
+      victim = ip;
+      break;
+    }
+    if (victim == NULL ||
+        (tp->steal == VOICE_STEAL_QUIETEST ?
+         (ip->outms < victim->outms ||
+          (ip->outms == victim->outms && ip->voiceno < victim->voiceno)) :
+         ip->voiceno < victim->voiceno))
+      victim = ip;
+  }
+  if (victim == NULL)
+    return 0;
+  if (UNLIKELY(csound->oparms->odebug))
+    csound->Message(csound, Str("stealing voice %u of instr %d\n"),
+                    victim->voiceno, (int) victim->insno);
+  /* xtratim and the fade count the victim's own (local ksmps) cycles */
+  ncyc = (int) (tp->stealfade * csound->esr / victim->ksmps + FL(0.5));
+  if (ncyc < 1) {
+    xturnoff_now(csound, victim);
+    return 1;
+  }
+  /* release for exactly the fade time, even if already releasing */
+  if (victim->relesing) {
+    csound->engineState.instrtxtp[victim->insno]->pending_release--;
+    victim->relesing = 0;
+  }
+  victim->xtratim = ncyc;
+  victim->stealcyc = (uint32) ncyc;
+  victim->stealkcnt = victim->kcounter;
+  tp->stolen++;
+  xturnoff(csound, victim);
+  return 1;
+}
+
 int MIDIinsert(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep) {
+  /* sample offset of the note on, from a timestamped driver */
+  uint32 ofs = csound->midiGlobals->ksmps_offset;
 
   if(csound->oparms->realtime) {
     unsigned long wp = csound->alloc_queue_wp;
@@ -581,15 +638,17 @@ int MIDIinsert(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep) {
     csound->alloc_queue[wp].chn = chn;
     csound->alloc_queue[wp].mep = *mep;
     csound->alloc_queue[wp].type = 1;
+    csound->alloc_queue[wp].ksmps_offset = ofs;
     csound->alloc_queue_wp = wp + 1 < MAX_ALLOC_QUEUE ? wp + 1 : 0;
     ATOMIC_INCR(csound->alloc_queue_items);
     return 0;
   }
-  else return insert_midi(csound, insno, chn, mep);
+  else return insert_midi(csound, insno, chn, ofs, mep);
 
 }
 
-int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
+int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, uint32 ofs,
+                MEVENT *mep)
 {
   INSTRTXT  *tp;
   INSDS     *ip, **ipp, *prvp, *nxtp;
@@ -614,10 +673,13 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
       return(0);
     }
   }
-  if (UNLIKELY(tp->maxalloc > 0 && tp->active >= tp->maxalloc)) {
-    csoundWarning(csound, Str("cannot allocate last note because it exceeds "
-                              "instr maxalloc"));
-    return(0);
+  if (UNLIKELY(tp->maxalloc > 0 &&
+               tp->active - tp->stolen >= tp->maxalloc)) {
+    if (tp->steal == VOICE_STEAL_NONE || !steal_voice(csound, tp, chn, mep)) {
+      csoundWarning(csound, Str("cannot allocate last note because it "
+                                "exceeds instr maxalloc"));
+      return(0);
+    }
   }
   tp->active++;
   tp->instcnt++;
@@ -648,6 +710,8 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ATOMIC_SET(ip->init_done, 0);
   tp->act_instance = ip->nxtact;
   ip->insno = (int16) insno;
+  ip->voiceno = (uint32) tp->instcnt;
+  ip->outms = ip->outacc = FL(0.0);
 
   if (UNLIKELY(O->odebug))
     csound->Message(csound, "Now %d active instr %d\n", tp->active, insno);
@@ -686,8 +750,12 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ip->offtim       = -1.0;              /* set indef duration */
   ip->opcod_iobufs = NULL;              /* IV - Sep 8 2002:            */
   ip->p1.value     = (MYFLT) insno;     /* set these required p-fields */
-  ip->p2.value     = (MYFLT) (csound->icurTime/csound->esr - csound->timeOffs);
+  ip->p2.value     = (MYFLT) ((csound->icurTime + ofs)/csound->esr
+                              - csound->timeOffs);
   ip->p3.value     = FL(-1.0);
+  ip->ksmps_offset = ofs;               /* 0 unless timestamped */
+  ip->ksmps_no_end = 0;
+  ip->no_end       = 0;
   ip->ksmps        = csound->ksmps;
   ip->ekr          = csound->ekr;
   ip->kcounter     = csound->kcounter;
@@ -854,14 +922,81 @@ static void showallocs(CSOUND *csound)      /* debugging aid */
     }
 }
 
-static void schedofftim(CSOUND *csound, INSDS *ip)
-{                               /* put an active instr into offtime list  */
-  INSDS *prvp, *nxtp;         /* called by insert() & midioff + xtratim */
+/* k-cycle of a turnoff time, the key used by the timing wheel */
+static inline uint32 offkcnt(CSOUND *csound, double t)
+{
+  double  k = t * csound->ekr;
+  return (k <= 0.0 ? 0U : k >= 4294967295.0 ? 0xFFFFFFFFU : (uint32) k);
+}
+
+/* In time mode, turnoffs not due in the current k-cycle are parked in a
+   timing wheel instead of being sorted into the frstoff chain; they are
+   moved to the chain by timexpire() when their k-cycle comes round.
+   Returns non-zero if ip went into the wheel. */
+
+static int offwheel_insert(CSOUND *csound, INSDS *ip)
+{
+  double  tval = (csound->icurTime + (0.505 * csound->ksmps))/csound->esr;
+
+  ip->offkcnt = offkcnt(csound, ip->offtim);
+  if (ip->offtim <= tval)
+    return 0;
+  if (csound->offWheel == NULL)
+    csound->offWheel = twheel_create(csound, offsetof(INSDS, nxtoff),
+                                     offsetof(INSDS, prvoff),
+                                     offsetof(INSDS, offkcnt));
+  if (!csound->offWheel->count &&
+      csound->offWheel->cursor < (uint64_t) offkcnt(csound, tval))
+    csound->offWheel->cursor = offkcnt(csound, tval);   /* catch up */
+  if ((uint64_t) ip->offkcnt < csound->offWheel->cursor)
+    return 0;
+  twheel_insert(csound->offWheel, ip);
+  return 1;
+}
+
+/* link into the frstoff chain, sorted by offtim; returns non-zero if
+   ip became the head */
+
+static int offtim_link(CSOUND *csound, INSDS *ip)
+{
+  INSDS *prvp, *nxtp;
 
   if ((nxtp = csound->frstoff) == NULL ||
       nxtp->offtim > ip->offtim) {            /*   set into       */
     csound->frstoff = ip;                     /*   firstoff chain */
     ip->nxtoff = nxtp;
+    return 1;
+  }
+  while ((prvp = nxtp)
+         && (nxtp = nxtp->nxtoff) != NULL
+         && ip->offtim >= nxtp->offtim);
+  prvp->nxtoff = ip;
+  ip->nxtoff = nxtp;
+  return 0;
+}
+
+/* earliest pending turnoff, or NULL if there is none */
+
+INSDS *first_offtim(CSOUND *csound)
+{
+  INSDS *ip, *p;
+
+  if (csound->frstoff != NULL || csound->offWheel == NULL)
+    return csound->frstoff;
+  /* the chain ahead of the wheel is empty: look at its earliest slot */
+  for (ip = p = (INSDS*) twheel_peek(csound->offWheel); p != NULL;
+       p = p->nxtoff)
+    if (p->offtim < ip->offtim)
+      ip = p;
+  return ip;
+}
+
+static void schedofftim(CSOUND *csound, INSDS *ip)
+{                               /* put an active instr into offtime list  */
+                                /* called by insert() & midioff + xtratim */
+  if (!csound->oparms_.Beatmode && offwheel_insert(csound, ip))
+    return;
+  if (offtim_link(csound, ip)) {
     /* IV - Feb 24 2006: check if this note already needs to be turned off */
     /* the following comparisons must match those in sensevents() */
 #ifdef BETA
@@ -887,13 +1022,6 @@ static void schedofftim(CSOUND *csound, INSDS *ip)
                                     (0.505 * csound->ksmps))/csound->esr));
 #endif
   }
-  else {
-    while ((prvp = nxtp)
-           && (nxtp = nxtp->nxtoff) != NULL
-           && ip->offtim >= nxtp->offtim);
-    prvp->nxtoff = ip;
-    ip->nxtoff = nxtp;
-  }
 }
 
 /* csound.c */
@@ -909,6 +1037,10 @@ static void deact(CSOUND *csound, INSDS *ip)
     csoundDeinitialiseOpcodes(csound, ip);
   /* remove an active instrument */
   csound->engineState.instrtxtp[ip->insno]->active--;
+  if (ip->stealcyc) {                   /* end of a stolen voice's fade */
+    csound->engineState.instrtxtp[ip->insno]->stolen--;
+    ip->stealcyc = 0;
+  }
   if (ip->xtratim > 0)
     csound->engineState.instrtxtp[ip->insno]->pending_release--;
   csound->cpu_power_busy -= csound->engineState.instrtxtp[ip->insno]->cpuload;
@@ -985,8 +1117,10 @@ void xturnoff(CSOUND *csound, INSDS *ip)  /* turnoff a particular insalloc  */
       }
     }
   }
-  /* remove from schedoff chain first if finite duration */
-  if (csound->frstoff != NULL && ip->offtim >= 0.0) {
+  /* remove from timing wheel or schedoff chain first if finite duration */
+  if (ip->offtim >= 0.0 &&
+      (csound->offWheel == NULL || !twheel_remove(csound->offWheel, ip)) &&
+      csound->frstoff != NULL) {
     INSDS *prvip;
     prvip = csound->frstoff;
     if (prvip == ip)
@@ -1780,8 +1914,17 @@ void beatexpire(CSOUND *csound, double beat)
 
 void timexpire(CSOUND *csound, double time)
 {
-  INSDS  *ip;
+  INSDS  *ip, *nxt;
 
+  /* bring turnoffs falling due from the timing wheel into frstoff */
+  if (csound->offWheel != NULL && csound->offWheel->count) {
+    ip = (INSDS*) twheel_advance(csound->offWheel,
+                                 offkcnt(csound, time), NULL);
+    for ( ; ip != NULL; ip = nxt) {
+      nxt = ip->nxtoff;
+      offtim_link(csound, ip);
+    }
+  }
  strt:
   if ((ip = csound->frstoff) != NULL && ip->offtim <= time) {
     do {
@@ -1849,7 +1992,7 @@ int subinstr(CSOUND *csound, SUBINST *p)
     if ((CS_PDS = (OPDS *) (ip->nxtp)) != NULL) {
       CS_PDS->insdshead->pds = NULL;
       do {
-        error = (*CS_PDS->opadr)(csound, CS_PDS);
+        error = (*CS_GENERIC_PERF(CS_PDS))(csound, CS_PDS);
         if (CS_PDS->insdshead->pds != NULL) {
           CS_PDS = CS_PDS->insdshead->pds;
           CS_PDS->insdshead->pds = NULL;
@@ -1891,7 +2034,7 @@ int subinstr(CSOUND *csound, SUBINST *p)
             memset(p->ar, 0, sizeof(MYFLT)*CS_KSMPS*p->OUTCOUNT);
             goto endin;
           }
-          error = (*CS_PDS->opadr)(csound, CS_PDS);
+          error = (*CS_GENERIC_PERF(CS_PDS))(csound, CS_PDS);
           if (CS_PDS->insdshead->pds != NULL) {
             CS_PDS = CS_PDS->insdshead->pds;
             CS_PDS->insdshead->pds = NULL;
@@ -2008,7 +2151,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
         CS_PDS->insdshead->pds = NULL;
         do {
           if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-          error = (*CS_PDS->opadr)(csound, CS_PDS);
+          error = (*CS_GENERIC_PERF(CS_PDS))(csound, CS_PDS);
           if (CS_PDS->insdshead->pds != NULL &&
               CS_PDS->insdshead->pds->insdshead) {
             CS_PDS = CS_PDS->insdshead->pds;
@@ -2118,7 +2261,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
         CS_PDS->insdshead->pds = NULL;
         do {
           if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-          error = (*CS_PDS->opadr)(csound, CS_PDS);
+          error = (*CS_GENERIC_PERF(CS_PDS))(csound, CS_PDS);
           if (CS_PDS->insdshead->pds != NULL &&
               CS_PDS->insdshead->pds->insdshead) {
             CS_PDS = CS_PDS->insdshead->pds;
@@ -2288,7 +2431,7 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
   CS_PDS->insdshead->pds = NULL;
   do {
     if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-    error = (*CS_PDS->opadr)(csound, CS_PDS);
+    error = (*CS_GENERIC_PERF(CS_PDS))(csound, CS_PDS);
     if (CS_PDS->insdshead->pds != NULL &&
         CS_PDS->insdshead->pds->insdshead) {
       CS_PDS = CS_PDS->insdshead->pds;
@@ -2490,7 +2633,8 @@ static void instance(CSOUND *csound, int insno)
       prvpds = prvpds->nxtp = opds;           /* link into pchain */
       /* if (!(n & 04) || */
       /*     ((ttp->pftype == 'k' || ttp->pftype == 'c') && ep->kopadr != NULL)) */
-        opds->opadr = ep->kopadr;             /*      krate or    */
+        opds->opadr = ttp->perf != NULL ?     /*      krate or    */
+          ttp->perf : ep->kopadr;
       /* else opds->opadr = ep->aopadr;          /\*      arate       *\/ */
       if (UNLIKELY(odebug))
         csound->Message(csound, "opadr = %p\n", (void*) opds->opadr);
@@ -30,6 +30,7 @@
 #include "remote.h"
 #include <math.h>
 #include "corfile.h"
+#include "twheel.h"
 
 #include "csdebug.h"
 
@@ -43,6 +44,7 @@ int     MIDIinsert(CSOUND *, int, MCHNBLK*, MEVENT*);
 //  char *  scsortstr(CSOUND *, CORFIL *);
   void    infoff(CSOUND*, MYFLT), orcompact(CSOUND*);
   void    beatexpire(CSOUND *, double), timexpire(CSOUND *, double);
+  INSDS   *first_offtim(CSOUND *);
   void    sfopenin(CSOUND *), sfopenout(CSOUND*), sfnopenout(CSOUND*);
   void    iotranset(CSOUND *), sfclosein(CSOUND*), sfcloseout(CSOUND*);
   void    MidiClose(CSOUND *);
@@ -438,10 +440,48 @@ static void deactivate_all_notes(CSOUND *csound)
     }
 }
 
-static void delete_pending_rt_events(CSOUND *csound)
+/* are there notes waiting for their turnoff time? */
+static inline int turnoffs_pending(CSOUND *csound)
+{
+  return (csound->frstoff != NULL ||
+          (csound->offWheel != NULL && csound->offWheel->count));
+}
+
+/* Realtime events due in the current or an earlier k-cycle are kept in
+   the sorted OrcTrigEvts list; later ones wait in csound->evtWheel, a
+   timing wheel (see twheel.h) that makes queueing O(1) however many
+   events are pending.  Move the events that have fallen due to the
+   end of OrcTrigEvts; they sort after everything already there. */
+
+static void rt_events_due(CSOUND *csound)
 {
-  EVTNODE *ep = csound->OrcTrigEvts;
+  EVTNODE *e, *prv;
+
+  e = (EVTNODE*) twheel_advance(csound->evtWheel,
+                                (uint32) csound->global_kcounter, NULL);
+  if (e == NULL)
+    return;
+  if ((prv = csound->OrcTrigEvts) == NULL)
+    csound->OrcTrigEvts = e;
+  else {
+    while (prv->nxt != NULL)
+      prv = prv->nxt;
+    prv->nxt = e;
+  }
+}
 
+static void delete_pending_rt_events(CSOUND *csound)
+{
+  EVTNODE *ep, *tail;
+
+  /* collect any events still waiting in the timing wheel first */
+  if (csound->evtWheel != NULL &&
+      (ep = (EVTNODE*) twheel_drain(csound->evtWheel, (void**) &tail))
+      != NULL) {
+    tail->nxt = csound->OrcTrigEvts;
+    csound->OrcTrigEvts = ep;
+  }
+  ep = csound->OrcTrigEvts;
   while (ep != NULL) {
     EVTNODE *nxt = ep->nxt;
     if (ep->evt.strarg != NULL) {
@@ -458,8 +498,16 @@ static void delete_pending_rt_events(CSOUND *csound)
 
 void delete_selected_rt_events(CSOUND *csound, MYFLT instr)
 {
-  EVTNODE *ep = csound->OrcTrigEvts;
-  EVTNODE *last = NULL;
+  EVTNODE *ep, *last = NULL, *wp = NULL;
+
+  /* take the events out of the timing wheel, and put back the ones kept */
+  if (csound->evtWheel != NULL) {
+    wp = (EVTNODE*) twheel_drain(csound->evtWheel, (void**) &last);
+    if (wp != NULL)
+      last->nxt = NULL;
+  }
+  ep = csound->OrcTrigEvts;
+  last = NULL;
   while (ep != NULL) {
     EVTNODE *nxt = ep->nxt;
     //printf("*** delete_selected_rt_events: instr = %f, p[1] = %f\n",
@@ -481,6 +529,21 @@ void delete_selected_rt_events(CSOUND *csound, MYFLT instr)
     else last = ep;
     ep = nxt;
   }
+  while (wp != NULL) {
+    EVTNODE *nxt = wp->nxt;
+    if (wp->evt.opcod=='i' &&
+        (((int)(wp->evt.p[1]) == instr) || (wp->evt.p[1] == instr))) {
+      if (wp->evt.strarg != NULL) {
+        csound->Free(csound,wp->evt.strarg);
+        wp->evt.strarg = NULL;
+      }
+      wp->nxt = csound->freeEvtNodes;
+      csound->freeEvtNodes = wp;
+    }
+    else
+      twheel_insert(csound->evtWheel, wp);
+    wp = nxt;
+  }
   //csound->OrcTrigEvts = NULL;
 }
 
@@ -496,6 +559,8 @@ PUBLIC int csoundCleanup(CSOUND *csound)
     int32   *rngp;
     uint32_t n;
 
+    /* the look-ahead thread needs the API lock to finish */
+    csoundLookAheadStop(csound);
     csoundLockMutex(csound->API_lock);
     if (csound->QueryGlobalVariable(csound,"::UDPCOM")
         != NULL) csoundUDPServerClose(csound);
@@ -524,6 +589,8 @@ PUBLIC int csoundCleanup(CSOUND *csound)
         csound->engineState.instrtxtp[0]->instance->actflg)
       xturnoff_now(csound, csound->engineState.instrtxtp[0]->instance);
     delete_pending_rt_events(csound);
+    /* finish stemout files */
+    stems_close(csound);
 
 #ifndef __EMSCRIPTEN__
     if (csound->event_insert_loop == 1) {
@@ -543,6 +610,7 @@ PUBLIC int csoundCleanup(CSOUND *csound)
     orcompact(csound);
 
     corfile_rm(csound, &csound->scstr);
+    scorebin_close(csound);
 
     /* print stats only if musmon was actually run */
     /* NOT SURE HOW   ************************** */
@@ -775,6 +843,14 @@ static int process_score_event(CSOUND *csound, EVTBLK *evt, int rtEvt)
       xturnoff_now(csound, csound->frstoff);
       csound->frstoff = nxt;
     }
+    if (csound->offWheel != NULL) {
+      INSDS *ip = (INSDS*) twheel_drain(csound->offWheel, NULL);
+      while (ip != NULL) {
+        INSDS *nxt = ip->nxtoff;
+        xturnoff_now(csound, ip);
+        ip = nxt;
+      }
+    }
     csound->currevent = saved_currevent;
     return (evt->opcod == 'l' ? 3 : (evt->opcod == 's' ? 1 : 2));
   case 'q':
@@ -1015,7 +1091,7 @@ int sensevents(CSOUND *csound)
   }
   /* if turnoffs pending, remove any expired instrs */
   RT_SPIN_TRYLOCK
-  if (UNLIKELY(csound->frstoff != NULL)) {
+  if (UNLIKELY(turnoffs_pending(csound))) {
     double  tval;
     /* the following comparisons must match those in schedofftim() */
     if (O->Beatmode) {
@@ -1024,7 +1100,8 @@ int sensevents(CSOUND *csound)
     }
     else {
       tval = ((double)csound->icurTime + csound->ksmps * 0.505)/csound->esr;
-      if (csound->frstoff->offtim <= tval)
+      if (csound->frstoff == NULL || csound->frstoff->offtim <= tval ||
+          csound->offWheel != NULL)
         timexpire(csound, tval);
     }
   }
@@ -1055,12 +1132,12 @@ int sensevents(CSOUND *csound)
       case 'e':                     /* end of score, */
       case 'l':                     /* lplay list,   */
       case 's':                     /* or section:   */
-        if (csound->frstoff != NULL) {    /* if still have notes
+        if (turnoffs_pending(csound)) {   /* if still have notes
                                              with finite length, wait
                                              until all are turned off */
           RT_SPIN_TRYLOCK
-          csound->nxtim = csound->frstoff->offtim;
-          csound->nxtbt = csound->frstoff->offbet;
+          csound->nxtim = first_offtim(csound)->offtim;
+          csound->nxtbt = first_offtim(csound)->offbet;
           RT_SPIN_UNLOCK
           break;
         }
@@ -1167,6 +1244,8 @@ int sensevents(CSOUND *csound)
     }
 
     /* check for pending real time events */
+    if (csound->evtWheel != NULL)
+      rt_events_due(csound);
     while (csound->OrcTrigEvts != NULL &&
            csound->OrcTrigEvts->start_kcnt <=
            (uint32) csound->global_kcounter) {
@@ -1430,9 +1509,17 @@ int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
   }
   /* queue new event */
   e->start_kcnt = start_kcnt;
+  if (csound->evtWheel == NULL)
+    csound->evtWheel = twheel_create(csound, offsetof(EVTNODE, nxt),
+                                     TW_NOPRV, offsetof(EVTNODE, start_kcnt));
+  if (!csound->evtWheel->count &&
+      csound->evtWheel->cursor < (uint64_t) csound->global_kcounter)
+    csound->evtWheel->cursor = csound->global_kcounter;   /* catch up */
   prv = csound->OrcTrigEvts;
+  if ((uint64_t) start_kcnt >= csound->evtWheel->cursor)
+    twheel_insert(csound->evtWheel, e);       /* future event: O(1) */
   /* if list is empty, or at beginning of list: */
-  if (prv == NULL || start_kcnt < prv->start_kcnt) {
+  else if (prv == NULL || start_kcnt < prv->start_kcnt) {
     e->nxt = prv;
     csound->OrcTrigEvts = e;
   }
@@ -1471,6 +1558,11 @@ void musmon_rewind_score(CSOUND *csound)
   deactivate_all_notes(csound);
   /* flush any pending real time events */
   delete_pending_rt_events(csound);
+  /* both timing wheels are empty now: restart them at time zero */
+  if (csound->evtWheel != NULL)
+    csound->evtWheel->cursor = 0;
+  if (csound->offWheel != NULL)
+    csound->offWheel->cursor = 0;
 
   if (csound->global_kcounter != 0L) {
     /* reset score time */
@@ -1499,7 +1591,9 @@ void musmon_rewind_score(CSOUND *csound)
   csound->advanceCnt = 0;
   if (csound->csoundScoreOffsetSeconds_ > FL(0.0))
     csoundSetScoreOffsetSeconds(csound, csound->csoundScoreOffsetSeconds_);
-  if (csound->scstr)
+  if (csound->scoreBin)
+    scorebin_rewind(csound);
+  else if (csound->scstr)
     corfile_rewind(csound->scstr);
   else csound->Warning(csound, Str("cannot rewind score: no score in memory\n"));
 }
@@ -0,0 +1,263 @@
+/*
+    scorebin.c:
+
+    Copyright (C) 2021 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"                                 /*  SCOREBIN.C  */
+#include "corfile.h"
+
+/* Binary sorted scores (.bsc).
+
+   A .bsc file holds the output of the score sorter as a sequence of
+   ready-made EVTBLK records, already sorted and time warped, so that
+   performance can start without reading, sorting or re-parsing the
+   text score.  Records are read one at a time as sensevents() asks for
+   them, so start-up time and memory do not depend on the score length.
+
+   Layout (native byte order, checked by the header):
+     header:   "CSBSCORE", uint32 version, uint32 byte order mark
+     records:  SCOREBIN_REC
+               double  p2orig, p3orig
+               double  p[1] ... p[np]
+               double  c.extra[0] ... c.extra[nx-1]   (extra p-fields)
+               char    strings[nstr]   (the event's strarg block: scnt
+                                        NUL terminated strings)        */
+
+#define SCOREBIN_MAGIC    "CSBSCORE"
+#define SCOREBIN_VERSION  1
+#define SCOREBIN_BOM      0x01020304U
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t bom;
+} SCOREBIN_HDR;
+
+typedef struct {
+    char     opcod;
+    char     pad[3];
+    int32_t  pcnt;              /* EVTBLK pcnt, including extra p-fields */
+    int32_t  np;                /* p-fields stored from p[1]             */
+    int32_t  nx;                /* values stored from c.extra            */
+    int32_t  scnt;              /* strings in the string block           */
+    int32_t  nstr;              /* bytes in the string block             */
+} SCOREBIN_REC;
+
+typedef struct scorebin {
+    void    *fd;
+    FILE    *fp;
+    long    start;              /* offset of the first record */
+    double  *buf;
+    int32_t bufsiz;
+} SCOREBIN;
+
+static int scorebin_putvals(const MYFLT *v, int32_t n, FILE *out)
+{
+    while (n-- > 0) {
+      double  d = (double) *v++;
+      if (UNLIKELY(fwrite(&d, sizeof(double), 1, out) != 1))
+        return -1;
+    }
+    return 0;
+}
+
+/* Write the sorted score in csound->scstr to 'out' as a binary score.
+   Returns zero on success. */
+
+int scorebin_write(CSOUND *csound, FILE *out)
+{
+    SCOREBIN_HDR  h;
+    SCOREBIN_REC  r;
+    EVTBLK        e;
+    int           pending = csound->csoundIsScorePending_;
+
+    memset(&h, 0, sizeof(SCOREBIN_HDR));
+    memcpy(h.magic, SCOREBIN_MAGIC, 8);
+    h.version = SCOREBIN_VERSION;
+    h.bom = SCOREBIN_BOM;
+    if (UNLIKELY(fwrite(&h, sizeof(SCOREBIN_HDR), 1, out) != 1))
+      return CSOUND_ERROR;
+    memset(&e, 0, sizeof(EVTBLK));
+    csound->csoundIsScorePending_ = 1;  /* rdscor() would mute i-events */
+    csound->warped = 0;
+    while (rdscor(csound, &e)) {
+      MYFLT   orig[2];
+      memset(&r, 0, sizeof(SCOREBIN_REC));
+      r.opcod = e.opcod;
+      r.pcnt = e.pcnt;
+      r.np = (e.pcnt < PMAX ? e.pcnt : PMAX);
+      r.nx = (e.pcnt > PMAX && e.c.extra != NULL ?
+              (int32_t) e.c.extra[0] + 1 : 0);
+      if (e.strarg != NULL) {
+        const char *s = e.strarg;
+        int32_t n = e.scnt;
+        while (n-- > 0) s += strlen(s) + 1;
+        r.scnt = e.scnt;
+        r.nstr = (int32_t) (s - e.strarg);
+      }
+      orig[0] = e.p2orig; orig[1] = e.p3orig;
+      if (UNLIKELY(fwrite(&r, sizeof(SCOREBIN_REC), 1, out) != 1 ||
+                   scorebin_putvals(orig, 2, out) != 0 ||
+                   scorebin_putvals(&e.p[1], r.np, out) != 0 ||
+                   scorebin_putvals(e.c.extra, r.nx, out) != 0 ||
+                   (r.nstr > 0 &&
+                    fwrite(e.strarg, 1, r.nstr, out) != (size_t) r.nstr))) {
+        csound->csoundIsScorePending_ = pending;
+        return CSOUND_ERROR;
+      }
+      if (e.strarg != NULL) {
+        csound->Free(csound, e.strarg);
+        e.strarg = NULL;
+      }
+      if (e.opcod == 'e')
+        break;
+    }
+    csound->Free(csound, e.c.extra);
+    csound->csoundIsScorePending_ = pending;
+    return (fflush(out) == 0 ? CSOUND_SUCCESS : CSOUND_ERROR);
+}
+
+/* Open a binary score for playback; returns zero on success. */
+
+int scorebin_open(CSOUND *csound, const char *name)
+{
+    SCOREBIN      *sb;
+    SCOREBIN_HDR  h;
+    FILE          *fp;
+    void          *fd;
+
+    fd = csound->FileOpen2(csound, &fp, CSFILE_STD, name, "rb",
+                           "SSDIR;INCDIR", CSFTYPE_SCORE, 0);
+    if (UNLIKELY(fd == NULL)) {
+      csound->ErrorMsg(csound, Str("cannot open binary score %s"), name);
+      return CSOUND_ERROR;
+    }
+    setvbuf(fp, NULL, _IOFBF, 65536);   /* before any other operation */
+    if (UNLIKELY(fread(&h, sizeof(SCOREBIN_HDR), 1, fp) != 1 ||
+                 memcmp(h.magic, SCOREBIN_MAGIC, 8) != 0)) {
+      csound->ErrorMsg(csound, Str("%s: not a binary score"), name);
+      csound->FileClose(csound, fd);
+      return CSOUND_ERROR;
+    }
+    if (UNLIKELY(h.version != SCOREBIN_VERSION || h.bom != SCOREBIN_BOM)) {
+      csound->ErrorMsg(csound, Str("%s: unsupported binary score version "
+                                   "or byte order"), name);
+      csound->FileClose(csound, fd);
+      return CSOUND_ERROR;
+    }
+    sb = (SCOREBIN*) csound->Calloc(csound, sizeof(SCOREBIN));
+    sb->fd = fd;
+    sb->fp = fp;
+    sb->start = ftell(fp);
+    csound->scoreBin = sb;
+    return CSOUND_SUCCESS;
+}
+
+void scorebin_rewind(CSOUND *csound)
+{
+    SCOREBIN  *sb = (SCOREBIN*) csound->scoreBin;
+    if (sb != NULL)
+      fseek(sb->fp, sb->start, SEEK_SET);
+}
+
+void scorebin_close(CSOUND *csound)
+{
+    SCOREBIN  *sb = (SCOREBIN*) csound->scoreBin;
+    if (sb == NULL)
+      return;
+    csound->FileClose(csound, sb->fd);
+    csound->Free(csound, sb->buf);
+    csound->Free(csound, sb);
+    csound->scoreBin = NULL;
+}
+
+/* Read the next event from the binary score; the counterpart of rdscor().
+   Returns 0 at the end of the file. */
+
+int scorebin_read(CSOUND *csound, EVTBLK *e)
+{
+    SCOREBIN      *sb = (SCOREBIN*) csound->scoreBin;
+    SCOREBIN_REC  r;
+    int32_t       i, n;
+
+    e->pinstance = NULL;
+    if (fread(&r, sizeof(SCOREBIN_REC), 1, sb->fp) != 1)
+      return 0;
+    if (UNLIKELY(r.pcnt < 0 || r.np != (r.pcnt < PMAX ? r.pcnt : PMAX) ||
+                 r.nx < 0 || r.nx > r.pcnt || (r.pcnt > PMAX) != (r.nx > 0) ||
+                 r.scnt < 0 || r.nstr < 0 || (r.scnt > 0) != (r.nstr > 0))) {
+      csound->Warning(csound, Str("corrupt binary score record"));
+      return 0;
+    }
+    n = 2 + r.np + r.nx;
+    if (n > sb->bufsiz) {
+      sb->buf = (double*) csound->ReAlloc(csound, sb->buf, n * sizeof(double));
+      sb->bufsiz = n;
+    }
+    if (UNLIKELY(fread(sb->buf, sizeof(double), n, sb->fp) != (size_t) n))
+      return 0;
+    e->opcod = r.opcod;
+    e->p2orig = (MYFLT) sb->buf[0];
+    e->p3orig = (MYFLT) sb->buf[1];
+    for (i = 0; i < r.np; i++)
+      e->p[i + 1] = (MYFLT) sb->buf[i + 2];
+    csound->Free(csound, e->c.extra);
+    e->c.extra = NULL;
+    if (r.nx > 0) {
+      e->c.extra = (MYFLT*) csound->Malloc(csound, r.nx * sizeof(MYFLT));
+      for (i = 0; i < r.nx; i++)
+        e->c.extra[i] = (MYFLT) sb->buf[i + 2 + r.np];
+      /* extra[0] counts the values after it */
+      if (UNLIKELY((int32_t) e->c.extra[0] + 1 != r.nx)) {
+        csound->Warning(csound, Str("corrupt binary score record"));
+        return 0;
+      }
+    }
+    e->strarg = NULL; e->scnt = 0;
+    if (r.nstr > 0) {
+      int32_t nul = 0;
+      e->strarg = (char*) csound->Malloc(csound, r.nstr + 1);
+      if (UNLIKELY(fread(e->strarg, 1, r.nstr, sb->fp) != (size_t) r.nstr)) {
+        csound->Free(csound, e->strarg);
+        e->strarg = NULL;
+        return 0;
+      }
+      e->strarg[r.nstr] = '\0';
+      for (i = 0; i < r.nstr; i++)
+        nul += (e->strarg[i] == '\0');
+      /* scnt strings, each NUL terminated */
+      if (UNLIKELY(nul != r.scnt || e->strarg[r.nstr - 1] != '\0')) {
+        csound->Warning(csound, Str("corrupt binary score record"));
+        csound->Free(csound, e->strarg);
+        e->strarg = NULL;
+        return 0;
+      }
+      e->scnt = r.scnt;
+    }
+    e->pcnt = r.pcnt;
+    if (!csound->csoundIsScorePending_ && e->opcod == 'i') {
+      /* as in rdscor(): mute notes while the score is not pending */
+      csound->Free(csound, e->strarg);
+      e->strarg = NULL;
+      e->opcod = 'f'; e->p[1] = FL(0.0); e->pcnt = 2; e->scnt = 0;
+    }
+    return 1;
+}
@@ -0,0 +1,227 @@
+/*
+    twheel.c:
+
+    Copyright (C) 2021 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"
+#include "twheel.h"
+
+#define TW_NXT(w, n)  (*(void**) ((char*) (n) + (w)->nxtofs))
+#define TW_PRV(w, n)  (*(void**) ((char*) (n) + (w)->prvofs))
+#define TW_KEY(w, n)  (*(uint32*) ((char*) (n) + (w)->keyofs))
+#define TW_PAGE(k)    ((uint64_t) (k) >> TW_L1BITS)
+#define TW_REV(k)     ((uint64_t) (k) >> (TW_L1BITS + TW_L2BITS))
+
+TWHEEL *twheel_create(CSOUND *csound, size_t nxtofs, size_t prvofs,
+                      size_t keyofs)
+{
+    TWHEEL  *w = (TWHEEL*) csound->Calloc(csound, sizeof(TWHEEL));
+    w->nxtofs = nxtofs;
+    w->prvofs = prvofs;
+    w->keyofs = keyofs;
+    return w;
+}
+
+static inline void tw_append(TWHEEL *w, TWSLOT *s, void *node)
+{
+    TW_NXT(w, node) = NULL;
+    if (w->prvofs != TW_NOPRV)
+      TW_PRV(w, node) = s->tail;
+    if (s->head == NULL)
+      s->head = node;
+    else
+      TW_NXT(w, s->tail) = node;
+    s->tail = node;
+}
+
+/* a node that has left the wheel links back to itself, so that
+   twheel_remove() can tell it is not held */
+static inline void tw_detach(TWHEEL *w, void *node)
+{
+    if (w->prvofs != TW_NOPRV)
+      TW_PRV(w, node) = node;
+}
+
+/* find the slot a key belongs to relative to the current cursor */
+static TWSLOT *tw_slot(TWHEEL *w, uint64_t k)
+{
+    if (k < w->cursor)
+      k = w->cursor;
+    if (TW_PAGE(k) == TW_PAGE(w->cursor))
+      return &(w->l1[k & (TW_L1SIZE - 1)]);
+    if (TW_REV(k) == TW_REV(w->cursor))
+      return &(w->l2[TW_PAGE(k) & (TW_L2SIZE - 1)]);
+    return &(w->ovfl);
+}
+
+static void tw_redistribute(TWHEEL *w, TWSLOT *s)
+{
+    void    *n = s->head, *nxt;
+    s->head = s->tail = NULL;
+    while (n != NULL) {
+      nxt = TW_NXT(w, n);
+      tw_append(w, tw_slot(w, TW_KEY(w, n)), n);
+      n = nxt;
+    }
+}
+
+void twheel_insert(TWHEEL *w, void *node)
+{
+    tw_append(w, tw_slot(w, TW_KEY(w, node)), node);
+    w->count++;
+}
+
+/* Expire every node with key <= kcnt.  Returns the expired nodes as one
+   chain in key order (FIFO among equal keys) and its last node in *tail. */
+
+void *twheel_advance(TWHEEL *w, uint32 kcnt, void **tail)
+{
+    void    *head = NULL, *last = NULL;
+
+    while (w->count && w->cursor <= (uint64_t) kcnt) {
+      TWSLOT  *s = &(w->l1[w->cursor & (TW_L1SIZE - 1)]);
+      if (s->head != NULL) {
+        void  *n = s->head;
+        if (head == NULL)
+          head = n;
+        else
+          TW_NXT(w, last) = n;
+        do {
+          w->count--;
+          tw_detach(w, n);
+          last = n;
+        } while ((n = TW_NXT(w, n)) != NULL);
+        s->head = s->tail = NULL;
+      }
+      if ((++w->cursor & (TW_L1SIZE - 1)) == 0) {
+        /* new page: cascade the overflow on a new revolution, then
+           spread the page's level 2 slot over level 1 */
+        if ((TW_PAGE(w->cursor) & (TW_L2SIZE - 1)) == 0)
+          tw_redistribute(w, &(w->ovfl));
+        tw_redistribute(w, &(w->l2[TW_PAGE(w->cursor) & (TW_L2SIZE - 1)]));
+      }
+    }
+    if (!w->count && w->cursor <= (uint64_t) kcnt)
+      w->cursor = (uint64_t) kcnt + 1;     /* nothing queued: jump ahead */
+    if (tail != NULL)
+      *tail = last;
+    return head;
+}
+
+/* Unlink a node still held by the wheel; returns zero if not found. */
+
+int twheel_remove(TWHEEL *w, void *node)
+{
+    TWSLOT  *s;
+    void    *n, *prv = NULL;
+
+    if ((uint64_t) TW_KEY(w, node) < w->cursor)
+      return 0;
+    s = tw_slot(w, TW_KEY(w, node));
+    if (w->prvofs != TW_NOPRV) {
+      /* a node never queued has no back link and is not a slot's head */
+      if ((prv = TW_PRV(w, node)) == node || (prv == NULL && s->head != node))
+        return 0;
+      n = TW_NXT(w, node);
+      if (prv == NULL)
+        s->head = n;
+      else
+        TW_NXT(w, prv) = n;
+      if (n == NULL)
+        s->tail = prv;
+      else
+        TW_PRV(w, n) = prv;
+      TW_NXT(w, node) = NULL;
+      tw_detach(w, node);
+      w->count--;
+      return 1;
+    }
+    for (n = s->head; n != NULL; prv = n, n = TW_NXT(w, n)) {
+      if (n == node) {
+        if (prv == NULL)
+          s->head = TW_NXT(w, n);
+        else
+          TW_NXT(w, prv) = TW_NXT(w, n);
+        if (s->tail == n)
+          s->tail = prv;
+        TW_NXT(w, n) = NULL;
+        w->count--;
+        return 1;
+      }
+    }
+    return 0;
+}
+
+/* Return the chain holding the earliest keys without removing it.  Only
+   a level 1 slot is sorted; callers wanting the minimum walk the chain. */
+
+void *twheel_peek(TWHEEL *w)
+{
+    uint64_t i;
+
+    if (!w->count)
+      return NULL;
+    for (i = w->cursor & (TW_L1SIZE - 1); i < TW_L1SIZE; i++)
+      if (w->l1[i].head != NULL)
+        return w->l1[i].head;
+    /* level 2 pages after the current one; none left on the last page */
+    for (i = (TW_PAGE(w->cursor) + 1) & (TW_L2SIZE - 1);
+         i != 0 && i < TW_L2SIZE; i++)
+      if (w->l2[i].head != NULL)
+        return w->l2[i].head;
+    return w->ovfl.head;
+}
+
+/* move the contents of slot s to the end of slot dst */
+static void tw_splice(TWHEEL *w, TWSLOT *dst, TWSLOT *s)
+{
+    if (s->head == NULL)
+      return;
+    if (dst->head == NULL)
+      dst->head = s->head;
+    else
+      TW_NXT(w, dst->tail) = s->head;
+    dst->tail = s->tail;
+    s->head = s->tail = NULL;
+}
+
+/* Empty the wheel, returning all nodes as one chain; nodes with equal
+   keys stay in insertion order. */
+
+void *twheel_drain(TWHEEL *w, void **tail)
+{
+    TWSLOT  all = { NULL, NULL };
+    void    *n;
+    uint64_t i;
+
+    for (i = w->cursor & (TW_L1SIZE - 1); i < TW_L1SIZE; i++)
+      tw_splice(w, &all, &(w->l1[i]));
+    for (i = (TW_PAGE(w->cursor) + 1) & (TW_L2SIZE - 1);
+         i != 0 && i < TW_L2SIZE; i++)
+      tw_splice(w, &all, &(w->l2[i]));
+    tw_splice(w, &all, &(w->ovfl));
+    w->count = 0;
+    for (n = all.head; n != NULL; n = TW_NXT(w, n))
+      tw_detach(w, n);
+    if (tail != NULL)
+      *tail = all.tail;
+    return all.head;
+}
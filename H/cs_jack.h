@@ -64,4 +64,10 @@ typedef struct RtJackGlobals_ {
     int     xrunFlag;                   /* non-zero if an xrun has occured  */
     jack_client_t   *listclient;
     int outDevNum, inDevNum;            /* select devs by number */
+    int     callbackMode;               /* perform in the process callback  */
+    volatile int cbRun;                 /* non-zero while Csound performs   */
+    int     cbFrames;                   /* current JACK period              */
+    int     cbInPos;                    /* frame position in port buffers   */
+    int     cbOutPos;
+    const CS_SAMPCONV *conv;            /* sample conversion routines       */
 } RtJackGlobals;
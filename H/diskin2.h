@@ -73,6 +73,7 @@ typedef struct {
     void    *cb;
     int     async;
   MYFLT     transpose;
+    void    *stream;            /* decode-ahead reader, or NULL */
 } DISKIN2;
 
 typedef struct {
@@ -115,6 +116,7 @@ typedef struct {
   MYFLT aOut_bufsize;
   void *cb;
   int  async;
+  void *stream;                 /* decode-ahead reader, or NULL */
 } DISKIN2_ARRAY;
 
 int diskin2_init(CSOUND *csound, DISKIN2 *p);
@@ -147,6 +149,7 @@ typedef struct {
 typedef struct {
     SNDFILE *sf;
     void    *fd;
+    int     async;              /* written by the I/O thread */
     MYFLT   *outbufp, *bufend;
     MYFLT   outbuf[SNDOUTSMPS];
 } SNDCOM;
@@ -241,6 +241,46 @@ extern "C" {
 
   int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence);
 
+  void *csoundSndfileOpenAsync(CSOUND *csound, void *sf, const char *name,
+                               int type, int nchnls, int rewrite);
+
+  int csoundSndfileWriteAsync(CSOUND *csound, void *handle,
+                              const void *buf, int nsmps);
+
+  void csoundSndfileCloseAsync(CSOUND *csound, void *handle);
+
+  void *csoundStreamOpen(CSOUND *csound, const char *name, int nchnls,
+                         int64_t length, int frames,
+                         int (*read)(void *, MYFLT *, int),
+                         int (*seek)(void *, int64_t), void *data, int flags);
+
+  void *csoundSndfileStreamOpen(CSOUND *csound, void *sf, const char *name,
+                                int nchnls, int64_t length, int frames,
+                                int flags);
+
+  int csoundStreamRead(CSOUND *csound, void *handle, int64_t frame,
+                       MYFLT *buf, int nframes);
+
+  void csoundStreamSeek(CSOUND *csound, void *handle, int64_t frame);
+
+  void csoundStreamClose(CSOUND *csound, void *handle);
+
+  void *csoundCaptureOpen(CSOUND *csound, const char *name, void *sfinfo);
+
+  void csoundCaptureWrite(CSOUND *csound, void *handle, int nframes);
+
+  void csoundCaptureMarker(CSOUND *csound, void *handle, int64_t sample,
+                           const char *label);
+
+  void csoundCaptureClose(CSOUND *csound, void *handle, int discard);
+
+  int csoundCaptureInfo(CSOUND *csound, const char *name, void *sfinfo);
+
+  void csoundFileCaptureWrite(CSOUND *csound, void *fd, int nframes);
+
+  int csoundFileCaptureMarker(CSOUND *csound, void *fd, int64_t sample,
+                              const char *label);
+
 
 #ifdef __cplusplus
 }
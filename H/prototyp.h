@@ -58,10 +58,24 @@ TEXT    *getoptxt(CSOUND *, int *);
 void    reverbinit(CSOUND *);
 void    dispinit(CSOUND *);
 int     init0(CSOUND *);
+SUBR    aops_ksmps_variant(SUBR, uint32_t);
+/* The perf function of an opcode for an instance that is not on the fast
+   path (a local ksmps, or sample-accurate offsets pending): a variant
+   bound for the global ksmps (TEXT.perf) handles neither, so its general
+   function is used instead.  Only the perf loops in kperf and nodePerf
+   run an instrument's opadr as is, after testing the instance once. */
+#define CS_GENERIC_PERF(o)                                              \
+    ((o)->opadr == (o)->optext->t.perf ?                                \
+     (SUBR) (o)->optext->t.oentry->kopadr : (o)->opadr)
 void    scsort(CSOUND *, FILE *, FILE *);
 char    *scsortstr(CSOUND *, CORFIL *);
 int     scxtract(CSOUND *, CORFIL *, FILE *);
 int     rdscor(CSOUND *, EVTBLK *);
+int     scorebin_write(CSOUND *, FILE *);
+int     scorebin_open(CSOUND *, const char *);
+int     scorebin_read(CSOUND *, EVTBLK *);
+void    scorebin_rewind(CSOUND *);
+void    scorebin_close(CSOUND *);
 int     musmon(CSOUND *);
 void    RTLineset(CSOUND *);
 FUNC    *csoundFTFind(CSOUND *, MYFLT *);
@@ -94,6 +108,14 @@ MEMFIL  *ldmemfile2withCB(CSOUND *csound, const char *filnam, int csFileType,
 void    rlsmemfiles(CSOUND *);
 int     delete_memfile(CSOUND *, const char *);
 char    *csoundTmpFileName(CSOUND *, const char *);
+int     csoundRenderParallel(CSOUND *);
+void    stems_close(CSOUND *);
+int     csoundLookAheadStart(CSOUND *);
+int     csoundLookAheadBuffer(CSOUND *);
+void    csoundLookAheadStop(CSOUND *);
+void    csoundLookAheadLongJmp(CSOUND *, int);
+int     csoundIsCurrentThread(void *);
+const CS_SAMPCONV *csoundGetSampleConverters(CSOUND *);
 void    *SAsndgetset(CSOUND *, char *, void *, MYFLT *, MYFLT *, MYFLT *, int);
 int     getsndin(CSOUND *, void *, MYFLT *, int, void *);
 void    *sndgetset(CSOUND *, void *);
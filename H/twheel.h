@@ -0,0 +1,68 @@
+/*
+    twheel.h:
+
+    Copyright (C) 2021 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_TWHEEL_H
+#define CSOUND_TWHEEL_H
+
+#include <stddef.h>              /* offsetof() for twheel_create() */
+
+/* Hierarchical timing wheel keyed on k-cycle count.
+
+   Nodes are intrusive: the wheel only needs to know where the link
+   pointer and the (uint32) k-cycle key live inside the node.  Level 1
+   has one slot per k-cycle of the current page, level 2 one slot per
+   page of the current revolution, and anything further ahead waits in
+   an overflow list that is redistributed once per revolution.  Slots
+   are FIFO, so nodes with equal keys come out in insertion order.
+   Insert is O(1), expiry is O(1) per k-cycle plus O(1) amortised per
+   node.  Removal before expiry is O(1) if the node also has a back
+   link, and a walk of its slot otherwise (TW_NOPRV). */
+
+#define TW_L1BITS   8
+#define TW_L2BITS   10
+#define TW_L1SIZE   (1 << TW_L1BITS)
+#define TW_L2SIZE   (1 << TW_L2BITS)
+#define TW_NOPRV    ((size_t) -1)   /* nodes without a back link */
+
+typedef struct {
+    void    *head, *tail;
+} TWSLOT;
+
+typedef struct twheel {
+    TWSLOT  l1[TW_L1SIZE];      /* one slot per k-cycle of current page   */
+    TWSLOT  l2[TW_L2SIZE];      /* one slot per page of current revolution */
+    TWSLOT  ovfl;               /* beyond the current revolution          */
+    uint64_t cursor;            /* next k-cycle not yet expired           */
+    uint32  count;              /* nodes held in all levels               */
+    size_t  nxtofs, prvofs, keyofs; /* offsets of links and key in the node */
+} TWHEEL;
+
+TWHEEL  *twheel_create(CSOUND *, size_t nxtofs, size_t prvofs,
+                       size_t keyofs);
+void    twheel_insert(TWHEEL *, void *node);
+void    *twheel_advance(TWHEEL *, uint32 kcnt, void **tail);
+int     twheel_remove(TWHEEL *, void *node);
+void    *twheel_peek(TWHEEL *);
+void    *twheel_drain(TWHEEL *, void **tail);
+
+#endif  /* CSOUND_TWHEEL_H */
@@ -0,0 +1,265 @@
+/*
+    capture.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Capture files (--format=capture, fout format 51).
+
+   A capture holds the samples exactly as Csound has them: MYFLT,
+   interleaved, in the machine's byte order, with no header, so nothing
+   is converted when it is written and it can be mapped into memory as it
+   is.  It is laid out in blocks of CS_CAPTURE_BLOCK frames, a whole
+   number of pages for any channel count; block n starts at byte
+   n * CS_CAPTURE_BLOCK * channels * sizeof(MYFLT).
+
+   What the file holds is described by a text index next to it, the file
+   name with ".idx" appended:
+
+     csound-capture 1
+     sr 48000
+     channels 2
+     sample float64le
+     block 4096
+     start 0.000000             score time of the first frame
+     date 1697580000            wall clock time of the first frame
+     frames 480000              from here on, written on closing
+     b 0 0.085333               block, and the seconds after 'date'
+     b 1 0.170666                 at which it was complete
+     m 96000 verse              marker: frame, label
+
+   The index up to 'date' is written when the file is opened, so that a
+   recording that never finished can still be read.  Readers skip lines
+   they do not know.  Csound opens a sound file as a capture whenever it
+   finds its index. */
+
+#include "csoundCore.h"
+#include "soundio.h"
+#include <time.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#define CS_CAPTURE_BLOCK    4096
+
+#ifdef USE_DOUBLE
+#define CAPTURE_SUBTYPE     SF_FORMAT_DOUBLE
+#else
+#define CAPTURE_SUBTYPE     SF_FORMAT_FLOAT
+#endif
+
+typedef struct {
+    int64_t   frame;
+    char      *label;
+} CAPMARKER;
+
+typedef struct {
+    FILE      *idx;
+    char      *name;
+    int       nchnls;
+    int64_t   start;            /* score sample of the first frame      */
+    int64_t   frames;           /* counted by csoundCaptureWrite()      */
+    double    *block;           /* wall clock time of each full block   */
+    int       nblocks, maxblocks;
+    CAPMARKER *marker;
+    int       nmarkers, maxmarkers;
+    RTCLOCK   clock;
+} CAPTURE;
+
+static int little_endian(void)
+{
+    const int one = 1;
+    return *((const char*) &one);
+}
+
+static char *capture_index_name(CSOUND *csound, const char *name)
+{
+    char    *s = (char*) csound->Malloc(csound, strlen(name) + 5);
+    strcpy(s, name);
+    strcat(s, ".idx");
+    return s;
+}
+
+/* Called before a sound file is opened for writing with the SF_INFO that
+   will be passed to libsndfile.  If it asks for a capture, the format is
+   changed to the raw one and the index is started; the handle returned
+   is given to csoundCaptureWrite() and csoundCaptureClose().  Returns
+   NULL for other formats, or if 'name' is NULL (a pipe: the samples are
+   written raw, with no index). */
+
+void *csoundCaptureOpen(CSOUND *csound, const char *name, void *sfinfo_)
+{
+    SF_INFO *sfinfo = (SF_INFO*) sfinfo_;
+    CAPTURE *c;
+    char    *idxname;
+
+    if (SF2TYPE(sfinfo->format) != TYP_CAPTURE)
+      return NULL;
+    sfinfo->format = SF_FORMAT_RAW | CAPTURE_SUBTYPE | SF_ENDIAN_CPU;
+    if (name == NULL)
+      return NULL;
+    idxname = capture_index_name(csound, name);
+    c = (CAPTURE*) csound->Calloc(csound, sizeof(CAPTURE));
+    if ((c->idx = fopen(idxname, "w")) == NULL) {
+      csound->Warning(csound, Str("capture: cannot write index %s; "
+                                  "%s is written without one\n"),
+                      idxname, name);
+      csound->Free(csound, idxname);
+      csound->Free(csound, c);
+      return NULL;
+    }
+    csound->Free(csound, idxname);
+    c->name = cs_strdup(csound, (char*) name);
+    c->nchnls = sfinfo->channels;
+    c->start = (int64_t) csound->icurTime;
+    csoundInitTimerStruct(&c->clock);
+    fprintf(c->idx, "csound-capture 1\n");
+    fprintf(c->idx, "sr %d\n", sfinfo->samplerate);
+    fprintf(c->idx, "channels %d\n", sfinfo->channels);
+    fprintf(c->idx, "sample float%d%s\n", (int) sizeof(MYFLT) * 8,
+            little_endian() ? "le" : "be");
+    fprintf(c->idx, "block %d\n", CS_CAPTURE_BLOCK);
+    fprintf(c->idx, "start %f\n",
+            csound->esr > FL(0.0) ? (double) c->start / csound->esr : 0.0);
+    fprintf(c->idx, "date %ld\n", (long) time(NULL));
+    fflush(c->idx);
+    return (void*) c;
+}
+
+/* Counts frames written; the time each block is complete goes in the
+   index. */
+
+void csoundCaptureWrite(CSOUND *csound, void *handle, int nframes)
+{
+    CAPTURE *c = (CAPTURE*) handle;
+
+    c->frames += nframes;
+    while (c->frames >= (int64_t) (c->nblocks + 1) * CS_CAPTURE_BLOCK) {
+      if (c->nblocks >= c->maxblocks) {
+        c->maxblocks = (c->maxblocks ? c->maxblocks * 2 : 256);
+        c->block = (double*) csound->ReAlloc(csound, c->block,
+                                             c->maxblocks * sizeof(double));
+      }
+      c->block[c->nblocks++] = csoundGetRealTime(&c->clock);
+    }
+}
+
+/* Marks the score sample 'sample' with 'label'. */
+
+void csoundCaptureMarker(CSOUND *csound, void *handle, int64_t sample,
+                         const char *label)
+{
+    CAPTURE   *c = (CAPTURE*) handle;
+    CAPMARKER *m;
+    char      *s;
+
+    if (c->nmarkers >= c->maxmarkers) {
+      c->maxmarkers = (c->maxmarkers ? c->maxmarkers * 2 : 16);
+      c->marker = (CAPMARKER*) csound->ReAlloc(csound, c->marker,
+                                               c->maxmarkers
+                                               * sizeof(CAPMARKER));
+    }
+    m = &c->marker[c->nmarkers++];
+    m->frame = (sample > c->start ? sample - c->start : 0);
+    m->label = cs_strdup(csound, (char*) (label != NULL ? label : ""));
+    for (s = m->label; *s != '\0'; s++)     /* one line each */
+      if (*s == '\n' || *s == '\r')
+        *s = ' ';
+}
+
+/* Completes the index; called after the sound file itself is closed.
+   With 'discard' non-zero (the file could not be opened), the index is
+   removed instead. */
+
+void csoundCaptureClose(CSOUND *csound, void *handle, int discard)
+{
+    CAPTURE     *c = (CAPTURE*) handle;
+    struct stat st;
+    int64_t     frames = c->frames;
+    int         i;
+
+    if (discard) {
+      char *idxname = capture_index_name(csound, c->name);
+      fclose(c->idx);
+      remove(idxname);
+      csound->Free(csound, idxname);
+    }
+    else {
+      /* the file itself knows best what was written */
+      if (stat(c->name, &st) == 0)
+        frames = (int64_t) st.st_size
+                 / ((int64_t) c->nchnls * (int64_t) sizeof(MYFLT));
+      fprintf(c->idx, "frames %" PRId64 "\n", frames);
+      for (i = 0; i < c->nblocks; i++)
+        fprintf(c->idx, "b %d %f\n", i, c->block[i]);
+      for (i = 0; i < c->nmarkers; i++)
+        fprintf(c->idx, "m %" PRId64 " %s\n",
+                c->marker[i].frame, c->marker[i].label);
+      if (UNLIKELY(fclose(c->idx) != 0))
+        csound->Warning(csound, Str("capture: error writing the index "
+                                    "of %s\n"), c->name);
+    }
+    for (i = 0; i < c->nmarkers; i++)
+      csound->Free(csound, c->marker[i].label);
+    csound->Free(csound, c->marker);
+    csound->Free(csound, c->block);
+    csound->Free(csound, c->name);
+    csound->Free(csound, c);
+}
+
+/* If the sound file 'name' has a capture index, sets 'sfinfo' (SF_INFO)
+   to open it with and returns zero; otherwise returns -1. */
+
+int csoundCaptureInfo(CSOUND *csound, const char *name, void *sfinfo_)
+{
+    SF_INFO *sfinfo = (SF_INFO*) sfinfo_;
+    char    *idxname, line[256], sample[16] = "";
+    FILE    *f;
+    int     sr = 0, channels = 0, bits = 0, le;
+
+    idxname = capture_index_name(csound, name);
+    f = fopen(idxname, "r");
+    csound->Free(csound, idxname);
+    if (f == NULL)
+      return -1;
+    if (fgets(line, sizeof(line), f) == NULL ||
+        strncmp(line, "csound-capture 1", 16) != 0) {
+      fclose(f);
+      return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+      if (line[0] == 'b' && line[1] == ' ')   /* the header is done */
+        break;
+      if (sscanf(line, "sr %d", &sr) == 1 ||
+          sscanf(line, "channels %d", &channels) == 1)
+        continue;
+      sscanf(line, "sample %15s", sample);
+    }
+    fclose(f);
+    if (strncmp(sample, "float", 5) != 0 ||
+        sscanf(sample + 5, "%d", &bits) != 1 ||
+        (bits != 32 && bits != 64) || sr <= 0 || channels <= 0)
+      return -1;
+    le = (strcmp(sample + 7, "le") == 0);
+    memset(sfinfo, 0, sizeof(SF_INFO));
+    sfinfo->samplerate = sr;
+    sfinfo->channels = channels;
+    sfinfo->format = SF_FORMAT_RAW |
+                     (bits == 64 ? SF_FORMAT_DOUBLE : SF_FORMAT_FLOAT) |
+                     (le ? SF_ENDIAN_LITTLE : SF_ENDIAN_BIG);
+    return 0;
+}
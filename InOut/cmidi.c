@@ -47,6 +47,8 @@ typedef struct _cdata {
   MIDIdata *mdata;
   int p; int q;
   MIDIClientRef mclient;
+  CSOUND *csound;
+  int dropped;          /* messages that found the timestamped queue full */
 } cdata;
 
 
@@ -62,8 +64,24 @@ void ReadProc(const MIDIPacketList *pktlist, void *refcon, void *srcConnRefCon)
     Byte *curpack;
 
     for (i = 0; i < pktlist->numPackets; i++) {
+      /* seconds since the packet arrived; a zero timestamp means now */
+      UInt64 now = AudioGetCurrentHostTime(), ts = packet->timeStamp;
+      double age = (ts != 0 && ts < now ?
+                    AudioConvertHostTimeToNanos(now - ts) * 1.0e-9 : 0.0);
       for (j=0; j < packet->length; j+=3) {
         curpack = packet->data+j;
+        /* channel messages go to the timestamped queue */
+        if (curpack[0] >= 0x80 && curpack[0] < 0xF0) {
+          switch (data->csound->PushMidiMessage(data->csound, curpack,
+                                                (curpack[0] & 0xE0) == 0xC0 ?
+                                                2 : 3, age)) {
+          case CSOUND_SUCCESS:
+            continue;
+          case CSOUND_MEMORY:           /* queue full: drop it */
+            data->dropped++;
+            continue;
+          }
+        }
         memcpy(&mdata[*p], curpack, 3);
         mdata[*p].flag = 1;
         (*p)++;
@@ -119,6 +137,8 @@ static int MidiInDeviceOpen(CSOUND *csound, void **userData, const char *dev)
     refcon->mdata = mdata;
     refcon->p = 0;
     refcon->q = 0;
+    refcon->csound = csound;
+    refcon->dropped = 0;
     /* MIDI client */
     cname = CFStringCreateWithCString(NULL, "my client", defaultEncoding);
     ret = MIDIClientCreate(cname, NULL, NULL, &mclient);
@@ -237,6 +257,9 @@ static int MidiInDeviceClose(CSOUND *csound, void *userData)
     cdata * data = (cdata *)userData;
     if (data != NULL) {
       MIDIClientDispose(data->mclient);
+      if (data->dropped)
+        csound->Warning(csound, Str("CoreMIDI: %d input messages dropped "
+                                    "(queue full)"), data->dropped);
       csound->Free(csound, data->mdata);
       csound->Free(csound, data);
     }
@@ -23,6 +23,7 @@
 
 #include "csoundCore.h"                 /*             SNDLIB.C         */
 #include "soundio.h"
+#include "envvar.h"
 #include <stdlib.h>
 #include <time.h>
 #include <inttypes.h>
@@ -190,176 +191,67 @@ static void spoutsf_noscale(CSOUND *csound)
 static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
 {
     OPARMS  *O = csound->oparms;
-    int     n;
-
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader((void *)STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", "\a");
-        break;
-    }
-}
-
-static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
-{
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int    dith;
-
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   tmp = ((dith * 15625) + 1) & 0xFFFF;
-      int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith = rnd;
-      rnd = (rnd+tmp)>>1;           /* triangular distribution */
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7fff);
-      buf[n] += result;
-    }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
-    }
-}
-
-static void writesf_dither_8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
-{
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    int     n, m = nbytes / (int) sizeof(MYFLT);
 
     if (UNLIKELY(STA(outfile) == NULL))
       return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   tmp = ((dith * 15625) + 1) & 0xFFFF;
-      int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith = rnd;
-      rnd = (rnd+tmp)>>1;           /* triangular distribution */
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7f);
-      buf[n] += result;
+    if (STA(outconv) != 0 && m > STA(convbufsmps)) {
+      STA(convbuf) = csound->ReAlloc(csound, STA(convbuf),
+                                     (size_t) m * sizeof(int32_t));
+      STA(convbufsmps) = m;
+    }
+    /* convert here rather than in libsndfile: the shared converters */
+    /* are vectorised, and do the dither */
+    switch (STA(outconv)) {
+    case AE_SHORT:
+      STA(conv)->ToShort(m, outbuf, STA(convbuf), &STA(dither));
+      break;
+    case AE_24INT:
+      STA(conv)->ToInt24(m, outbuf, STA(convbuf), &STA(dither));
+      break;
+    case AE_LONG:
+      STA(conv)->ToLong(m, outbuf, STA(convbuf), &STA(dither));
+      break;
+    case AE_FLOAT:
+      STA(conv)->ToFloat(m, outbuf, STA(convbuf), &STA(dither));
+      break;
+    case AE_CHAR:                       /* 8 bit, only dithered here */
+      STA(conv)->Dither(m, (MYFLT*) outbuf, FL(1.0) / (MYFLT) 0x7f,
+                        &STA(dither));
+      break;
+    }
+    if (STA(outwr) != NULL) {
+      /* written by the I/O thread; a block that does not fit is */
+      /* dropped, and reported when the file is closed */
+      csoundSndfileWriteAsync(csound, STA(outwr),
+                              (STA(outconv) == AE_CHAR || STA(outconv) == 0 ?
+                               (const void*) outbuf : STA(convbuf)), m);
+      n = m;
     }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
+    else {
+      switch (STA(outconv)) {
+      case AE_SHORT:
+        n = (int) sf_write_short(STA(outfile), (short*) STA(convbuf), m);
         break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
+      case AE_24INT:
+      case AE_LONG:
+        n = (int) sf_write_int(STA(outfile), (int*) STA(convbuf), m);
         break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
+      case AE_FLOAT:
+        n = (int) sf_write_float(STA(outfile), (float*) STA(convbuf), m);
         break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
+      default:
+        n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf, m);
         break;
+      }
+      if (UNLIKELY(O->rewrt_hdr))
+        rewriteheader((void *)STA(outfile));
     }
-}
-
-static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
-{
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
-
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   rnd = ((dith * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith =  rnd;
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7fff);
-      buf[n] += result;
-    }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
+    if (STA(capture) != NULL)
+      csoundCaptureWrite(csound, STA(capture), m / csound->nchnls);
+    n *= (int) sizeof(MYFLT);
     if (UNLIKELY(n < nbytes))
       sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -381,62 +273,11 @@ static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
         }
         break;
       case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  "\a");
+        csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", "\a");
         break;
     }
 }
 
-static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
-{
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
-
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   rnd = ((dith * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      STA(dither) = rnd;
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7f);
-      buf[n] += result;
-    }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
-    }
-}
 
 static int readsf(CSOUND *csound, MYFLT *inbuf, int inbufsize)
 {
@@ -702,6 +543,9 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       case TYP_OGG:
         O->outfilename = "test.ogg";
         break;
+      case TYP_CAPTURE:
+        O->outfilename = "test.csr";
+        break;
       /* case TYP_MPC2K: */
       /*   O->outfilename = ""; */
       /*   break; */
@@ -760,27 +604,13 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       }
       else if (strcmp(fName, "null") == 0) {
         STA(outfile) = NULL;
-        if (csound->dither_output && csound->oparms->outformat!=AE_FLOAT &&
-            csound->oparms->outformat!=AE_DOUBLE) {
-          if (csound->oparms->outformat==AE_SHORT)
-            if (csound->dither_output==1)
-              csound->audtran = writesf_dither_16;
-            else
-              csound->audtran = writesf_dither_u16;
-          else if (csound->oparms->outformat==AE_CHAR)
-            if (csound->dither_output==1)
-              csound->audtran = writesf_dither_8;
-            else
-              csound->audtran = writesf_dither_u8;
-          else
-            csound->audtran = writesf;
-        }
-        else
-          csound->audtran = writesf;
+        csound->audtran = writesf;
         goto outset;
       }
     }
     /* set format parameters */
+    if (O->filetyp == TYP_CAPTURE)      /* samples as they are */
+      O->outformat = (sizeof(MYFLT) == 8 ? AE_DOUBLE : AE_FLOAT);
     memset(&sfinfo, 0, sizeof(SF_INFO));
     //sfinfo.frames     = 0;
     sfinfo.samplerate = (int) MYFLT2LRND(csound->esr);
@@ -788,6 +618,7 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
     sfinfo.format     = TYPE2SF(O->filetyp) | FORMAT2SF(O->outformat);
     /* open file */
     if (STA(pipdevout)) {
+      csoundCaptureOpen(csound, NULL, &sfinfo);     /* no index in a pipe */
       STA(outfile) = sf_open_fd(osfd, SFM_WRITE, &sfinfo, 0);
 #ifdef PIPES
       if (STA(outfile) == NULL) {
@@ -823,10 +654,16 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       if (UNLIKELY(fullName == NULL))
         csoundDie(csound, Str("sfinit: cannot open %s"), fName);
       STA(sfoutname) = fullName;
+      STA(capture)   = csoundCaptureOpen(csound, fullName, &sfinfo);
       STA(outfile)   = sf_open(fullName, SFM_WRITE, &sfinfo);
-      if (UNLIKELY(STA(outfile) == NULL))
+      if (UNLIKELY(STA(outfile) == NULL)) {
+        if (STA(capture) != NULL) {
+          csoundCaptureClose(csound, STA(capture), 1);
+          STA(capture) = NULL;
+        }
         csoundDie(csound, Str("sfinit: cannot open %s\n%s"),
                   fullName, sf_strerror (NULL));
+      }
       sf_command(STA(outfile), SFC_SET_VBR_ENCODING_QUALITY,
                  &O->quality, sizeof(double));
       /* only notify the host if we opened a real file, not stdout or a pipe */
@@ -851,21 +688,33 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
 #endif
     if (!(O->outformat == AE_FLOAT || O->outformat == AE_DOUBLE) ||
         (O->filetyp == TYP_WAV || O->filetyp == TYP_AIFF ||
-         O->filetyp == TYP_W64))
+         O->filetyp == TYP_W64 || O->filetyp == TYP_CAPTURE))
       csound->spoutran = spoutsf;       /* accumulate output */
     else
       csound->spoutran = spoutsf_noscale;
-    if (csound->dither_output && csound->oparms->outformat!=AE_FLOAT &&
-        csound->oparms->outformat!=AE_DOUBLE) {
-      if (csound->oparms->outformat==AE_SHORT)
-        csound->audtran = writesf_dither_16;
-      else if (csound->oparms->outformat==AE_CHAR)
-        csound->audtran = writesf_dither_8;
-      else
-        csound->audtran = writesf;
-    }
-    else
-      csound->audtran = writesf;
+    /* formats converted by writesf() itself, and dither */
+    STA(conv) = csoundGetSampleConverters(csound);
+    switch (O->outformat) {
+    case AE_SHORT:
+    case AE_24INT:
+    case AE_LONG:
+      STA(outconv) = O->outformat;
+      break;
+#ifdef USE_DOUBLE
+    case AE_FLOAT:
+      STA(outconv) = AE_FLOAT;
+      break;
+#endif
+    case AE_CHAR:
+      STA(outconv) = (csound->dither_output ? AE_CHAR : 0);
+      break;
+    default:
+      STA(outconv) = 0;
+    }
+    STA(conv)->InitDither(&STA(dither),
+                          (O->outformat == AE_SHORT ||
+                           O->outformat == AE_CHAR ? csound->dither_output : 0));
+    csound->audtran = writesf;
     /* Write any tags. */
     if ((s = csound->SF_id_title) != NULL && *s != '\0')
       sf_set_string(STA(outfile), SF_STR_TITLE, s);
@@ -889,6 +738,14 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       sf_set_string(STA(outfile), SF_STR_COMMENT, s);
     if ((s = csound->SF_id_date) != NULL && *s != '\0')
       sf_set_string(STA(outfile), SF_STR_DATE, s);
+    /* when recording in real time, leave the disk to the I/O thread */
+    if (O->realtime ||
+        (O->sfread && check_rtaudio_name(O->infilename, NULL, 0) >= 0))
+      STA(outwr) = csoundSndfileOpenAsync(csound, STA(outfile),
+                                          STA(sfoutname),
+                                          (STA(outconv) == AE_CHAR ?
+                                           0 : STA(outconv)),
+                                          csound->nchnls, O->rewrt_hdr);
     /* file is now open */
     STA(osfopen) = 1;
 
@@ -958,12 +815,25 @@ void sfcloseout(CSOUND *csound)
     }
     if (STA(pipdevout) == 2)
       goto report;
+    if (STA(outwr) != NULL) {
+      csoundSndfileCloseAsync(csound, STA(outwr));
+      STA(outwr) = NULL;
+    }
     if (STA(outfile) != NULL) {
       if (!STA(pipdevout) && O->outformat != AE_VORBIS)
         sf_command(STA(outfile), SFC_UPDATE_HEADER_NOW, NULL, 0);
       sf_close(STA(outfile));
       STA(outfile) = NULL;
     }
+    if (STA(capture) != NULL) {
+      csoundCaptureClose(csound, STA(capture), 0);
+      STA(capture) = NULL;
+    }
+    if (STA(convbuf) != NULL) {
+      csound->Free(csound, STA(convbuf));
+      STA(convbuf) = NULL;
+      STA(convbufsmps) = 0;
+    }
 #ifdef PIPES
     if (STA(pout) != NULL) {
       _pclose(STA(pout));
@@ -1092,12 +962,14 @@ void iotranset(CSOUND *csound)
     STA(osfopen)   = 1;
 }
 
+/* with --look-ahead the engine renders into buffers of its own */
+
 PUBLIC MYFLT *csoundGetInputBuffer(CSOUND *csound)
 {
-    return STA(inbuf);
+    return STA(hostinbuf) != NULL ? STA(hostinbuf) : STA(inbuf);
 }
 
 PUBLIC MYFLT *csoundGetOutputBuffer(CSOUND *csound)
 {
-    return STA(outbuf);
+    return STA(hostoutbuf) != NULL ? STA(hostoutbuf) : STA(outbuf);
 }
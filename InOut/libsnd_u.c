@@ -345,6 +345,7 @@ char *type2string(int x)
       case TYP_OGG:   return "OGG";
       case TYP_MPC2K: return "MPC2K";
       case TYP_RF64:  return "RF64";
+      case TYP_CAPTURE: return "capture";
       default:        return Str("unknown");
     }
 }
@@ -383,7 +384,8 @@ char *getstrformat(int format)  /* used here, and in sfheader.c */
 int type2csfiletype(int type, int encoding)
 {
     switch (type) {
-      case TYP_RAW:    return CSFTYPE_RAW_AUDIO;
+      case TYP_RAW:
+      case TYP_CAPTURE: return CSFTYPE_RAW_AUDIO;
       case TYP_IRCAM:  return CSFTYPE_IRCAM;
       case TYP_AIFF:
         switch (encoding) {
@@ -75,6 +75,22 @@
       Returns pointer to a string constant storing an error massage
       for error code 'errcode'.
 
+    Timestamped input:
+    ------------------
+
+    int csoundPushMidiMessage(CSOUND *csound, const unsigned char *msg,
+                              int nbytes, double age);
+
+      Instead of returning bytes from MidiReadCallback, a driver that
+      knows when a message arrived can queue it, complete, with its age
+      in seconds. The queue is lock-free for a single producer: it can
+      be called from the driver's own thread, but only from one thread
+      at a time. A full queue drops the message and returns
+      CSOUND_MEMORY. When sample-accurate
+      timing is on, the arrival times between two k-cycles are mapped
+      onto the samples of the next one and become the ksmps_offset of
+      the notes they start.
+
     Setting function pointers:
     --------------------------
 
@@ -106,6 +122,14 @@
 
 #define MGLOB(x) (csound->midiGlobals->x)
 
+#define MIDITSQSIZE   1024
+
+typedef struct {
+    double  time;                       /* on the csRtClock timer */
+    int32   nbytes;
+    unsigned char data[8];
+} MIDITSMSG;
+
 static  void    midNotesOff(CSOUND *);
 
 static const MYFLT dsctl_map[12] = {
@@ -128,6 +152,11 @@ void MidiOpen(CSOUND *csound)
     p->sexp = 0;
     /* Then open device... */
     if (O->Midiin) {
+      /* drivers may push timestamped messages as soon as they are open */
+      p->tsQueue = csoundCreateCircularBuffer(csound, MIDITSQSIZE,
+                                              sizeof(MIDITSMSG));
+      p->tsPrev = p->tsNow = csoundGetRealTime(csound->csRtClock);
+      p->tsKcnt = csound->kcounter;
       if (p->MidiInOpenCallback == NULL)
         csound->Die(csound, Str(" *** no callback for opening MIDI input"));
       if (p->MidiReadCallback == NULL)
@@ -473,6 +502,49 @@ static void midNotesOff(CSOUND *csound)
     } while (++chan < MAXCHAN);
 }
 
+/* The queue is a single-producer ring: all messages must be pushed
+   from one thread, or the callers must serialise among themselves.
+   Returns CSOUND_MEMORY, dropping the message, when it is full. */
+
+PUBLIC int csoundPushMidiMessage(CSOUND *csound, const unsigned char *msg,
+                                 int nbytes, double age)
+{
+    MGLOBAL   *p = csound->midiGlobals;
+    MIDITSMSG m;
+
+    if (UNLIKELY(p == NULL || p->tsQueue == NULL ||
+                 nbytes < 1 || nbytes > (int) sizeof(m.data)))
+      return CSOUND_ERROR;
+    m.time = csoundGetRealTime(csound->csRtClock) - (age > 0.0 ? age : 0.0);
+    m.nbytes = nbytes;
+    memcpy(m.data, msg, nbytes);
+    if (UNLIKELY(csoundWriteCircularBuffer(csound, p->tsQueue, &m, 1) != 1))
+      return CSOUND_MEMORY;                     /* queue full: dropped */
+    return CSOUND_SUCCESS;
+}
+
+/* Move one queued message into the input buffer and set its sample
+   offset: the time between the last two k-cycles maps onto this one. */
+
+static int midi_ts_read(CSOUND *csound, MGLOBAL *p)
+{
+    MIDITSMSG m;
+
+    if (csoundReadCircularBuffer(csound, p->tsQueue, &m, 1) != 1)
+      return 0;
+    memcpy(p->endatp, m.data, m.nbytes);
+    p->endatp += m.nbytes;
+    if (csound->oparms->sampleAccurate && p->tsNow > p->tsPrev) {
+      double  ofs = (m.time - p->tsPrev) / (p->tsNow - p->tsPrev);
+      ofs *= (double) csound->ksmps;
+      if (ofs >= (double) (csound->ksmps - 1))
+        p->ksmps_offset = csound->ksmps - 1;    /* arrived since last read */
+      else if (ofs > 0.0)
+        p->ksmps_offset = (uint32) ofs;
+    }
+    return 1;
+}
+
 /* sense a MIDI event, collect the data & dispatch */
 /* called from sensevents(), returns 2 if MIDI on/off */
 
@@ -484,10 +556,18 @@ int sensMidi(CSOUND *csound)
     int     n;
     int16   c, type;
 
+    if (p->tsQueue != NULL && p->tsKcnt != csound->kcounter) {
+      p->tsKcnt = csound->kcounter;             /* first call this k-cycle */
+      p->tsPrev = p->tsNow;
+      p->tsNow = csoundGetRealTime(csound->csRtClock);
+    }
  nxtchr:
     if (p->bufp >= p->endatp) {
       p->bufp = &(p->mbuf[0]);
       p->endatp = p->bufp;
+      p->ksmps_offset = 0;
+      if (p->tsQueue != NULL && midi_ts_read(csound, p))
+        goto nxtchr;                            /* one timestamped message */
       if (O->Midiin && !csound->advanceCnt) {   /* read MIDI device */
         n = p->MidiReadCallback(csound, p->midiInUserData, p->bufp, MBUFSIZ);
         if (n < 0)
@@ -502,8 +582,12 @@ int sensMidi(CSOUND *csound)
         if (n > 0)
           p->endatp += (int) n;
       }
-      if (p->endatp <= p->bufp)
+      if (p->endatp <= p->bufp) {
+        /* the read callback may have queued timestamped messages */
+        if (p->tsQueue != NULL && midi_ts_read(csound, p))
+          goto nxtchr;
         return 0;               /* no events were received */
+      }
     }
 
     if ((c = *(p->bufp++)) & 0x80) {    /* STATUS byte:         */
@@ -622,6 +706,10 @@ void MidiClose(CSOUND *csound)
                        retval, csoundExternalMidiErrorString(csound, retval));
     }
     p->midiInUserData = NULL;
+    if (p->tsQueue != NULL) {           /* the driver has stopped pushing */
+      csoundDestroyCircularBuffer(csound, p->tsQueue);
+      p->tsQueue = NULL;
+    }
     if (p->MIDIoutDONE && p->MidiOutCloseCallback != NULL) {
       retval = p->MidiOutCloseCallback(csound, p->midiOutUserData);
       if (retval != 0)
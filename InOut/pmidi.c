@@ -46,6 +46,7 @@ void _wassert(wchar_t *condition)
 typedef struct _pmall_data {
   PortMidiStream *midistream;
   int multiport_flag;
+  int dropped;                  /* messages that found the queue full */
   struct _pmall_data *next;
 } pmall_data;
 
@@ -290,6 +291,7 @@ static int OpenMidiInDevice_(CSOUND *csound, void **userData, const char *dev)
         /* set multiport mapping if asked */
         if(dev[0] == 'm') next->multiport_flag = 1;
         else next->multiport_flag = 0;
+        next->dropped = 0;
           port++;
         retval = Pm_OpenInput(&next->midistream,
                  (PmDeviceID) portMidi_getRealDeviceID(i, 0),
@@ -402,6 +404,28 @@ static int ReadMidiData_(CSOUND *csound, void *userData,
                        !(st == 0xF8 || st == 0xFA || st == 0xFB ||
                          st == 0xFC || st == 0xFF)))
             continue;
+          {
+            /* queue with the arrival time, in ms of PortTime */
+            unsigned char msg[4];
+            int   len = 0;
+            msg[len++] = (unsigned char) st;
+            if (map && datbyts[(st - 0x80) >> 4] > 0)
+              msg[len++] = (unsigned char) (0x80 | port);
+            if (datbyts[(st - 0x80) >> 4] > 0)
+              msg[len++] = (unsigned char) d1;
+            if (datbyts[(st - 0x80) >> 4] > 1)
+              msg[len++] = (unsigned char) d2;
+            switch (csound->PushMidiMessage(csound, msg, len,
+                                            (double) (Pt_Time()
+                                                      - mev.timestamp)
+                                            * 0.001)) {
+            case CSOUND_SUCCESS:
+              continue;
+            case CSOUND_MEMORY:         /* queue full: drop it */
+              data->dropped++;
+              continue;
+            }
+          }
           nbytes -= (datbyts[(st - 0x80) >> 4] + 1 + map);
           if (UNLIKELY(nbytes < 0)) {
             portMidiErrMsg(csound, Str("buffer overflow in MIDI input"));
@@ -497,6 +521,9 @@ static int CloseMidiInDevice_(CSOUND *csound, void *userData)
     PmError retval;
     pmall_data* data = (pmall_data*) userData;
     while (data) {
+      if (UNLIKELY(data->dropped))
+        csound->Warning(csound, Str("PortMIDI: %d input messages dropped "
+                                    "(queue full)"), data->dropped);
       retval = Pm_Close(data->midistream);
       if (UNLIKELY(retval != pmNoError)) {
         return portMidiErrMsg(csound, Str("error closing input device"));
@@ -104,10 +104,11 @@ typedef struct devparams_ {
     int             buffer_smps;    /* buffer length in samples         */
     int             period_smps;    /* period time in samples           */
     /* playback sample conversion function */
-    void            (*playconv)(int, MYFLT *, void *, int *);
+    void            (*playconv)(int, const MYFLT *, void *, CS_DITHER *);
     /* record sample conversion function */
-    void            (*rec_conv)(int, void *, MYFLT *);
-    int             seed;           /* random seed for dithering        */
+    void            (*rec_conv)(int, const void *, MYFLT *);
+    CS_DITHER       dither;         /* dither state                     */
+    int             mmap;           /* non-zero: convert in the DMA area */
 } DEVPARAMS;
 
 #ifdef BUF_SIZE
@@ -181,159 +182,31 @@ int set_scheduler_priority(CSOUND *csound, int priority)
 }
 
 
-/* sample conversion routines for playback */
-
-static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
-{
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = (((rnd) * 15625) + 1) & 0xFFFF;
-      rnd += *seed;           /* triangular distribution */
-      tmp_f = (MYFLT) ((rnd>>1) - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
-{
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = rnd;
-      tmp_f = (MYFLT) (rnd - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_short_no_dither(int nSmps, MYFLT *inBuf,
-                                     int16_t *outBuf, int *seed)
-{
-  IGN(seed);
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf, int *seed)
-{
-    MYFLT   tmp_f;
-    int64_t tmp_i;
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x80000000UL;
-#ifndef USE_DOUBLE
-      tmp_i = (int64_t) llrintf(tmp_f);
-#else
-      tmp_i = (int64_t) llrint(tmp_f);
-#endif
-      if (tmp_i < -((int64_t) 0x80000000UL))
-        tmp_i = -((int64_t) 0x80000000UL);
-      if (tmp_i > (int64_t) 0x7FFFFFFF) tmp_i = (int64_t) 0x7FFFFFFF;
-      outBuf[n] = (int32_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf, int *seed)
-{
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (float) inBuf[n];
-}
-
-/* sample conversion routines for recording */
-
-static void short_to_MYFLT(int nSmps, int16_t *inBuf, MYFLT *outBuf)
-{
-    int n;
-    MYFLT adjust = FL(1.0) / (MYFLT) 0x8000;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * adjust;
-}
-
-static void long_to_MYFLT(int nSmps, int32_t *inBuf, MYFLT *outBuf)
-{
-    int n;
-    MYFLT adjust = FL(1.0) / (MYFLT) 0x80000000UL;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * adjust;
-}
-
-static void float_to_MYFLT(int nSmps, float *inBuf, MYFLT *outBuf)
-{
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n];
-}
-
 /* select sample format */
 
-static snd_pcm_format_t set_format(void (**convFunc)(void), int csound_format,
-                                   int play, int csound_dither)
+static snd_pcm_format_t set_format(CSOUND *csound, DEVPARAMS *dev, int play)
 {
+    const CS_SAMPCONV *conv = csound->GetSampleConverters(csound);
     int16   endian_test = 0x1234;
+    int     csound_format = dev->format;
 
-    (*convFunc) = NULL;
     /* select conversion routine */
     switch (csound_format) {
     case AE_SHORT:
-      if (play) {
-        if (csound_dither==1)
-          *convFunc = (void (*)(void)) MYFLT_to_short;
-        else if (csound_dither==2)
-          *convFunc = (void (*)(void)) MYFLT_to_short_u;
-        else
-          *convFunc = (void (*)(void)) MYFLT_to_short_no_dither;
-      }
-      else
-        *convFunc = (void (*)(void)) short_to_MYFLT;
+      dev->playconv = conv->ToShort;
+      dev->rec_conv = conv->FromShort;
       break;
     case AE_LONG:
-      if (play)
-        *convFunc = (void (*)(void)) MYFLT_to_long;
-      else
-        *convFunc = (void (*)(void)) long_to_MYFLT;
+      dev->playconv = conv->ToLong;
+      dev->rec_conv = conv->FromLong;
       break;
     case AE_FLOAT:
-      if (play)
-        *convFunc = (void (*)(void)) MYFLT_to_float;
-      else
-        *convFunc = (void (*)(void)) float_to_MYFLT;
+      dev->playconv = conv->ToFloat;
+      dev->rec_conv = conv->FromFloat;
       break;
     }
+    conv->InitDither(&dev->dither, (play && csound_format == AE_SHORT ?
+                                    csound->GetDitherMode(csound) : 0));
     if (*((unsigned char*) (&endian_test)) == (unsigned char) 0x34) {
       /* little-endian */
       switch (csound_format) {
@@ -424,8 +297,14 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
     /*=========================*/
 
     /* now set the various hardware parameters: */
-    /* access method, */
-    if (UNLIKELY(snd_pcm_hw_params_set_access(dev->handle, hw_params,
+    /* access method (mmap if possible, to convert straight into the */
+    /* DMA area), */
+    if (dev->mmap &&
+        snd_pcm_hw_params_set_access(dev->handle, hw_params,
+                                     SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0)
+      dev->mmap = 0;
+    if (UNLIKELY(!dev->mmap &&
+                 snd_pcm_hw_params_set_access(dev->handle, hw_params,
                                               SND_PCM_ACCESS_RW_INTERLEAVED) < 0)) {
       strNcpy(msg, Str("Error setting access type for soundcard"), MSGLEN);
       goto err_return_msg;
@@ -434,12 +313,7 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
     alsaFmt = SND_PCM_FORMAT_UNKNOWN;
     if(dev->srate  == 0) dev->format = AE_FLOAT;
     dev->sampleSize = (int) sizeof(MYFLT) * dev->nchns;
-    {
-      void  (*fp)(void) = NULL;
-      alsaFmt = set_format(&fp, dev->format, play, csound->GetDitherMode(csound));
-      if (play) dev->playconv = (void (*)(int, MYFLT*, void*, int*)) fp;
-      else      dev->rec_conv = (void (*)(int, void*, MYFLT*)) fp;
-    }
+    alsaFmt = set_format(csound, dev, play);
 
     if (UNLIKELY(alsaFmt == SND_PCM_FORMAT_UNKNOWN)) {
       strNcpy(msg, Str("Unknown sample format.\n *** Only 16-bit and 32-bit "
@@ -536,9 +410,10 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
     /* print settings */
 
     if (p->GetMessageLevel(p) != 0)
-      p->Message(p, Str("ALSA %s: total buffer size: %d, period size: %d\n"),
+      p->Message(p, Str("ALSA %s: total buffer size: %d, period size: %d%s\n"),
                  (play ? "output" : "input"),
-                 dev->buffer_smps, dev->period_smps /*, dev->srate*/);
+                 dev->buffer_smps, dev->period_smps /*, dev->srate*/,
+                 (dev->mmap ? ", mmap" : ""));
     /* now set software parameters */
     n = (play ? dev->buffer_smps : 1);
     if (UNLIKELY(snd_pcm_sw_params_current(dev->handle, sw_params) < 0 ||
@@ -553,6 +428,8 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
       goto err_return_msg;
     }
     /* allocate memory for sample conversion buffer */
+    if (dev->mmap)
+      return 0;
     n = (dev->format == AE_SHORT ? 2 : 4) * dev->nchns * alloc_smps;
     dev->buf = (void*) csound->Malloc(csound, (size_t) n);
     if (UNLIKELY(dev->buf == NULL)) {
@@ -706,9 +583,12 @@ static int open_device(CSOUND *csound, const csRtAudioParams *parm, int play)
     dev->nchns = parm->nChannels;
 
     dev->period_smps = parm->bufSamp_SW;
-    dev->playconv = (void (*)(int, MYFLT*, void*, int*)) NULL;
-    dev->rec_conv = (void (*)(int, void*, MYFLT*)) NULL;
-    dev->seed = 1;
+    dev->playconv = NULL;
+    dev->rec_conv = NULL;
+    {
+      int *mm = (int*) csound->QueryGlobalVariable(csound, "_alsaMmap");
+      dev->mmap = (mm == NULL || *mm != 0);
+    }
     /* open device */
     retval = set_device_params(csound, dev, play);
     if (retval != 0) {
@@ -742,6 +622,98 @@ static int playopen_(CSOUND *csound, const csRtAudioParams *parm)
         csound->Warning(csound, Str(x));                  \
   }
 
+/* recovers from an xrun or suspend; returns non-zero if that failed */
+
+static int xrun_recover(CSOUND *csound, DEVPARAMS *dev, int err, int play)
+{
+    if (err == -EPIPE) {
+      /* buffer underrun */
+      if (play) {
+        warning(Str("Buffer underrun in real-time audio output"));
+      }
+      else {
+        warning(Str("Buffer overrun in real-time audio input"));
+      }
+      if (snd_pcm_prepare(dev->handle) >= 0) return 0;
+    }
+    else if (err == -ESTRPIPE) {
+      /* suspend */
+      if (play) {
+        warning(Str("Real-time audio output suspended"));
+      }
+      else {
+        warning(Str("Real-time audio input suspended"));
+      }
+      while (snd_pcm_resume(dev->handle) == -EAGAIN) sleep(1);
+      if (snd_pcm_prepare(dev->handle) >= 0) return 0;
+    }
+    return -1;
+}
+
+/* mmap transfer of n frames between the MYFLT buffer and the DMA area; */
+/* returns the number of frames transferred */
+
+static int mmap_transfer(CSOUND *csound, DEVPARAMS *dev, MYFLT *buf, int n,
+                         int play)
+{
+    const snd_pcm_channel_area_t  *areas;
+    snd_pcm_uframes_t   offset, frames;
+    snd_pcm_sframes_t   avail;
+    int                 err, m = 0;
+    char                *addr;
+
+    while (n > 0) {
+      avail = snd_pcm_avail_update(dev->handle);
+      if (avail < 0) {
+        if (xrun_recover(csound, dev, (int) avail, play) != 0)
+          return -1;
+        continue;
+      }
+      if (avail < (snd_pcm_sframes_t) (n < dev->period_smps ?
+                                       n : dev->period_smps)) {
+        /* capture has to be started by hand, playback starts */
+        /* by itself once the buffer is full */
+        if (!play && snd_pcm_state(dev->handle) == SND_PCM_STATE_PREPARED) {
+          if ((err = snd_pcm_start(dev->handle)) < 0)
+            return -1;
+        }
+        else if ((err = snd_pcm_wait(dev->handle, 1000)) < 0) {
+          if (xrun_recover(csound, dev, err, play) != 0)
+            return -1;
+        }
+        continue;
+      }
+      frames = (snd_pcm_uframes_t) n;
+      if ((err = snd_pcm_mmap_begin(dev->handle, &areas, &offset,
+                                    &frames)) < 0) {
+        if (xrun_recover(csound, dev, err, play) != 0)
+          return -1;
+        continue;
+      }
+      /* interleaved: all channels are in the first area */
+      addr = (char*) areas[0].addr + (areas[0].first >> 3)
+             + (size_t) offset * (areas[0].step >> 3);
+      if (play)
+        dev->playconv((int) frames * dev->nchns, buf, addr, &dev->dither);
+      else
+        dev->rec_conv((int) frames * dev->nchns, addr, buf);
+      avail = snd_pcm_mmap_commit(dev->handle, offset, frames);
+      if (avail < 0 || (snd_pcm_uframes_t) avail != frames) {
+        if (xrun_recover(csound, dev, avail < 0 ? (int) avail : -EPIPE,
+                         play) != 0)
+          return -1;
+        if (play)               /* the frames were lost: do not resend */
+          avail = (snd_pcm_sframes_t) frames;
+        else
+          continue;
+      }
+      buf += (int) avail * dev->nchns;
+      n -= (int) avail;
+      m += (int) avail;
+    }
+    return m;
+}
+
 static int rtrecord_(CSOUND *csound, MYFLT *inbuf, int nbytes)
 {
     DEVPARAMS *dev;
@@ -756,6 +728,17 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf, int nbytes)
     /* calculate the number of samples to record */
     n = nbytes / dev->sampleSize;
 
+    if (dev->mmap) {
+      /* convert straight from the DMA area */
+      if (LIKELY((m = mmap_transfer(csound, dev, inbuf, n, 0)) >= 0))
+        return (m * dev->sampleSize);
+      csound->ErrorMsg(csound,
+                       Str("Error reading data from audio input device"));
+      snd_pcm_close(dev->handle);
+      dev->handle = NULL;
+      memset(inbuf, 0, (size_t) nbytes);
+      return nbytes;
+    }
     m = 0;
     while (n) {
       err = (int) snd_pcm_readi(dev->handle, dev->buf, (snd_pcm_uframes_t) n);
@@ -763,17 +746,8 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf, int nbytes)
         n -= err; m += err; continue;
       }
       /* handle I/O errors */
-      if (UNLIKELY(err == -EPIPE)) {
-        /* buffer underrun */
-        warning(Str("Buffer overrun in real-time audio input"));     /* complain */
-        if (snd_pcm_prepare(dev->handle) >= 0) continue;
-      }
-      else if (err == -ESTRPIPE) {
-        /* suspend */
-        warning(Str("Real-time audio input suspended"));
-        while (snd_pcm_resume(dev->handle) == -EAGAIN) sleep(1);
-        if (snd_pcm_prepare(dev->handle) >= 0) continue;
-      }
+      if (xrun_recover(csound, dev, err, 0) == 0)
+        continue;
       /* could not recover from error */
       csound->ErrorMsg(csound,
                        Str("Error reading data from audio input device"));
@@ -799,8 +773,18 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf, int nbytes)
     /* calculate the number of samples to play */
     n = nbytes / dev->sampleSize;
 
+    if (dev->mmap) {
+      /* convert straight into the DMA area */
+      if (LIKELY(mmap_transfer(csound, dev, (MYFLT*) outbuf, n, 1) >= 0))
+        return;
+      csound->ErrorMsg(csound,
+                       Str("Error writing data to audio output device"));
+      snd_pcm_close(dev->handle);
+      dev->handle = NULL;
+      return;
+    }
     /* convert samples from MYFLT */
-    dev->playconv(n * dev->nchns, (MYFLT*) outbuf, dev->buf, &(dev->seed));
+    dev->playconv(n * dev->nchns, outbuf, dev->buf, &dev->dither);
 
     while (n) {
       err = (int) snd_pcm_writei(dev->handle, dev->buf, (snd_pcm_uframes_t) n);
@@ -808,17 +792,8 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf, int nbytes)
         n -= err; continue;
       }
       /* handle I/O errors */
-      if (err == -EPIPE) {
-        /* buffer underrun */
-        warning(Str("Buffer underrun in real-time audio output"));   /* complain */
-        if (snd_pcm_prepare(dev->handle) >= 0) continue;
-      }
-      else if (err == -ESTRPIPE) {
-        /* suspend */
-        warning(Str("Real-time audio output suspended"));
-        while (snd_pcm_resume(dev->handle) == -EAGAIN) sleep(1);
-        if (snd_pcm_prepare(dev->handle) >= 0) continue;
-      }
+      if (xrun_recover(csound, dev, err, 1) == 0)
+        continue;
       /* could not recover from error */
       csound->ErrorMsg(csound,
                        Str("Error writing data to audio output device"));
@@ -1643,6 +1618,16 @@ PUBLIC int csoundModuleCreate(CSOUND *csound)
                                         CSOUNDCFG_INTEGER, 0, &minsched, &maxsched,
                                         Str("RT scheduler priority, alsa module"),
                                         NULL);
+    if (csound->CreateGlobalVariable(csound, "_alsaMmap", sizeof(int)) == 0) {
+      int *mm = (int*) csound->QueryGlobalVariable(csound, "_alsaMmap");
+      int zero = 0, one = 1;
+      *mm = 1;
+      csound->CreateConfigurationVariable(csound, "alsa_mmap", mm,
+                                          CSOUNDCFG_INTEGER, 0, &zero, &one,
+                                          Str("Use mmap access for ALSA audio "
+                                              "if the device supports it "
+                                              "(default: 1)"), NULL);
+    }
     maxlen = 64;
     alsaseq_client = (char*) csound->Calloc(csound, maxlen*sizeof(char));
     strcpy(alsaseq_client, "Csound");
@@ -177,6 +177,7 @@ static inline void rtJack_DestroyLock(CSOUND *csound, void **p)
 static CS_NORETURN void rtJack_Error(CSOUND *, int errCode, const char *msg);
 
 static int processCallback(jack_nframes_t nframes, void *arg);
+static void rtJack_Driver(CSOUND *csound, void *userData, int run);
 
 /* callback functions */
 
@@ -234,6 +235,14 @@ static void shutDownCallback(void *arg)
     RtJackGlobals *p = (RtJackGlobals*) arg;
 
     p->jackState = 2;
+    if (p->callbackMode) {
+      /* nothing will call PerformDriven() any more: end the performance */
+      if (p->cbRun) {
+        p->cbRun = 0;
+        p->csound->PerformDriven(p->csound, 1);
+      }
+      return;
+    }
     if (p->bufs != NULL) {
       int   i;
       for (i = 0; i < p->nBuffers; i++) {
@@ -411,7 +420,27 @@ static void openJackStreams(RtJackGlobals *p)
       p->nBuffers = 2;
     if (UNLIKELY((unsigned int) (p->nBuffers * p->bufSize) > (unsigned int) 65536))
       rtJack_Error(csound, -1, Str("invalid buffer size (-B)"));
-    if (UNLIKELY(((p->nBuffers - 1) * p->bufSize)
+    if (p->callbackMode && !p->outputEnabled) {
+      csound->Warning(csound, "%s", Str("rtjack: jack_callback needs audio "
+                                        "output; using the ring buffers\n"));
+      p->callbackMode = 0;
+    }
+    if (p->callbackMode) {
+      /* Csound runs in the process callback, so each JACK period must be
+         a whole number of -b periods, and -b of k-cycles */
+      int period = (int) jack_get_buffer_size(p->client);
+      int ksmps = (int) csound->GetKsmps(csound);
+      if (period % p->bufSize != 0 || p->bufSize % ksmps != 0) {
+        csound->Warning(csound,
+                        Str("rtjack: period size (-b %d) must divide the JACK "
+                            "period (%d) and be a multiple of ksmps (%d) "
+                            "for jack_callback; using the ring buffers\n"),
+                        p->bufSize, period, ksmps);
+        p->callbackMode = 0;
+      }
+    }
+    if (UNLIKELY(!p->callbackMode &&
+                 ((p->nBuffers - 1) * p->bufSize)
                  < (int) jack_get_buffer_size(p->client)))
       rtJack_Error(csound, -1, Str("buffer size (-B) is too small"));
 
@@ -470,6 +499,10 @@ static void openJackStreams(RtJackGlobals *p)
                                            processCallback, (void*) p) != 0))
       rtJack_Error(csound, -1, Str("error setting process callback"));
 
+    /* let the process callback run the k-cycles */
+    if (p->callbackMode)
+      csound->SetPerformDriver(csound, rtJack_Driver, (void*) p);
+
     /* activate client */
     if (UNLIKELY(jack_activate(p->client) != 0))
       rtJack_Error(csound, -1, Str("error activating JACK client"));
@@ -702,6 +735,52 @@ static int playopen_(CSOUND *csound, const csRtAudioParams *parm)
     return 0;
 }
 
+/* called by Csound when performance starts (run = 1) and ends (run = 0) */
+/* in callback mode */
+
+static void rtJack_Driver(CSOUND *csound, void *userData, int run)
+{
+    RtJackGlobals *p = (RtJackGlobals*) userData;
+
+    (void) csound;
+    p->cbRun = run;
+}
+
+/* in callback mode the process callback performs the k-cycles itself, */
+/* with rtrecord_ and rtplay_ reading and writing the port buffers */
+
+static int processCallbackDriven(RtJackGlobals *p, jack_nframes_t nframes)
+{
+    CSOUND        *csound = p->csound;
+    int           i, j, ksmps = (int) csound->GetKsmps(csound);
+
+    for (i = 0; i < p->nChannels; i++)
+      p->outPortBufs[i] = (jack_default_audio_sample_t*)
+        jack_port_get_buffer(p->outPorts[i], nframes);
+    if (p->inputEnabled) {
+      for (i = 0; i < p->nChannels_i; i++)
+        p->inPortBufs[i] = (jack_default_audio_sample_t*)
+          jack_port_get_buffer(p->inPorts[i], nframes);
+    }
+    p->cbFrames = (int) nframes;
+    p->cbInPos = p->cbOutPos = 0;
+    if (p->cbRun && (int) nframes % p->bufSize == 0) {
+      for (i = 0; i < (int) nframes; i += ksmps) {
+        if (csound->PerformDriven(csound, 0) != 0) {
+          p->cbRun = 0;
+          break;
+        }
+      }
+    }
+    else if (p->cbRun)
+      p->xrunFlag = 1;          /* period changed to an unusable size */
+    /* silence whatever Csound did not write */
+    for (j = 0; j < p->nChannels; j++)
+      for (i = p->cbOutPos; i < (int) nframes; i++)
+        p->outPortBufs[j][i] = (jack_default_audio_sample_t) 0;
+    return 0;
+}
+
 /* the process callback is called by the JACK client thread, */
 /* and copies data to the input and from the output ring buffers */
 
@@ -711,6 +790,8 @@ static int processCallback(jack_nframes_t nframes, void *arg)
     int           i, j, k, l;
 
     p = (RtJackGlobals*) arg;
+    if (p->callbackMode)
+      return processCallbackDriven(p, nframes);
     /* get pointers to port buffers */
     if (p->inputEnabled) {
       for (i = 0; i < p->nChannels_i; i++)
@@ -801,7 +882,7 @@ static CS_NOINLINE void rtJack_Restart(RtJackGlobals *p)
 static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
 {
     RtJackGlobals *p;
-    int           i, j, k, nframes, bufpos, bufcnt;
+    int           i, n, nframes, bufpos, bufcnt;
 
     p = (RtJackGlobals*) *(csound->GetRtPlayUserData(csound));
     if (UNLIKELY(p==NULL)) rtJack_Abort(csound, 0);
@@ -814,9 +895,21 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
         rtJack_Abort(csound, p->jackState);
     }
     nframes = bytes_ / (p->nChannels_i * (int) sizeof(MYFLT));
+    if (p->callbackMode) {
+      /* called from the process callback: read the port buffers */
+      n = p->cbFrames - p->cbInPos;
+      n = (n < 0 ? 0 : (n > nframes ? nframes : n));
+      p->conv->Interleave(n, p->nChannels_i, p->inPortBufs, p->cbInPos,
+                          inbuf_);
+      if (n < nframes)
+        memset(inbuf_ + n * p->nChannels_i, 0,
+               (nframes - n) * p->nChannels_i * sizeof(MYFLT));
+      p->cbInPos += nframes;
+      return bytes_;
+    }
     bufpos = p->csndBufPos;
     bufcnt = p->csndBufCnt;
-    for (i = j = 0; i < nframes; i++) {
+    for (i = 0; i < nframes; i += n) {
       if (bufpos == 0) {
         /* wait until there is enough data in ring buffer */
         /* VL 28.03.15 -- timeout after wait for 10 buffer
@@ -832,10 +925,12 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
           return bytes_;
         }
       }
-      /* copy audio data */
-      for (k = 0; k < p->nChannels_i; k++)
-        inbuf_[j++] = (MYFLT) p->bufs[bufcnt]->inBufs[k][i];
-      if (++bufpos >= p->bufSize) {
+      /* copy audio data, up to the end of this buffer */
+      n = p->bufSize - bufpos;
+      n = (n > nframes - i ? nframes - i : n);
+      p->conv->Interleave(n, p->nChannels_i, p->bufs[bufcnt]->inBufs, bufpos,
+                          inbuf_ + i * p->nChannels_i);
+      if ((bufpos += n) >= p->bufSize) {
         bufpos = 0;
         /* notify JACK callback that this buffer has been consumed */
         if (!p->outputEnabled)
@@ -865,7 +960,7 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
 static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
 {
     RtJackGlobals *p;
-    int           i, j, k, nframes;
+    int           i, n, nframes;
 
     p = (RtJackGlobals*) *(csound->GetRtPlayUserData(csound));
     if (p == NULL)
@@ -878,18 +973,30 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
       return;
     }
     nframes = bytes_ / (p->nChannels * (int) sizeof(MYFLT));
-    for (i = j = 0; i < nframes; i++) {
+    if (p->callbackMode) {
+      /* called from the process callback: write the port buffers */
+      if (nframes > p->cbFrames - p->cbOutPos)
+        nframes = p->cbFrames - p->cbOutPos;
+      if (nframes > 0) {
+        p->conv->Deinterleave(nframes, p->nChannels, outbuf_, p->outPortBufs,
+                              p->cbOutPos);
+        p->cbOutPos += nframes;
+      }
+      return;
+    }
+    for (i = 0; i < nframes; i += n) {
       if (p->csndBufPos == 0) {
         /* wait until there is enough free space in ring buffer */
         if (!p->inputEnabled)
           /* **** COVERITY: claims this is a double lock **** */
           rtJack_Lock(csound, &(p->bufs[p->csndBufCnt]->csndLock));
       }
-      /* copy audio data */
-      for (k = 0; k < p->nChannels; k++)
-        p->bufs[p->csndBufCnt]->outBufs[k][i] =
-          (jack_default_audio_sample_t) outbuf_[j++];
-      if (++(p->csndBufPos) >= p->bufSize) {
+      /* copy audio data, up to the end of this buffer */
+      n = p->bufSize - p->csndBufPos;
+      n = (n > nframes - i ? nframes - i : n);
+      p->conv->Deinterleave(n, p->nChannels, outbuf_ + i * p->nChannels,
+                            p->bufs[p->csndBufCnt]->outBufs, p->csndBufPos);
+      if ((p->csndBufPos += n) >= p->bufSize) {
         p->csndBufPos = 0;
         /* notify JACK callback that this buffer is now filled */
         rtJack_Unlock(csound, &(p->bufs[p->csndBufCnt]->jackLock));
@@ -939,6 +1046,8 @@ static CS_NOINLINE void rtclose_(CSOUND *csound)
       return;
     *(csound->GetRtPlayUserData(csound))  = NULL;
     *(csound->GetRtRecordUserData(csound))  = NULL;
+    if (pp->callbackMode)
+      csound->SetPerformDriver(csound, NULL, NULL);
     memcpy(&p, pp, sizeof(RtJackGlobals));
     /* free globals */
 
@@ -1074,6 +1183,7 @@ PUBLIC int csoundModuleCreate(CSOUND *csound)
     p = (RtJackGlobals*) csound->QueryGlobalVariableNoCheck(csound,
                                                             "_rtjackGlobals");
     p->csound = csound;
+    p->conv = csound->GetSampleConverters(csound);
     p->jackState = -1;
     strcpy(&(p->clientName[0]), "csound6");
     strcpy(&(p->inputPortName[0]), "input");
@@ -1121,6 +1231,14 @@ PUBLIC int csoundModuleCreate(CSOUND *csound)
                                         (void*) &(p->sleepTime),
                                         CSOUNDCFG_INTEGER, 0, &i, &j,
                                         Str("Deprecated"), NULL);
+    /* callback mode */
+    i = 0; j = 1;               /* min/max value */
+    csound->CreateConfigurationVariable(csound, "jack_callback",
+                                        (void*) &(p->callbackMode),
+                                        CSOUNDCFG_INTEGER, 0, &i, &j,
+                                        Str("Perform in the JACK process "
+                                            "callback, without ring buffers "
+                                            "(default: 0)"), NULL);
     /* done */
     p->listclient = NULL;
 
@@ -1179,6 +1297,7 @@ typedef struct jackMidiDevice_ {
   jack_port_t *port;
   CSOUND *csound;
   void *cb;
+  int dropped;          /* messages that found the timestamped queue full */
 } jackMidiDevice;
 
 int MidiInProcessCallback(jack_nframes_t nframes, void *userData){
@@ -1186,10 +1305,26 @@ int MidiInProcessCallback(jack_nframes_t nframes, void *userData){
     jack_midi_event_t event;
     jackMidiDevice *dev = (jackMidiDevice *) userData;
     CSOUND *csound = dev->csound;
+    double sr = (double) jack_get_sample_rate(dev->client);
+    /* frames since this period started, added to each event's age */
+    jack_nframes_t late = jack_frames_since_cycle_start(dev->client);
     int n = 0;
     while(jack_midi_event_get(&event,
                               jack_port_get_buffer(dev->port,nframes),
                               n++) == 0) {
+      /* events are stamped with their frame in the last period, which
+         ended when this one started */
+      if (event.size <= 3 && (event.buffer[0] & 0x80)) {
+        switch (csound->PushMidiMessage(csound, event.buffer, (int) event.size,
+                                        (double) (nframes - event.time + late)
+                                        / sr)) {
+        case CSOUND_SUCCESS:
+          continue;
+        case CSOUND_MEMORY:             /* queue full: drop it */
+          dev->dropped++;
+          continue;
+        }
+      }
       if (UNLIKELY(csound->WriteCircularBuffer(csound,dev->cb,
                                               event.buffer,event.size)
                   != (int) event.size)){
@@ -1290,6 +1425,9 @@ static int midi_in_close(CSOUND *csound, void *userData){
     if(dev != NULL) {
       jack_port_disconnect(dev->client, dev->port);
       jack_client_close(dev->client);
+      if (UNLIKELY(dev->dropped))
+        csound->Warning(csound, Str("Jack MIDI module: %d input messages "
+                                    "dropped (queue full)"), dev->dropped);
       csound->DestroyCircularBuffer(csound, dev->cb);
       csound->Free(csound, dev);
     }
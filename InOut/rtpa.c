@@ -773,7 +773,7 @@ static int playopen_blocking(CSOUND *csound, const csRtAudioParams *parm)
 static int rtrecord_blocking(CSOUND *csound, MYFLT *inbuf, int nbytes)
 {
   DEVPARAMS *dev;
-  int       i, n, err;
+  int       n, err;
 
   dev = (DEVPARAMS*) (*(csound->GetRtRecordUserData(csound)));
   /* calculate the number of samples to record */
@@ -782,8 +782,8 @@ static int rtrecord_blocking(CSOUND *csound, MYFLT *inbuf, int nbytes)
   if (UNLIKELY(err != (int) paNoError && (csound->GetMessageLevel(csound) & 4)))
     csound->Warning(csound, "%s", Str("Buffer overrun in real-time audio input"));
   /* convert samples to MYFLT */
-  for (i = 0; i < (n * dev->nchns); i++)
-    inbuf[i] = (MYFLT) dev->buf[i];
+  csound->GetSampleConverters(csound)->FromFloat(n * dev->nchns,
+                                                 dev->buf, inbuf);
 
   return nbytes;
 }
@@ -793,14 +793,14 @@ static int rtrecord_blocking(CSOUND *csound, MYFLT *inbuf, int nbytes)
 static void rtplay_blocking(CSOUND *csound, const MYFLT *outbuf, int nbytes)
 {
   DEVPARAMS *dev;
-  int       i, n, err;
+  int       n, err;
 
   dev = (DEVPARAMS*) (*(csound->GetRtPlayUserData(csound)));
   /* calculate the number of samples to play */
   n = nbytes / (dev->nchns * (int) sizeof(MYFLT));
   /* convert samples from MYFLT */
-  for (i = 0; i < (n * dev->nchns); i++)
-    dev->buf[i] = (float) outbuf[i];
+  csound->GetSampleConverters(csound)->ToFloat(n * dev->nchns, outbuf,
+                                               dev->buf, NULL);
   err = (int) Pa_WriteStream(dev->handle, dev->buf, (unsigned long) n);
   if (UNLIKELY(err != (int) paNoError && (csound->GetMessageLevel(csound) & 4)))
     csound->Warning(csound, "%s",
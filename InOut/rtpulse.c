@@ -157,13 +157,13 @@ static int pulse_playopen(CSOUND *csound, const csRtAudioParams *parm)
 
 static void pulse_play(CSOUND *csound, const MYFLT *outbuf, int nbytes){
 
-  int i, bufsiz, pulserror;
+  int bufsiz, pulserror;
   float *buf;
   pulse_params *pulse = (pulse_params*) *(csound->GetRtPlayUserData(csound));
   //MYFLT norm = csound->e0dbfs;
   bufsiz = nbytes/sizeof(MYFLT);
   buf = pulse->buf;
-  for (i=0;i<bufsiz;i++) buf[i] = outbuf[i];
+  csound->GetSampleConverters(csound)->ToFloat(bufsiz, outbuf, buf, NULL);
   if (UNLIKELY(pa_simple_write(pulse->ps, buf,
                                bufsiz*sizeof(float), &pulserror) < 0))
     csound->ErrorMsg(csound,Str("Pulse audio module error: %s\n"),
@@ -248,7 +248,7 @@ static int pulse_recopen(CSOUND *csound, const csRtAudioParams *parm)
 
 static int pulse_record(CSOUND *csound, MYFLT *inbuf, int nbytes)
 {
-    int i, bufsiz,pulserror;
+    int bufsiz,pulserror;
     float *buf;
     pulse_params *pulse = (pulse_params*) *(csound->GetRtRecordUserData(csound)) ;
     //MYFLT norm = csound->e0dbfs;
@@ -262,7 +262,7 @@ static int pulse_record(CSOUND *csound, MYFLT *inbuf, int nbytes)
       return -1;
     }
     else {
-      for (i=0;i<bufsiz;i++) inbuf[i] = buf[i];
+      csound->GetSampleConverters(csound)->FromFloat(bufsiz, buf, inbuf);
       return nbytes;
     }
 
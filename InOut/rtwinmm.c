@@ -35,12 +35,12 @@ typedef struct rtWinMMDevice_ {
     HWAVEOUT  outDev;
     int       cur_buf;
     int       nBuffers;
-    int       seed;             /* random seed for dithering */
+    CS_DITHER dither;           /* dither state */
     int       enable_buf_timer;
     /* playback sample conversion function */
-    void      (*playconv)(int, MYFLT*, void*, int*);
+    void      (*playconv)(int, const MYFLT*, void*, CS_DITHER*);
     /* record sample conversion function */
-    void      (*rec_conv)(int, void*, MYFLT*);
+    void      (*rec_conv)(int, const void*, MYFLT*);
     int64_t   prv_time;
     float     timeConv, bufTime;
     WAVEHDR   buffers[MAXBUFFERS];
@@ -150,104 +150,6 @@ static int set_format_params(CSOUND *csound, WAVEFORMATEX *wfx,
     return 0;
 }
 
-/* sample conversion routines for playback */
-
-static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
-{
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++){
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = (((rnd) * 15625) + 1) & 0xFFFF;
-      rnd += *seed;           /* triangular distribution */
-      tmp_f = (MYFLT) ((rnd>>1) - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
-{
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = rnd;
-      tmp_f = (MYFLT) (rnd - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_short_no_dither(int nSmps, MYFLT *inBuf,
-                                     int16_t *outBuf, int *seed)
-{
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++){
-      tmp_f = inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf, int *seed)
-{
-    MYFLT   tmp_f;
-    int64_t tmp_i;
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x80000000UL;
-      tmp_i = (int64_t) (tmp_f + (tmp_f < FL(0.0) ? FL(-0.5) : FL(0.5)));
-      if (tmp_i < -((int64_t) 0x80000000UL))
-        tmp_i = -((int64_t) 0x80000000UL);
-      if (tmp_i > (int64_t) 0x7FFFFFFF) tmp_i = (int64_t) 0x7FFFFFFF;
-      outBuf[n] = (int32_t) tmp_i;
-    }
-}
-
-static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf, int *seed)
-{
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (float) inBuf[n];
-}
-
-/* sample conversion routines for recording */
-
-static void short_to_MYFLT(int nSmps, int16_t *inBuf, MYFLT *outBuf)
-{
-    while (nSmps--)
-      *(outBuf++) = (MYFLT) *(inBuf++) * (FL(1.0) / (MYFLT) 0x8000);
-}
-
-static void long_to_MYFLT(int nSmps, int32_t *inBuf, MYFLT *outBuf)
-{
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * (FL(1.0) / (MYFLT) 0x80000000UL);
-}
-
-static void float_to_MYFLT(int nSmps, float *inBuf, MYFLT *outBuf)
-{
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n];
-}
-
 static int open_device(CSOUND *csound,
                        const csRtAudioParams *parm, int is_playback)
 {
@@ -255,6 +157,7 @@ static int open_device(CSOUND *csound,
     rtWinMMDevice   *dev;
     WAVEFORMATEX    wfx;
     LARGE_INTEGER   pp;
+    const CS_SAMPCONV *conv = csound->GetSampleConverters(csound);
     int             i, ndev, devNum, conv_idx;
     DWORD           openFlags = CALLBACK_NULL;
 
@@ -323,22 +226,12 @@ static int open_device(CSOUND *csound,
         return err_msg(csound, Str("failed to open device"));
       }
       switch (conv_idx) {
-        case 0:
-          if (csound->GetDitherMode(csound)==1)
-            dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short;
-          else if (csound->GetDitherMode(csound)==2)
-            dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short_u;
-          else
-            dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short_no_dither;
-          break;
-        case 1: dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_long;   break;
-        case 2: dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_float;  break;
+        case 0: dev->playconv = conv->ToShort;  break;
+        case 1: dev->playconv = conv->ToLong;   break;
+        case 2: dev->playconv = conv->ToFloat;  break;
       }
+      conv->InitDither(&(dev->dither), (conv_idx == 0 ?
+                                        csound->GetDitherMode(csound) : 0));
     }
     else {
       p->inDev = dev;
@@ -352,12 +245,9 @@ static int open_device(CSOUND *csound,
         return err_msg(csound, Str("failed to open device"));
       }
       switch (conv_idx) {
-        case 0: dev->rec_conv =
-                  (void (*)(int, void*, MYFLT*)) short_to_MYFLT;  break;
-        case 1: dev->rec_conv =
-                  (void (*)(int, void*, MYFLT*)) long_to_MYFLT;   break;
-        case 2: dev->rec_conv =
-                  (void (*)(int, void*, MYFLT*)) float_to_MYFLT;  break;
+        case 0: dev->rec_conv = conv->FromShort;  break;
+        case 1: dev->rec_conv = conv->FromLong;   break;
+        case 2: dev->rec_conv = conv->FromFloat;  break;
       }
     }
     if (UNLIKELY(allocate_buffers(csound, dev, parm, is_playback) != 0))
@@ -430,7 +320,7 @@ static void rtplay_(CSOUND *csound, const MYFLT *outBuf, int nbytes)
     while (!(*dwFlags & WHDR_DONE))
       Sleep(1);
     dev->playconv(nbytes / (int) sizeof(MYFLT),
-                  (MYFLT*) outBuf, (void*) buf->lpData, &(dev->seed));
+                  outBuf, (void*) buf->lpData, &(dev->dither));
     waveOutWrite(dev->outDev, (LPWAVEHDR) buf, sizeof(WAVEHDR));
     if (++(dev->cur_buf) >= dev->nBuffers)
       dev->cur_buf = 0;
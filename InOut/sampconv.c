@@ -0,0 +1,310 @@
+/*
+    sampconv.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Sample format conversion and dither, shared by sound file output and
+   the real-time audio modules (through csound->GetSampleConverters()).
+
+   The loops are plain C written so that the compiler vectorises them: no
+   calls or branches on the sample data, clamping with conditional moves,
+   and rounding by an offset and truncation.  Dither noise comes from
+   CS_DITHER_LANES independent generators, one per position in a block,
+   rather than from one serial generator.  Every routine is compiled
+   once for the baseline instruction set (SSE2 on x86-64, NEON on
+   AArch64) and, on x86, once more for AVX2; the set used is chosen the
+   first time the table is asked for. */
+
+#include "csoundCore.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPCONV_AVX2   1
+#endif
+
+#ifdef __GNUC__
+#define CONV_INLINE     static inline __attribute__ ((__always_inline__))
+#else
+#define CONV_INLINE     static inline
+#endif
+
+#ifndef USE_DOUBLE
+#define LONG_MAX_F      FL(2147483520.0)    /* largest float below 2^31 */
+#else
+#define LONG_MAX_F      FL(2147483647.0)
+#endif
+
+static void init_dither(CS_DITHER *d, int type)
+{
+    int     l;
+    for (l = 0; l < CS_DITHER_LANES; l++)
+      d->seed[l] = (uint32_t) l * 0x9E3779B9U + 1U;
+    d->type = type;
+}
+
+CONV_INLINE uint32_t dither_rnd(uint32_t *seed)
+{
+    return (*seed = *seed * 1664525U + 1013904223U) >> 16;
+}
+
+/* one block of noise in LSBs: triangular (+/- 1/2) or rectangular */
+
+CONV_INLINE void dither_block(CS_DITHER *d, MYFLT *tmp)
+{
+    int     l;
+    if (d->type == 1) {
+      for (l = 0; l < CS_DITHER_LANES; l++) {
+        int rnd = (int) dither_rnd(&d->seed[l]);
+        rnd += (int) dither_rnd(&d->seed[l]);
+        tmp[l] = (MYFLT) (rnd - 0x10000) * (FL(1.0) / (MYFLT) 0x20000);
+      }
+    }
+    else {
+      for (l = 0; l < CS_DITHER_LANES; l++)
+        tmp[l] = (MYFLT) ((int) dither_rnd(&d->seed[l]) - 0x8000)
+                 * (FL(1.0) / (MYFLT) 0x10000);
+    }
+}
+
+/* scaled samples to integers, rounded and clamped: the offset keeps the
+   value positive, so that truncation rounds it */
+
+CONV_INLINE int16_t conv_short(MYFLT x)
+{
+    x += FL(32768.5);
+    x = (x < FL(0.0) ? FL(0.0) : x);
+    x = (x > FL(65535.0) ? FL(65535.0) : x);
+    return (int16_t) ((int) x - 0x8000);
+}
+
+CONV_INLINE int32_t conv_int24(MYFLT x)
+{
+    x += FL(8388608.5);
+    x = (x < FL(0.0) ? FL(0.0) : x);
+    x = (x > FL(16777215.0) ? FL(16777215.0) : x);
+    return (int32_t) ((uint32_t) ((int32_t) x - 0x800000) << 8);
+}
+
+/* 32 bit is truncated: the error is far below anything audible */
+
+CONV_INLINE int32_t conv_long(MYFLT x)
+{
+    x = (x < FL(-2147483648.0) ? FL(-2147483648.0) : x);
+    x = (x > LONG_MAX_F ? LONG_MAX_F : x);
+    return (int32_t) x;
+}
+
+CONV_INLINE void to_short(int n, const MYFLT *in, void *out_, CS_DITHER *d)
+{
+    int16_t *out = (int16_t*) out_;
+    MYFLT   tmp[CS_DITHER_LANES];
+    int     i, l, m;
+
+    if (d == NULL || d->type == 0) {
+      for (i = 0; i < n; i++)
+        out[i] = conv_short(in[i] * FL(32768.0));
+      return;
+    }
+    for (i = 0; i < n; i += CS_DITHER_LANES) {
+      m = (n - i < CS_DITHER_LANES ? n - i : CS_DITHER_LANES);
+      dither_block(d, tmp);
+      for (l = 0; l < m; l++)
+        out[i + l] = conv_short(in[i + l] * FL(32768.0) + tmp[l]);
+    }
+}
+
+CONV_INLINE void to_int24(int n, const MYFLT *in, void *out_, CS_DITHER *d)
+{
+    int32_t *out = (int32_t*) out_;
+    MYFLT   tmp[CS_DITHER_LANES];
+    int     i, l, m;
+
+    if (d == NULL || d->type == 0) {
+      for (i = 0; i < n; i++)
+        out[i] = conv_int24(in[i] * FL(8388608.0));
+      return;
+    }
+    for (i = 0; i < n; i += CS_DITHER_LANES) {
+      m = (n - i < CS_DITHER_LANES ? n - i : CS_DITHER_LANES);
+      dither_block(d, tmp);
+      for (l = 0; l < m; l++)
+        out[i + l] = conv_int24(in[i + l] * FL(8388608.0) + tmp[l]);
+    }
+}
+
+CONV_INLINE void to_long(int n, const MYFLT *in, void *out_, CS_DITHER *d)
+{
+    int32_t *out = (int32_t*) out_;
+    int     i;
+    (void) d;
+    for (i = 0; i < n; i++)
+      out[i] = conv_long(in[i] * FL(2147483648.0));
+}
+
+CONV_INLINE void to_float(int n, const MYFLT *in, void *out_, CS_DITHER *d)
+{
+    float   *out = (float*) out_;
+    int     i;
+    (void) d;
+    for (i = 0; i < n; i++)
+      out[i] = (float) in[i];
+}
+
+CONV_INLINE void from_short(int n, const void *in_, MYFLT *out)
+{
+    const int16_t *in = (const int16_t*) in_;
+    int     i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i] * (FL(1.0) / FL(32768.0));
+}
+
+CONV_INLINE void from_int24(int n, const void *in_, MYFLT *out)
+{
+    const int32_t *in = (const int32_t*) in_;
+    int     i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) (in[i] >> 8) * (FL(1.0) / FL(8388608.0));
+}
+
+CONV_INLINE void from_long(int n, const void *in_, MYFLT *out)
+{
+    const int32_t *in = (const int32_t*) in_;
+    int     i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i] * (FL(1.0) / FL(2147483648.0));
+}
+
+CONV_INLINE void from_float(int n, const void *in_, MYFLT *out)
+{
+    const float *in = (const float*) in_;
+    int     i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i];
+}
+
+CONV_INLINE void deinterleave(int nframes, int nchnls, const MYFLT *in,
+                              float **out, int ofs)
+{
+    int     i, c;
+    if (nchnls == 1) {
+      float *o = out[0] + ofs;
+      for (i = 0; i < nframes; i++)
+        o[i] = (float) in[i];
+      return;
+    }
+    for (c = 0; c < nchnls; c++) {
+      float       *o = out[c] + ofs;
+      const MYFLT *p = in + c;
+      for (i = 0; i < nframes; i++)
+        o[i] = (float) p[i * nchnls];
+    }
+}
+
+CONV_INLINE void interleave(int nframes, int nchnls, float **in, int ofs,
+                            MYFLT *out)
+{
+    int     i, c;
+    if (nchnls == 1) {
+      const float *p = in[0] + ofs;
+      for (i = 0; i < nframes; i++)
+        out[i] = (MYFLT) p[i];
+      return;
+    }
+    for (c = 0; c < nchnls; c++) {
+      const float *p = in[c] + ofs;
+      MYFLT       *o = out + c;
+      for (i = 0; i < nframes; i++)
+        o[i * nchnls] = (MYFLT) p[i];
+    }
+}
+
+CONV_INLINE void add_dither(int n, MYFLT *buf, MYFLT lsb, CS_DITHER *d)
+{
+    MYFLT   tmp[CS_DITHER_LANES];
+    int     i, l, m;
+
+    if (d->type == 0)
+      return;
+    for (i = 0; i < n; i += CS_DITHER_LANES) {
+      m = (n - i < CS_DITHER_LANES ? n - i : CS_DITHER_LANES);
+      dither_block(d, tmp);
+      for (l = 0; l < m; l++)
+        buf[i + l] += tmp[l] * lsb;
+    }
+}
+
+/* the table for one instruction set */
+
+#define SAMPCONV_TABLE(isa, attr)                                             \
+attr static void isa##_to_short(int n, const MYFLT *in, void *out,            \
+                                CS_DITHER *d)                                 \
+{   to_short(n, in, out, d);    }                                             \
+attr static void isa##_to_int24(int n, const MYFLT *in, void *out,            \
+                                CS_DITHER *d)                                 \
+{   to_int24(n, in, out, d);    }                                             \
+attr static void isa##_to_long(int n, const MYFLT *in, void *out,             \
+                               CS_DITHER *d)                                  \
+{   to_long(n, in, out, d);     }                                             \
+attr static void isa##_to_float(int n, const MYFLT *in, void *out,            \
+                                CS_DITHER *d)                                 \
+{   to_float(n, in, out, d);    }                                             \
+attr static void isa##_from_short(int n, const void *in, MYFLT *out)          \
+{   from_short(n, in, out);     }                                             \
+attr static void isa##_from_int24(int n, const void *in, MYFLT *out)          \
+{   from_int24(n, in, out);     }                                             \
+attr static void isa##_from_long(int n, const void *in, MYFLT *out)           \
+{   from_long(n, in, out);      }                                             \
+attr static void isa##_from_float(int n, const void *in, MYFLT *out)          \
+{   from_float(n, in, out);     }                                             \
+attr static void isa##_deinterleave(int nframes, int nchnls,                  \
+                                    const MYFLT *in, float **out, int ofs)    \
+{   deinterleave(nframes, nchnls, in, out, ofs);        }                     \
+attr static void isa##_interleave(int nframes, int nchnls, float **in,        \
+                                  int ofs, MYFLT *out)                        \
+{   interleave(nframes, nchnls, in, ofs, out);          }                     \
+attr static void isa##_dither(int n, MYFLT *buf, MYFLT lsb, CS_DITHER *d)     \
+{   add_dither(n, buf, lsb, d); }                                             \
+static const CS_SAMPCONV sampconv_##isa = {                                   \
+    #isa, init_dither,                                                        \
+    isa##_to_short, isa##_to_int24, isa##_to_long, isa##_to_float,            \
+    isa##_from_short, isa##_from_int24, isa##_from_long, isa##_from_float,    \
+    isa##_deinterleave, isa##_interleave, isa##_dither                        \
+};
+
+SAMPCONV_TABLE(generic, )
+#ifdef SAMPCONV_AVX2
+SAMPCONV_TABLE(avx2, __attribute__ ((__target__ ("avx2"))))
+#endif
+
+/* Returns the conversion routines for the host CPU. */
+
+const CS_SAMPCONV *csoundGetSampleConverters(CSOUND *csound)
+{
+    static const CS_SAMPCONV *conv = NULL;
+    (void) csound;
+    if (UNLIKELY(conv == NULL)) {
+#ifdef SAMPCONV_AVX2
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        conv = &sampconv_avx2;
+      else
+#endif
+        conv = &sampconv_generic;
+    }
+    return conv;
+}
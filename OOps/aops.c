@@ -287,11 +287,7 @@ int32_t modkk(CSOUND *csound, AOP *p)
       r = p->r;                                        \
       a = *p->a;                                       \
       b = p->b;                                        \
-      if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT)); \
-      if (UNLIKELY(early)) {                           \
-        nsmps -= early;                                \
-        memset(&r[nsmps], '\0', early*sizeof(MYFLT));  \
-      }                                                \
+      CS_OFFSET_CLEAR(r, offset, early, nsmps);        \
       for (n=offset; n<nsmps; n++)                     \
         r[n] = a OP b[n];                              \
       return OK;                                       \
@@ -340,12 +336,7 @@ int32_t modka(CSOUND *csound, AOP *p)
       r = p->r;                                 \
       a = p->a;                                 \
       b = *p->b;                                \
-      if (UNLIKELY(offset))                     \
-        memset(r, '\0', offset*sizeof(MYFLT));  \
-      if (UNLIKELY(early)) {                    \
-        nsmps -= early;                         \
-        memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
-      }                                         \
+      CS_OFFSET_CLEAR(r, offset, early, nsmps); \
       for (n=offset; n<nsmps; n++)              \
         r[n] = a[n] OP b;                       \
       return OK;                                \
@@ -423,11 +414,7 @@ int32_t modak(CSOUND *csound, AOP *p)
     r = p->r;                                   \
     a = p->a;                                   \
     b = p->b;                                   \
-    if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT)); \
-    if (UNLIKELY(early)) {                      \
-      nsmps -= early;                           \
-      memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
-    }                                           \
+    CS_OFFSET_CLEAR(r, offset, early, nsmps);   \
     for (n=offset; n<nsmps; n++)                \
       r[n] = a[n] OP b[n];                      \
     return OK;                                  \
@@ -485,6 +472,88 @@ AA(mulaa,*)
 //AA(divaa,/)
 #endif
 
+/* Variants of the a-rate arithmetic for the common ksmps values.  With
+   a constant trip count and no offset handling the loop is fully known
+   to the compiler and vectorises without a scalar prologue.  The
+   variant is bound at orchestra compile time (create_opcode) from the
+   global ksmps, and only runs from the perf loops in kperf, which test
+   each instance once: one with a local ksmps, or with sample-accurate
+   offsets pending, runs the general function (CS_GENERIC_PERF). */
+
+#define AA_N(OPNAME,OP,N)                                       \
+  static int32_t OPNAME##_##N(CSOUND *csound, AOP *p) {         \
+    MYFLT   *r = p->r, *a = p->a, *b = p->b;                    \
+    uint32_t n;                                                 \
+    IGN(csound);                                                \
+    for (n=0; n<N; n++) r[n] = a[n] OP b[n];                    \
+    return OK;                                                  \
+  }
+
+#define AK_N(OPNAME,OP,N)                                       \
+  static int32_t OPNAME##_##N(CSOUND *csound, AOP *p) {         \
+    MYFLT   *r = p->r, *a = p->a, b = *p->b;                    \
+    uint32_t n;                                                 \
+    IGN(csound);                                                \
+    for (n=0; n<N; n++) r[n] = a[n] OP b;                       \
+    return OK;                                                  \
+  }
+
+#define KA_N(OPNAME,OP,N)                                       \
+  static int32_t OPNAME##_##N(CSOUND *csound, AOP *p) {         \
+    MYFLT   *r = p->r, a = *p->a, *b = p->b;                    \
+    uint32_t n;                                                 \
+    IGN(csound);                                                \
+    for (n=0; n<N; n++) r[n] = a OP b[n];                       \
+    return OK;                                                  \
+  }
+
+#define KSMPS_VARIANTS(M,OPNAME,OP)                             \
+  M(OPNAME,OP,16) M(OPNAME,OP,32) M(OPNAME,OP,64)               \
+  M(OPNAME,OP,128) M(OPNAME,OP,256)
+
+KSMPS_VARIANTS(AA_N,addaa,+)
+KSMPS_VARIANTS(AA_N,subaa,-)
+KSMPS_VARIANTS(AA_N,mulaa,*)
+KSMPS_VARIANTS(AK_N,addak,+)
+KSMPS_VARIANTS(AK_N,subak,-)
+KSMPS_VARIANTS(AK_N,mulak,*)
+KSMPS_VARIANTS(KA_N,addka,+)
+KSMPS_VARIANTS(KA_N,subka,-)
+KSMPS_VARIANTS(KA_N,mulka,*)
+
+#define KSMPS_ENTRY(OPNAME)                                     \
+  { (SUBR) OPNAME, { (SUBR) OPNAME##_16, (SUBR) OPNAME##_32,    \
+                     (SUBR) OPNAME##_64, (SUBR) OPNAME##_128,   \
+                     (SUBR) OPNAME##_256 } }
+
+static const struct {
+    SUBR    generic;
+    SUBR    fixed[5];               /* ksmps 16, 32, 64, 128, 256 */
+} ksmps_variants[] = {
+    KSMPS_ENTRY(addaa), KSMPS_ENTRY(subaa), KSMPS_ENTRY(mulaa),
+    KSMPS_ENTRY(addak), KSMPS_ENTRY(subak), KSMPS_ENTRY(mulak),
+    KSMPS_ENTRY(addka), KSMPS_ENTRY(subka), KSMPS_ENTRY(mulka)
+};
+
+/* Return the variant of perf specialised for ksmps, or NULL if none */
+SUBR aops_ksmps_variant(SUBR perf, uint32_t ksmps)
+{
+    size_t  i;
+    int32_t k;
+    switch (ksmps) {
+    case 16:  k = 0; break;
+    case 32:  k = 1; break;
+    case 64:  k = 2; break;
+    case 128: k = 3; break;
+    case 256: k = 4; break;
+    default:  return NULL;
+    }
+    for (i = 0; i < sizeof(ksmps_variants)/sizeof(ksmps_variants[0]); i++)
+      if (ksmps_variants[i].generic == perf)
+        return ksmps_variants[i].fixed[k];
+    return NULL;
+}
+
 int32_t divaa(CSOUND *csound, AOP *p)
 {
     MYFLT   *r, *a, *b;
@@ -1923,6 +1992,51 @@ int32_t outq4(CSOUND *csound, OUTM *p)
     return OK;
 }
 
+/* outn() for voices of an instrument that steals voices (see maxalloc):
+   sums the output power of the instance for VOICE_STEAL_QUIETEST, and
+   fades out a stolen voice linearly over its stealcyc k-cycles.  Both
+   count the cycles of the instance, which differ from the global ones
+   under a local ksmps. */
+
+static int32_t outn_steal(CSOUND *csound, uint32_t n, OUTX *p,
+                          uint32_t offset, uint32_t early)
+{
+    INSDS    *ip = p->h.insdshead;
+    uint32_t nsmps = CS_KSMPS, i, j, k = 0;
+    MYFLT    *spout = CS_SPOUT, g = FL(1.0), dg = FL(0.0), acc = FL(0.0);
+
+    if (ip->stealcyc) {
+      int64_t pos = (int64_t) (ip->kcounter - ip->stealkcnt) - 1;
+      if (pos < 0) pos = 0;
+      dg = -FL(1.0) / ((MYFLT) ip->stealcyc * nsmps);
+      g = FL(1.0) + dg * (MYFLT) (pos * nsmps);
+      if (g <= FL(0.0)) g = dg = FL(0.0);
+    }
+    if (ip->mskcnt != ip->kcounter) {           /* first out this k-cycle */
+      ip->outms = ip->outacc;
+      ip->outacc = FL(0.0);
+      ip->mskcnt = ip->kcounter;
+    }
+    CSOUND_SPOUT_SPINLOCK
+    if (!csound->spoutactive) {
+      memset(spout, '\0', csound->nspout*sizeof(MYFLT));
+      csound->spoutactive = 1;
+    }
+    for (i=0; i<n; i++) {
+      MYFLT gg = g;
+      for (j=offset; j<early; j++) {
+        MYFLT x = p->asig[i][j];
+        acc += x * x;
+        spout[k + j] += gg * x;
+        gg += dg;
+      }
+      k += nsmps;
+    }
+    CSOUND_SPOUT_SPINUNLOCK
+    ip->outacc += acc / nsmps;
+    return OK;
+}
+
 inline static int32_t outn(CSOUND *csound, uint32_t n, OUTX *p)
 {
     uint32_t nsmps = CS_KSMPS,  i, j, k=0;
@@ -1932,6 +2046,10 @@ inline static int32_t outn(CSOUND *csound, uint32_t n, OUTX *p)
         if (UNLIKELY((offset|early))) {
           printf("OUT; spout=%p early=%d offset=%d\n", spout, early, offset);}
     early = nsmps - early;
+    if (UNLIKELY(p->h.insdshead->stealcyc ||
+                 (p->h.insdshead->instr != NULL &&
+                  p->h.insdshead->instr->steal == VOICE_STEAL_QUIETEST)))
+      return outn_steal(csound, n, p, offset, early);
     CSOUND_SPOUT_SPINLOCK
 
     if (!csound->spoutactive) {
@@ -24,6 +24,7 @@
 #include "csoundCore.h"
 #include "soundio.h"
 #include "diskin2.h"
+#include "envvar.h"
 #include <math.h>
 #include <inttypes.h>
 
@@ -33,6 +34,52 @@ typedef struct DISKIN_INST_ {
   struct DISKIN_INST_ *nxt;
 } DISKIN_INST;
 
+/* reads 'nsmps' mono samples from sample frame 'pos' of the file, through
+   the decode-ahead stream if there is one */
+
+static int32_t diskin2_read_file(CSOUND *csound, SNDFILE *sf, void *stream,
+                                 int32_t pos, MYFLT *buf, int32_t nsmps,
+                                 int32_t nChannels)
+{
+    if (stream != NULL)
+      return csoundStreamRead(csound, stream, (int64_t) pos, buf,
+                              nsmps / nChannels) * nChannels;
+    sf_seek(sf, (sf_count_t) pos, SEEK_SET);
+    return (int32_t) sf_read_MYFLT(sf, buf, (sf_count_t) nsmps);
+}
+
+/* compressed files read synchronously are decoded ahead by the I/O
+   thread, in a ring of at least four buffers */
+
+static void *diskin2_stream_open(CSOUND *csound, SNDFILE *sf, void *fd,
+                                 SF_INFO *sfinfo, int32_t bufSize,
+                                 int32_t wrapMode)
+{
+    /* the pitch can be negative: keep frames behind the reader too */
+    int32_t flags = (wrapMode ? CS_STREAM_LOOP : 0) | CS_STREAM_BACK;
+    if (!TYP_IS_COMPRESSED(SF2TYPE(sfinfo->format)))
+      return NULL;
+    if (!csound->oparms->realtime)
+      flags |= CS_STREAM_WAIT;
+    return csoundSndfileStreamOpen(csound, sf, csound->GetFileName(fd),
+                                   sfinfo->channels, (int64_t) sfinfo->frames,
+                                   4 * bufSize > csound->esr ? 4 * bufSize : 0,
+                                   flags);
+}
+
+static int32_t diskin2_stream_deinit(CSOUND *csound, void *p)
+{
+    csoundStreamClose(csound, ((DISKIN2*) p)->stream);
+    ((DISKIN2*) p)->stream = NULL;
+    return OK;
+}
+
+static int32_t diskin2_stream_deinit_array(CSOUND *csound, void *p)
+{
+    csoundStreamClose(csound, ((DISKIN2_ARRAY*) p)->stream);
+    ((DISKIN2_ARRAY*) p)->stream = NULL;
+    return OK;
+}
 
 static CS_NOINLINE void diskin2_read_buffer(CSOUND *csound,
                                             DISKIN2 *p, int32_t bufReadPos)
@@ -40,7 +87,6 @@ static CS_NOINLINE void diskin2_read_buffer(CSOUND *csound,
     MYFLT *tmp;
     int32_t nsmps;
     int32_t i;
-    IGN(csound);
     /* swap buffer pointers */
     tmp = p->buf;
     p->buf = p->prvBuf;
@@ -67,10 +113,10 @@ static CS_NOINLINE void diskin2_read_buffer(CSOUND *csound,
       if (nsmps > 0L) {         /* if there is anything to read: */
         if (nsmps > (int32_t) p->bufSize)
           nsmps = (int32_t) p->bufSize;
-        nsmps *= (int32_t) p->nChannels;
-        sf_seek(p->sf, (sf_count_t) p->bufStartPos, SEEK_SET);
         /* convert sample count to mono samples and read file */
-        i = (int32_t)sf_read_MYFLT(p->sf, p->buf, (sf_count_t) nsmps);
+        nsmps *= (int32_t) p->nChannels;
+        i = diskin2_read_file(csound, p->sf, p->stream, p->bufStartPos,
+                              p->buf, nsmps, p->nChannels);
         if (UNLIKELY(i < 0))  /* error ? */
           i = 0;    /* clear entire buffer to zero */
       }
@@ -315,6 +361,10 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
       /* skip initialisation if requested */
       if (p->SkipInit != FL(0.0))
         return OK;
+      if (p->stream != NULL) {
+        csoundStreamClose(csound, p->stream);
+        p->stream = NULL;
+      }
       csound_fd_close(csound, &(p->fdch));
     }
     /* set default format parameters */
@@ -489,6 +539,15 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
       p->aOut_buf = NULL;
       p->aOut_bufsize = 0;
       p->async = 0;
+      p->stream = diskin2_stream_open(csound, p->sf, fd, &sfinfo, p->bufSize,
+                                      p->wrapMode);
+      if (p->stream != NULL) {
+        csound->RegisterDeinitCallback(csound, p, diskin2_stream_deinit);
+        /* decode from the skip time now, not on the first k-cycle */
+        csoundStreamSeek(csound, p->stream,
+                         (int64_t) ((p->pos_frac >> POS_FRAC_SHIFT)
+                                    & ~((int64_t) p->bufSize - 1)));
+      }
       /* print file information */
       if (UNLIKELY((csound->oparms_.msglevel & 7) == 7)) {
         csound->Message(csound, "%s '%s':\n"
@@ -1014,7 +1073,9 @@ static int32_t soundout_deinit(CSOUND *csound, void *pp)
       /* flush buffer */
       MYFLT *p0 = (MYFLT*) &(q->outbuf[0]);
       MYFLT *p1 = (MYFLT*) q->outbufp;
-      if (p1 > p0) {
+      if (p1 > p0 && q->async)
+        csound->WriteAsync(csound, q->fd, p0, (int) (p1 - p0));
+      else if (p1 > p0) {
         sf_write_MYFLT(q->sf, p0, (sf_count_t) ((MYFLT*) p1 - (MYFLT*) p0));
         q->outbufp = (MYFLT*) &(q->outbuf[0]);
       }
@@ -1085,6 +1146,18 @@ static int32_t sndo1set_(CSOUND *csound, void *pp, int32_t stringname)
                                opname, MYFLT2LONG(*iformat));
     }
     sfinfo.format = TYPE2SF(filetyp) | FORMAT2SF(format);
+    /* in real-time mode the writes are left to the I/O thread */
+    q->async = (csound->oparms->realtime != 0);
+    if (q->async &&
+        (q->fd = csound->FileOpenAsync(csound, &(q->sf), CSFILE_SND_W, sfname,
+                                       &sfinfo, "SFDIR",
+                                       csound->type2csfiletype(filetyp, format),
+                                       SNDOUTSMPS, 0)) == NULL)
+      q->async = 0;
+    if (!q->async)
+      q->fd = csound->FileOpen2(csound, &(q->sf), CSFILE_SND_W, sfname,
+                                &sfinfo, "SFDIR",
+                                csound->type2csfiletype(filetyp, format), 0);
     if (q->fd == NULL) {
       return csound->InitError(csound, Str("%s cannot open %s"), opname, sfname);
     }
@@ -1127,8 +1200,10 @@ int32_t soundout(CSOUND *csound, SNDOUT *p)
     if (UNLIKELY(early)) nsmps -= early;
     for (nn = offset; nn < nsmps; nn++) {
       if (UNLIKELY(p->c.outbufp >= p->c.bufend)) {
-
-        sf_write_MYFLT(p->c.sf, p->c.outbuf, p->c.bufend - p->c.outbuf);
+        if (p->c.async)
+          csound->WriteAsync(csound, p->c.fd, p->c.outbuf, SNDOUTSMPS);
+        else
+          sf_write_MYFLT(p->c.sf, p->c.outbuf, p->c.bufend - p->c.outbuf);
         p->c.outbufp = p->c.outbuf;
       }
       *(p->c.outbufp++) = p->asig[nn];
@@ -1149,7 +1224,10 @@ int32_t soundouts(CSOUND *csound, SNDOUTS *p)
     if (UNLIKELY(early)) nsmps -= early;
     for (nn = offset; nn < nsmps; nn++) {
       if (UNLIKELY(p->c.outbufp >= p->c.bufend)) {
-        sf_write_MYFLT(p->c.sf, p->c.outbuf, p->c.bufend - p->c.outbuf);
+        if (p->c.async)
+          csound->WriteAsync(csound, p->c.fd, p->c.outbuf, SNDOUTSMPS);
+        else
+          sf_write_MYFLT(p->c.sf, p->c.outbuf, p->c.bufend - p->c.outbuf);
         p->c.outbufp = p->c.outbuf;
       }
       *(p->c.outbufp++) = p->asig1[nn];
@@ -1166,7 +1244,6 @@ static CS_NOINLINE void diskin2_read_buffer_array(CSOUND *csound,
     MYFLT   *tmp;
     int32_t nsmps;
     int32_t i;
-    IGN(csound);
     /* swap buffer pointers */
     tmp = p->buf;
     p->buf = p->prvBuf;
@@ -1193,10 +1270,10 @@ static CS_NOINLINE void diskin2_read_buffer_array(CSOUND *csound,
       if (nsmps > 0L) {         /* if there is anything to read: */
         if (nsmps > (int32_t) p->bufSize)
           nsmps = (int32_t) p->bufSize;
-        nsmps *= (int32_t) p->nChannels;
-        sf_seek(p->sf, (sf_count_t) p->bufStartPos, SEEK_SET);
         /* convert sample count to mono samples and read file */
-        i = (int32_t)sf_read_MYFLT(p->sf, p->buf, (sf_count_t) nsmps);
+        nsmps *= (int32_t) p->nChannels;
+        i = diskin2_read_file(csound, p->sf, p->stream, p->bufStartPos,
+                              p->buf, nsmps, p->nChannels);
         if (UNLIKELY(i < 0))  /* error ? */
           i = 0;    /* clear entire buffer to zero */
       }
@@ -1573,6 +1650,10 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
       /* skip initialisation if requested */
       if (p->SkipInit != FL(0.0))
         return OK;
+      if (p->stream != NULL) {
+        csoundStreamClose(csound, p->stream);
+        p->stream = NULL;
+      }
       csound_fd_close(csound, &(p->fdch));
     }
     // to handle raw files number of channels
@@ -1778,6 +1859,15 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
       p->aOut_buf = NULL;
       p->aOut_bufsize = 0;
       p->async = 0;
+      p->stream = diskin2_stream_open(csound, p->sf, fd, &sfinfo, p->bufSize,
+                                      p->wrapMode);
+      if (p->stream != NULL) {
+        csound->RegisterDeinitCallback(csound, p, diskin2_stream_deinit_array);
+        /* decode from the skip time now, not on the first k-cycle */
+        csoundStreamSeek(csound, p->stream,
+                         (int64_t) ((p->pos_frac >> POS_FRAC_SHIFT)
+                                    & ~((int64_t) p->bufSize - 1)));
+      }
       /* print file information */
       if (UNLIKELY((csound->oparms_.msglevel & 7) == 7)) {
         csound->Message(csound, "%s '%s':\n"
@@ -1203,6 +1203,85 @@ int32_t oscset(CSOUND *csound, OSC *p)
     return NOTOK;
 }
 
+/* Block kernels for the table oscillators.  Phases for up to OSC_BLOCK
+   samples are produced first, then the table is read for the whole
+   block.  With a k-rate increment each phase is a closed form of its
+   index; with an a-rate increment only the integer running sum is
+   sequential.  Either way the reads carry no dependency on one another,
+   so the compiler can vectorise them (as gathers where available). */
+
+#define OSC_BLOCK 64
+
+static inline int32_t osc_phs_k(int32_t *ph, uint32_t m,
+                                int32_t phs, int32_t inc)
+{
+    uint32_t i, uphs = (uint32_t) phs, uinc = (uint32_t) inc;
+    for (i=0; i<m; i++)
+      ph[i] = (int32_t) ((uphs + i*uinc) & PHMASK);
+    return (int32_t) ((uphs + m*uinc) & PHMASK);
+}
+
+static inline int32_t osc_phs_a(int32_t *ph, uint32_t m, int32_t phs,
+                                const MYFLT *cpsp, MYFLT sicvt)
+{
+    uint32_t i;
+    for (i=0; i<m; i++) {
+      ph[i] = phs;
+      phs = (phs + MYFLT2LONG(cpsp[i] * sicvt)) & PHMASK;
+    }
+    return phs;
+}
+
+static inline void osc_read(MYFLT *ar, const int32_t *ph, uint32_t m,
+                            const FUNC *ftp, MYFLT amp, const MYFLT *ampp)
+{
+    const MYFLT *ft = ftp->ftable;
+    int32_t lobits = ftp->lobits;
+    uint32_t i;
+    if (ampp == NULL)
+      for (i=0; i<m; i++) ar[i] = ft[ph[i] >> lobits] * amp;
+    else
+      for (i=0; i<m; i++) ar[i] = ft[ph[i] >> lobits] * ampp[i];
+}
+
+static inline void osc_readi(MYFLT *ar, const int32_t *ph, uint32_t m,
+                             const FUNC *ftp, MYFLT amp, const MYFLT *ampp)
+{
+    const MYFLT *ft = ftp->ftable;
+    int32_t lobits = ftp->lobits;
+    uint32_t i;
+    for (i=0; i<m; i++) {
+      MYFLT fract = PFRAC(ph[i]);
+      const MYFLT *ftab = ft + (ph[i] >> lobits);
+      MYFLT v1 = ftab[0];
+      ar[i] = (v1 + (ftab[1] - v1) * fract) * (ampp ? ampp[i] : amp);
+    }
+}
+
+static inline void osc_read3(MYFLT *ar, const int32_t *ph, uint32_t m,
+                             const FUNC *ftp, MYFLT amp, const MYFLT *ampp)
+{
+    const MYFLT *ftab = ftp->ftable;
+    int32_t lobits = ftp->lobits, flen = (int32_t) ftp->flen;
+    uint32_t i;
+    for (i=0; i<m; i++) {
+      MYFLT fract = PFRAC(ph[i]);
+      int32_t x0 = ph[i] >> lobits;
+      /* neighbours wrap round the table; selects rather than branches */
+      MYFLT ym1 = ftab[x0 == 0 ? flen-1 : x0-1];
+      MYFLT y0 = ftab[x0], y1 = ftab[x0+1];
+      MYFLT y2 = ftab[x0+2 > flen ? 1 : x0+2];
+      MYFLT frsq = fract*fract;
+      MYFLT frcu = frsq*ym1;
+      MYFLT t1 = y2 + y0+y0+y0;
+      ar[i] = (ampp ? ampp[i] : amp) *
+        (y0 + FL(0.5)*frcu +
+         fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
+         frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) +
+         frsq*(FL(0.5)* y1 - y0));
+    }
+}
+
 int32_t koscil(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
@@ -1225,31 +1304,23 @@ int32_t koscil(CSOUND *csound, OSC *p)
 int32_t osckk(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   amp, *ar, *ftbl;
-    int32_t   phs, inc, lobits;
+    MYFLT   amp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    lobits = ftp->lobits;
     amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-
-    for (n=offset;n<nsmps;n++) {
-      ar[n] = ftbl[phs >> lobits] * amp;
-      /* phs += inc; */
-      /* phs &= PHMASK; */
-      phs = (phs+inc)&PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_read(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1261,31 +1332,24 @@ int32_t osckk(CSOUND *csound, OSC *p)
 int32_t oscka(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, *ftbl;
-    int32_t    phs, lobits;
+    MYFLT   amp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
     phs = p->lphs;
+    cpsp = p->xcps;
+    amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      ar[n] = ftbl[phs >> lobits] * amp;
-      phs += inc;
-      phs &= PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_read(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1297,28 +1361,23 @@ int32_t oscka(CSOUND *csound, OSC *p)
 int32_t oscak(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   *ar, *ampp, *ftbl;
-    int32_t    phs, inc, lobits;
+    MYFLT   *ampp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
     ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      ar[n] = ftbl[phs >> lobits] * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_read(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
@@ -1330,30 +1389,24 @@ int32_t oscak(CSOUND *csound, OSC *p)
 int32_t oscaa(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   *ar, *ampp, *cpsp, *ftbl;
-    int32_t    phs, lobits;
+    MYFLT   *ampp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
-    ampp = p->xamp;
     cpsp = p->xcps;
+    ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      ar[n] = ftbl[phs >> lobits] * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_read(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
@@ -1385,33 +1438,26 @@ int32_t koscli(CSOUND *csound, OSC   *p)
                              Str("oscili(krate): not initialised"));
 }
 
-int32_t osckki(CSOUND *csound, OSC   *p)
+int32_t osckki(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   fract, v1, amp, *ar, *ft, *ftab;
-    int32_t   phs, inc, lobits;
+    MYFLT   amp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
-    if (UNLIKELY((ftp = p->ftp)==NULL)) goto err1;
-    lobits = ftp->lobits;
+    ftp = p->ftp;
+    if (UNLIKELY(ftp==NULL)) goto err1;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
     amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    ft = ftp->ftable;
-    for (n=offset; n<nsmps; n++) {
-      fract = PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * amp;
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_readi(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1420,38 +1466,27 @@ int32_t osckki(CSOUND *csound, OSC   *p)
                              Str("oscili: not initialised"));
 }
 
-int32_t osckai(CSOUND *csound, OSC   *p)
+int32_t osckai(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, fract, v1, *ftab, *ft;
-    int32_t    phs, lobits;
+    MYFLT   amp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
     phs = p->lphs;
+    cpsp = p->xcps;
+    amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    ft = ftp->ftable;
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * amp;
-      phs += inc;
-      phs &= PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_readi(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1460,34 +1495,26 @@ int32_t osckai(CSOUND *csound, OSC   *p)
                              Str("oscili: not initialised"));
 }
 
-int32_t oscaki(CSOUND *csound, OSC   *p)
+int32_t oscaki(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT    v1, fract, *ar, *ampp, *ftab, *ft;
-    int32_t    phs, inc, lobits;
+    MYFLT   *ampp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    lobits = ftp->lobits;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
     ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    ft = ftp->ftable;
-    for (n=offset;n<nsmps;n++) {
-      fract = (MYFLT) PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_readi(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
@@ -1496,37 +1523,27 @@ int32_t oscaki(CSOUND *csound, OSC   *p)
                              Str("oscili: not initialised"));
 }
 
-int32_t oscaai(CSOUND *csound, OSC   *p)
+int32_t oscaai(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   v1, fract, *ar, *ampp, *cpsp, *ftab, *ft;
-    int32_t   phs, lobits;
+    MYFLT   *ampp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t n, m, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ft = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
-    ampp = p->xamp;
     cpsp = p->xcps;
+    ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = (MYFLT) PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_readi(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
@@ -1576,57 +1593,26 @@ int32_t koscl3(CSOUND *csound, OSC   *p)
                              Str("oscil3(krate): not initialised"));
 }
 
-int32_t osckk3(CSOUND *csound, OSC   *p)
+int32_t osckk3(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   fract, amp, *ar, *ftab;
-    int32_t    phs, inc, lobits;
+    MYFLT   amp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
     amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      fract = PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-/*    printf("fract = %f; y = %f, %f, %f, %f\n", fract,ym1,y0,y1,y2); */
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-/*      MYFLT old = (y0 + (y1 - y0) * fract) * amp; */
-/*      double x = ((double)(x0-2)+fract)*twopi/32.0; */
-/*      MYFLT tr = amp*sin(x); */
-        ar[n] = amp * (y0 + FL(0.5)*frcu +
-                       fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
-                       frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) +
-                       frsq*(FL(0.5)* y1 - y0));
-/*      printf("oscilkk3: old=%.4f new=%.4f true=%.4f (%f; %f)\n", */
-/*                       old, *(ar-1), tr, fabs(*(ar-1)-tr), fabs(old-tr)); */
-      }
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_read3(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1635,54 +1621,27 @@ int32_t osckk3(CSOUND *csound, OSC   *p)
                              Str("oscil3: not initialised"));
 }
 
-int32_t oscka3(CSOUND *csound, OSC   *p)
+int32_t oscka3(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, fract, *ftab;
-    int32_t    phs, lobits;
+    MYFLT   amp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
+    uint32_t n, m, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
     phs = p->lphs;
+    cpsp = p->xcps;
+    amp = *p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = amp * (y0 + FL(0.5)*frcu +
-                       fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
-                       frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) + frsq*(FL(0.5)*
-                                                                    y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_read3(&ar[n], ph, m, ftp, amp, NULL);
     }
     p->lphs = phs;
     return OK;
@@ -1691,51 +1650,26 @@ int32_t oscka3(CSOUND *csound, OSC   *p)
                              Str("oscil3: not initialised"));
 }
 
-int32_t oscak3(CSOUND *csound, OSC   *p)
+int32_t oscak3(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT   fract, *ar, *ampp, *ftab;
-    int32_t    phs, inc, lobits;
+    MYFLT   *ampp, *ar;
+    int32_t   phs, inc, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
+    uint32_t n, m, nsmps = CS_KSMPS;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
     inc = MYFLT2LONG(*p->xcps * csound->sicvt);
     ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      fract = (MYFLT) PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = ampp[n] *(y0 + FL(0.5)*frcu
-                          + fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0))
-                          + frsq*fract*(t1/FL(6.0) - FL(0.5)*y1)
-                          + frsq*(FL(0.5)* y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_k(ph, m, phs, inc);
+      osc_read3(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
@@ -1744,53 +1678,27 @@ int32_t oscak3(CSOUND *csound, OSC   *p)
                              Str("oscil3: not initialised"));
 }
 
-int32_t oscaa3(CSOUND *csound, OSC   *p)
+int32_t oscaa3(CSOUND *csound, OSC *p)
 {
     FUNC    *ftp;
-    MYFLT    fract, *ar, *ampp, *cpsp, *ftab;
-    int32_t    phs, lobits;
+    MYFLT   *ampp, *ar, *cpsp;
+    int32_t   phs, ph[OSC_BLOCK];
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t    x0;
-    MYFLT    y0, y1, ym1, y2;
-    MYFLT    sicvt = csound->sicvt;
+    uint32_t n, m, nsmps = CS_KSMPS;
+    MYFLT   sicvt = csound->sicvt;
 
     ftp = p->ftp;
     if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
     phs = p->lphs;
-    ampp = p->xamp;
     cpsp = p->xcps;
+    ampp = p->xamp;
     ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = (MYFLT) PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = ampp[n] *(y0 + FL(0.5)*frcu
-                          + fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0))
-                          + frsq*fract*(t1/FL(6.0) - FL(0.5)*y1)
-                          + frsq*(FL(0.5)* y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
+    CS_OFFSET_CLEAR(ar, offset, early, nsmps);
+    for (n=offset; n<nsmps; n+=m) {
+      m = nsmps-n < OSC_BLOCK ? nsmps-n : OSC_BLOCK;
+      phs = osc_phs_a(ph, m, phs, &cpsp[n], sicvt);
+      osc_read3(&ar[n], ph, m, ftp, FL(0.0), &ampp[n]);
     }
     p->lphs = phs;
     return OK;
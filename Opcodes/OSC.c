@@ -32,6 +32,7 @@
     #include <unistd.h>
 #endif
 #include <lo/lo.h>
+#include "osc_ring.h"
 #include <ctype.h>
 #ifndef WIN32
   #include <sys/types.h>
@@ -67,20 +68,10 @@ typedef struct {
 } OSCSEND;
 
 
-typedef struct osc_pat {
-    struct osc_pat *next;
-    union {
-      MYFLT number;
-      STRINGDAT string;
-      void     *blob;
-    } args[ARG_CNT-1];
-} OSC_PAT;
 
 typedef struct {
     lo_server_thread thread;
     CSOUND  *csound;
-    void    *mutex_;
-    void    *oplst;             /* list of opcodes listening on this port */
 } OSC_PORT;
 
 /* structure for global variables */
@@ -90,8 +81,7 @@ typedef struct {
     /* for OSCinit/OSClisten */
     int32_t   nPorts;
     OSC_PORT  *ports;
-    int32_t   osccounter;
-    void      *mutex_;
+    volatile long osccounter;   /* messages received and not yet read */
 } OSC_GLOBALS;
 
 /* opcode for starting the OSC listener (called once from orchestra header) */
@@ -110,11 +100,16 @@ typedef struct {
 
 typedef struct osclcommon {
     lo_method method;
+    CSOUND  *csound;
     char    *saved_path;
     char    saved_types[ARG_CNT];    /* copy of type list */
-    OSC_PAT *patterns;          /* FIFO list of pending messages */
-    OSC_PAT *freePatterns;      /* free message stack */
-    struct osclcomon *nxt;       /* pointer to next opcode on the same port */
+    OSC_RING ring;              /* pending messages */
+    volatile long active;       /* cleared before the method is removed */
+    volatile long busy;         /* the handler is storing a message */
+    OSC_GLOBALS *g;
+    double  clockofs;           /* wall clock in samples - score time */
+    int32_t haveclock;
+    uint64_t clockk;            /* cycle it was last updated */
 } OSCLCOMMON;
 
 typedef struct {
@@ -139,6 +134,19 @@ typedef struct {
     OSCLCOMMON c;
 } OSCLISTENA;
 
+typedef struct {
+    OPDS      h;                  /* default header */
+    MYFLT     *kans;
+    ARRAYDAT  *args;              /* one row for each message */
+    ARRAYDAT  *offs;              /* its sample in the cycle */
+    MYFLT     *ihandle;
+    STRINGDAT *dest;
+    STRINGDAT *type;
+    MYFLT     *imax;
+    OSC_PORT  *port;
+    OSCLCOMMON c;
+} OSCLISTENB;
+
 static int32_t oscsend_deinit(CSOUND *csound, OSCSEND *p)
 {
     lo_address a = (lo_address)p->addr;
@@ -401,7 +409,6 @@ static int32_t OSC_reset(CSOUND *csound, OSC_GLOBALS *p)
       if (p->ports[i].thread) {
         lo_server_thread_stop(p->ports[i].thread);
         lo_server_thread_free(p->ports[i].thread);
-        csound->DestroyMutex(p->ports[i].mutex_);
       }
     csound->DestroyGlobalVariable(csound, "_OSC_globals");
     return OK;
@@ -429,7 +436,6 @@ static CS_NOINLINE OSC_GLOBALS *alloc_globals(CSOUND *csound)
     }
     pp = (OSC_GLOBALS*) csound->QueryGlobalVariable(csound, "_OSC_globals");
     pp->csound = csound;
-    pp->mutex_ = csound->Create_Mutex(0);
     csound->RegisterResetCallback(csound, (void*) pp,
                                   (int32_t (*)(CSOUND *, void *)) OSC_reset);
     return pp;
@@ -439,29 +445,76 @@ static CS_NOINLINE OSC_GLOBALS *alloc_globals(CSOUND *csound)
 
  /* ------------------------------------------------------------------------ */
 
-static CS_NOINLINE OSC_PAT *alloc_pattern(CSOUND *csound)
+static inline void osc_ring_pop(OSCLCOMMON *c)
 {
-    OSC_PAT *p;
-    size_t  nbytes;
+    osc_ring_take(&c->ring);
+    ATOMIC_DECR(c->g->osccounter);
+}
 
-    /* number of bytes to allocate */
-    nbytes = sizeof(OSC_PAT);
-    /* allocate and initialise structure */
-    p = (OSC_PAT*) csound->Calloc(csound, nbytes);
+/* Wall clock in samples less the score time ('start', the first sample
+   of this cycle).  The difference is followed slowly, once a cycle, so
+   that the time of an OSC bundle becomes a sample in the performance
+   that does not jitter with the audio buffers. */
 
-    return p;
+static double osc_clock(void *data, double start)
+{
+    OSCLCOMMON *c = (OSCLCOMMON*) data;
+    CSOUND   *csound = c->csound;
+    uint64_t kcounter = csound->GetKcounter(csound);
+
+    if (c->clockk != kcounter) {
+      double     sr = (double) csound->GetSr(csound), d;
+      lo_timetag now;
+      lo_timetag_now(&now);
+      d = ((double) now.sec + (double) now.frac / 4294967296.0) * sr - start;
+      if (!c->haveclock || fabs(d - c->clockofs) > sr) {
+        c->clockofs = d;
+        c->haveclock = 1;
+      }
+      else
+        c->clockofs += (d - c->clockofs) / 256.0;
+      c->clockk = kcounter;
+    }
+    return c->clockofs;
 }
 
-static inline OSC_PAT *get_pattern(CSOUND *csound,OSCLCOMMON *pp)
+/* the oldest message of a listener if it is due in this cycle, with its
+   sample in the cycle in 'offset' (see osc_ring.h) */
+
+static OSC_ARG *osc_due(CSOUND *csound, OSCLCOMMON *c, int32_t *offset)
 {
-    OSC_PAT *p;
+    double   ksmps = (double) csound->GetKsmps(csound);
+    /* the score time has been advanced to the end of this cycle */
+    double   start = (double) csound->GetCurrentTimeSamples(csound) - ksmps;
+
+    return osc_ring_due(&c->ring, start, ksmps, (double) csound->GetSr(csound),
+                        osc_clock, (void*) c, offset);
+}
 
-    if (pp->freePatterns != NULL) {
-      p = pp->freePatterns;
-      pp->freePatterns = p->next;
-      return p;
+/* throws away what is left in the ring, and the ring */
+
+static void osc_ring_free(CSOUND *csound, OSCLCOMMON *c)
+{
+    OSC_RING *r = &c->ring;
+    int32_t  i;
+
+    if (r->args == NULL)
+      return;
+    while ((uint32_t) ATOMIC_GET(r->wp) != (uint32_t) r->rp) {
+      OSC_ARG *m = &r->args[(size_t) ((uint32_t) r->rp & (r->size - 1))
+                            * r->nargs];
+      for (i = 0; c->saved_types[i] != '\0'; i++) {
+        if (c->saved_types[i] == 's')
+          csound->Free(csound, m[i].string);
+        else if (c->saved_types[i] == 'b')
+          csound->Free(csound, m[i].blob);
+      }
+      osc_ring_pop(c);
     }
-    return alloc_pattern(csound);
+    csound->Free(csound, r->args);
+    csound->Free(csound, r->time);
+    r->args = NULL;
+    r->time = NULL;
 }
 
 typedef struct {
@@ -472,100 +525,76 @@ typedef struct {
 static int32_t OSCcounter(CSOUND *csound, OSCcount *p)
 {
     OSC_GLOBALS *g = alloc_globals(csound);
-    *p->ans = (MYFLT)g->osccounter;
+    *p->ans = (MYFLT) ATOMIC_GET(g->osccounter);
     return OK;
 }
 
+static double osc_bundle_time(lo_message msg)
+{
+    lo_timetag tt = lo_message_get_timestamp(msg);
+
+    if (tt.sec == 0 && tt.frac <= 1)        /* immediately */
+      return 0.0;
+    return (double) tt.sec + (double) tt.frac / 4294967296.0;
+}
+
+/* Called by the server thread of the port for each message that matches
+   the path and types of one OSClisten.  It takes no lock, and allocates
+   only for strings and blobs. */
+
 static int32_t OSC_handler(const char *path, const char *types,
                        lo_arg **argv, int32_t argc, void *data, void *p)
 {
-    IGN(argc);  IGN(data);
-    OSC_PORT  *pp = (OSC_PORT*) p;
-    OSCLCOMMON *o;
-    CSOUND    *csound = (CSOUND *) pp->csound;
-    int32_t       retval = 1;
-
-    pp->csound->LockMutex(pp->mutex_);
-    o = (OSCLCOMMON*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        pp->csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        pp->csound->UnlockMutex(g->mutex_);
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-               m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-               m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-               m->args[i].number= (MYFLT) argv[i]->d; break;
-            case 's':
-              { // ***NO CHECK THAT m->args[i] IS A STRING
-                char  *src = (char*) &(argv[i]->s), *dst = m->args[i].string.data;
-                if (m->args[i].string.size <= (int32_t) strlen(src)) {
-                  if (dst != NULL) csound->Free(csound, dst);
-                  dst = csound->Strdup(csound, src);
-                  // who sets m->args[i].string.size ??
-                  m->args[i].string.data = dst;
-                  m->args[i].string.size = strlen(dst)+1;
-                }
-                else strcpy(dst, src);
-                break;
-              }
-            case 'b':
-              {
-                int32_t len =
-                  lo_blobsize((lo_blob*)argv[i]);
-                m->args[i].blob =
-                  csound->Malloc(csound,len);
-                memcpy(m->args[i].blob, argv[i], len);
+    IGN(path);  IGN(types);  IGN(argc);
+    OSCLCOMMON *o = (OSCLCOMMON*) p;
+    CSOUND    *csound = o->csound;
+    OSC_ARG   *m;
+    int32_t   i, retval = 1;
+
+    ATOMIC_INCR(o->busy);
+    if (!ATOMIC_GET(o->active))             /* being removed */
+      goto done;
+    retval = 0;
+    if (UNLIKELY((m = osc_ring_next(&o->ring)) == NULL))
+      goto done;                            /* full: counted as dropped */
+    /* copy argument list; liblo has converted them to the method's types */
+    for (i = 0; o->saved_types[i] != '\0'; i++) {
+      switch (o->saved_types[i]) {
+      default:              /* Should not happen */
+      case 'i':
+        m[i].number = (MYFLT) argv[i]->i; break;
+      case 'h':
+        m[i].number = (MYFLT) argv[i]->i64; break;
+      case 'c':
+        m[i].number = (MYFLT) argv[i]->c; break;
+      case 'f':
+        m[i].number = (MYFLT) argv[i]->f; break;
+      case 'd':
+        m[i].number = (MYFLT) argv[i]->d; break;
+      case 's':
+        m[i].string = csound->Strdup(csound, (char*) &(argv[i]->s));
+        break;
+      case 'b':
+        {
+          int32_t len = lo_blobsize((lo_blob*)argv[i]);
+          m[i].blob = csound->Malloc(csound, len);
+          memcpy(m[i].blob, argv[i], len);
 #ifdef OSC_DEBUG
-                {
-                  lo_blob *bb = (lo_blob*)m->args[i].blob;
-                  int32_t size = lo_blob_datasize(bb);
-                  MYFLT *data = lo_blob_dataptr(bb);
-                  int32_t   *idata = (int32_t*)data;
-                  printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
-                }
-#endif
-              }
-            }
+          {
+            lo_blob *bb = (lo_blob*)m[i].blob;
+            int32_t size = lo_blob_datasize(bb);
+            MYFLT *data = lo_blob_dataptr(bb);
+            int32_t   *idata = (int32_t*)data;
+            printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
           }
-          retval = 0;
+#endif
         }
-        break;
       }
-      o = (OSCLCOMMON*) o->nxt;
     }
-
-    pp->csound->UnlockMutex(pp->mutex_);
+    osc_ring_push(&o->ring, osc_bundle_time((lo_message) data));
+    ATOMIC_INCR(o->g->osccounter);
+ done:
+    ATOMIC_DECR(o->busy);
     return retval;
 }
 
@@ -582,8 +611,6 @@ static int32_t OSC_deinit(CSOUND *csound, OSCINIT *p)
     if (UNLIKELY(pp==NULL)) return NOTOK;
     ports = pp->ports;
     csound->Message(csound, "handle=%d\n", n);
-    csound->DestroyMutex(ports[n].mutex_);
-    ports[n].mutex_ = NULL;
     lo_server_thread_stop(ports[n].thread);
     lo_server_thread_free(ports[n].thread);
     ports[n].thread =  NULL;
@@ -604,8 +631,6 @@ static int32_t osc_listener_init(CSOUND *csound, OSCINIT *p)
     ports = (OSC_PORT*) csound->ReAlloc(csound, pp->ports,
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
-    ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new(buff, OSC_error);
     if (UNLIKELY(ports[n].thread==NULL))
@@ -639,8 +664,6 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
     ports = (OSC_PORT*) csound->ReAlloc(csound, pp->ports,
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
-    ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new_multicast(p->group->data,
                                                      buff, OSC_error);
@@ -666,42 +689,25 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
 
 static int32_t OSC_listendeinit(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *p)
 {
-    OSC_PAT *m;
-
-    if (port->mutex_==NULL) return NOTOK;
-    csound->LockMutex(port->mutex_);
-    if (port->oplst == (void*)p)
-      port->oplst = p->nxt;
-    else {
-      OSCLCOMMON *o = (OSCLCOMMON*) port->oplst;
-      for ( ; o->nxt != (void*) p; o = (OSCLCOMMON*) o->nxt)
-        ;
-      o->nxt = p->nxt;
-    }
-    csound->UnlockMutex(port->mutex_);
+    if (p->saved_path == NULL) return OK;
+    ATOMIC_SET(p->active, 0);
+    while (ATOMIC_GET(p->busy))     /* a message is being stored */
+      csound->Sleep(1);
+    if (port->thread != NULL) {
 #ifdef LIBLO29
-    //Would like to use this call but requires liblo2.29
-    lo_server_thread_del_lo_method (port->thread, p->method);
+      //Would like to use this call but requires liblo2.29
+      lo_server_thread_del_lo_method (port->thread, p->method);
 #else
-    lo_server_thread_del_method(port->thread, p->saved_path, p->saved_types);
+      lo_server_thread_del_method(port->thread, p->saved_path, p->saved_types);
 #endif
+    }
+    if (UNLIKELY(p->ring.dropped))
+      csound->Warning(csound, Str("OSClisten %s: %ld messages dropped "
+                                  "(queue full)\n"),
+                      p->saved_path, (long) p->ring.dropped);
+    osc_ring_free(csound, p);
     csound->Free(csound, p->saved_path);
     p->saved_path = NULL;
-    p->nxt = NULL;
-    m = p->patterns;
-    p->patterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    m = p->freePatterns;
-    p->freePatterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
     return OK;
 }
 
@@ -717,6 +723,22 @@ static int32_t OSC_listadeinit(CSOUND *csound, OSCLISTENA *p)
     return OSC_listendeinit(csound, port, &p->c);
 }
 
+/* starts taking messages for an OSClisten: the last thing its init does */
+
+static void osc_listen_start(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *c,
+                             int32_t nargs, uint32_t size)
+{
+    c->csound = csound;
+    c->g = alloc_globals(csound);
+    c->busy = 0;
+    c->haveclock = 0;
+    c->clockk = 0;
+    osc_ring_init(csound, &c->ring, nargs, size);
+    ATOMIC_SET(c->active, 1);
+    c->method = lo_server_thread_add_method(port->thread,
+                                            c->saved_path, c->saved_types,
+                                            OSC_handler, c);
+}
 
 static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
 {
@@ -775,13 +797,7 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
-    csound->LockMutex(p->port->mutex_);
-    p->c.nxt = p->port->oplst;
-    p->port->oplst = (void*) &p->c;
-    csound->UnlockMutex(p->port->mutex_);
-    p->c.method = lo_server_thread_add_method(p->port->thread,
-                                              p->c.saved_path, p->c.saved_types,
-                                              OSC_handler, p->port);
+    osc_listen_start(csound, p->port, &p->c, n, OSC_RING_SIZE);
     csound->RegisterDeinitCallback(csound, p,
                                    (int32_t (*)(CSOUND *, void *)) OSC_listdeinit);
     return OK;
@@ -789,44 +805,42 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
 
 static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
 {
-    OSC_PAT *m;
+    OSC_ARG *m;
+    int32_t offset;
 
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
+    /* the next message, if it is due; a k-rate output can only take it
+       at the start of the cycle, so a bundle's offset in the cycle is
+       not used (the form with koffs[] returns it) */
+    m = osc_due(csound, &p->c, &offset);
     if (m != NULL) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
       /* copy arguments */
       //printf("copying args\n");
       for (i = 0; p->c.saved_types[i] != '\0'; i++) {
         //printf("%d: type %c\n", i, p->c.saved_types[i]);
         if (p->c.saved_types[i] == 's') {
-          char *src = m->args[i].string.data;
+          char *src = m[i].string;
           char *dst = ((STRINGDAT*) p->args[i])->data;
           if (src != NULL) {
             if (((STRINGDAT*) p->args[i])->size <= (int32_t) strlen(src)){
+              /* take the received copy */
               if (dst != NULL) csound->Free(csound, dst);
-              dst = csound->Strdup(csound, src);
-              ((STRINGDAT*) p->args[i])->size = strlen(dst) + 1;
-              ((STRINGDAT*) p->args[i])->data = dst;
-           }
-          else
-            strcpy(dst, src);
+              ((STRINGDAT*) p->args[i])->size = strlen(src) + 1;
+              ((STRINGDAT*) p->args[i])->data = src;
+            }
+            else {
+              strcpy(dst, src);
+              csound->Free(csound, src);
+            }
+            m[i].string = NULL;
           }
         }
         else if (p->c.saved_types[i]=='b') {
           char c = p->type->data[i];
-          int32_t len =  lo_blob_datasize(m->args[i].blob);
-          //printf("blob found %p type %c\n", m->args[i].blob, c);
-          //printf("length = %d\n", lo_blob_datasize(m->args[i].blob));
-          int32_t *idata = lo_blob_dataptr(m->args[i].blob);
+          int32_t len =  lo_blob_datasize(m[i].blob);
+          //printf("blob found %p type %c\n", m[i].blob, c);
+          //printf("length = %d\n", lo_blob_datasize(m[i].blob));
+          int32_t *idata = lo_blob_dataptr(m[i].blob);
           if (c == 'D') {
             int32_t j;
             MYFLT *data = (MYFLT *) idata;
@@ -935,98 +949,51 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
           else if (c == 'S') {
           }
           else return csound->PerfError(csound,  &(p->h), "Oh dear");
-          csound->Free(csound, m->args[i].blob);
+          csound->Free(csound, m[i].blob);
+          m[i].blob = NULL;
         }
         else
-          *(p->args[i]) = m->args[i].number;
+          *(p->args[i]) = m[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      osc_ring_pop(&p->c);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
 /* ******** ARRAY VERSION **** EXPERIMENTAL *** */
 
-static int32_t OSC_ahandler(const char *path, const char *types,
-                       lo_arg **argv, int32_t argc, void *data, void *p)
+#include "arrays.h"
+
+/* the argument types of the array versions: numbers only */
+
+static int32_t osc_alist_types(CSOUND *csound, OSCLCOMMON *c, STRINGDAT *type)
 {
-    IGN(argc);  IGN(data);
-    OSC_PORT  *pp = (OSC_PORT*) p;
-    OSCLCOMMON *o;
-    CSOUND    *csound = (CSOUND *) pp->csound;
-    int32_t   retval = 1;
-    //printf("***in ahandler\n");
-    csound->LockMutex(pp->mutex_);
-    o = (OSCLCOMMON*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        csound->UnlockMutex(g->mutex_);
-        //printf("handler found message\n");
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-              m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-              m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-              m->args[i].number= (MYFLT) argv[i]->d; break;
-            }
-          }
-          retval = 0;
-        }
+    int32_t i, n = strlen((char*) type->data);
+
+    if (UNLIKELY(n < 1 || n > ARG_CNT-1))
+      return csound->InitError(csound, "%s", Str("invalid number of arguments"));
+    strcpy(c->saved_types, (char*) type->data);
+    for (i = 0; i < n; i++) {
+      switch (c->saved_types[i]) {
+      case 'c':
+      case 'd':
+      case 'f':
+      case 'h':
+      case 'i':
         break;
+      default:
+        return csound->InitError(csound, "%s", Str("invalid type"));
       }
-      o = (OSCLCOMMON*) o->nxt;
     }
-
-    pp->csound->UnlockMutex(pp->mutex_);
-    return retval;
+    return OK;
 }
 
-#include "arrays.h"
-
 static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
 {
-    //void  *x;
-    int32_t   i, n;
+    int32_t   n;
 
     OSC_GLOBALS *pp =
       (OSC_GLOBALS*) csound->QueryGlobalVariable(csound, "_OSC_globals");
@@ -1037,31 +1004,15 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
     if (UNLIKELY(n < 0 || n >= pp->nPorts))
       return csound->InitError(csound, "%s", Str("invalid handle"));
     p->port = &(pp->ports[n]);
+    /* check for a valid argument list */
+    if (UNLIKELY(osc_alist_types(csound, &p->c, p->type) != OK))
+      return NOTOK;
+    n = strlen(p->c.saved_types);
+    tabinit(csound, p->args, n);
     p->c.saved_path = (char*) csound->Malloc(csound,
                                            strlen((char*) p->dest->data) + 1);
     strcpy(p->c.saved_path, (char*) p->dest->data);
-    /* check for a valid argument list */
-    tabinit(csound, p->args, n=strlen((char*) p->type->data));
-    strcpy(p->c.saved_types, (char*) p->type->data);
-    for (i = 0; i < n; i++) {
-      switch (p->c.saved_types[i]) {
-      case 'c':
-      case 'd':
-      case 'f':
-      case 'h':
-      case 'i':
-        break;
-      default:
-        return csound->InitError(csound, "%s", Str("invalid type"));
-      }
-    }
-    csound->LockMutex(p->port->mutex_);
-    p->c.nxt = p->port->oplst;
-    p->port->oplst = (void*) &p->c;
-    csound->UnlockMutex(p->port->mutex_);
-    p->c.method = lo_server_thread_add_method(p->port->thread,
-                                              p->c.saved_path, p->c.saved_types,
-                                              OSC_ahandler, p->port);
+    osc_listen_start(csound, p->port, &p->c, n, OSC_RING_SIZE);
     csound->RegisterDeinitCallback(csound, p,
                                    (int32_t (*)(CSOUND *, void *)) OSC_listadeinit);
     return OK;
@@ -1069,37 +1020,86 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
 
 static int32_t OSC_alist(CSOUND *csound, OSCLISTENA *p)
 {
-    OSC_PAT *m;
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
+    OSC_ARG *m;
+    int32_t offset;
+
+    /* as OSC_list, the offset in the cycle is not used */
+    m = osc_due(csound, &p->c, &offset);
     if (m != NULL) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
       /* copy arguments */
-      //printf("copying args\n");
-      for (i = 0; p->c.saved_types[i] != '\0'; i++) {
-        //printf("%d: type %c\n", i, p->c.saved_types[i]);
-        ((MYFLT*)p->args->data)[i] = m->args[i].number;
-      }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      for (i = 0; p->c.saved_types[i] != '\0'; i++)
+        ((MYFLT*)p->args->data)[i] = m[i].number;
+      osc_ring_pop(&p->c);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
+    return OK;
+}
+
+/* all messages due in this cycle at once: kans of them, one to a row of
+   args, with the sample in the cycle of each in offs */
+
+static int32_t OSC_listbdeinit(CSOUND *csound, OSCLISTENB *p)
+{
+    OSC_PORT *port = p->port;
+    return OSC_listendeinit(csound, port, &p->c);
+}
+
+static int32_t OSC_blist_init(CSOUND *csound, OSCLISTENB *p)
+{
+    int32_t   n, nmax;
+
+    OSC_GLOBALS *pp =
+      (OSC_GLOBALS*) csound->QueryGlobalVariable(csound, "_OSC_globals");
+    if (UNLIKELY(pp == NULL))
+      return csound->InitError(csound, "%s", Str("OSC not running"));
+    /* find port */
+    n = (int32_t) *(p->ihandle);
+    if (UNLIKELY(n < 0 || n >= pp->nPorts))
+      return csound->InitError(csound, "%s", Str("invalid handle"));
+    p->port = &(pp->ports[n]);
+    if (UNLIKELY(osc_alist_types(csound, &p->c, p->type) != OK))
+      return NOTOK;
+    n = strlen(p->c.saved_types);
+    nmax = (*p->imax > FL(0.0) ? (int32_t) *p->imax : OSC_RING_SIZE);
+    /* as many rows as the ring holds, so that nothing grows later */
+    if (p->args->dimensions != 2) {
+      p->args->sizes = (int32_t*) csound->ReAlloc(csound, p->args->sizes,
+                                                  2 * sizeof(int32_t));
+      p->args->dimensions = 2;
+    }
+    tabinit(csound, p->args, nmax * n);
+    p->args->sizes[0] = 0;
+    p->args->sizes[1] = n;
+    tabinit(csound, p->offs, nmax);
+    p->offs->sizes[0] = 0;
+    p->c.saved_path = (char*) csound->Malloc(csound,
+                                           strlen((char*) p->dest->data) + 1);
+    strcpy(p->c.saved_path, (char*) p->dest->data);
+    osc_listen_start(csound, p->port, &p->c, n, (uint32_t) nmax);
+    csound->RegisterDeinitCallback(csound, p,
+                                   (int32_t (*)(CSOUND *, void *)) OSC_listbdeinit);
+    return OK;
+}
+
+static int32_t OSC_blist(CSOUND *csound, OSCLISTENB *p)
+{
+    OSC_ARG *m;
+    MYFLT   *args = p->args->data, *offs = p->offs->data;
+    int32_t offset, i, k = 0, nargs = p->c.ring.nargs;
+    int32_t nmax = (int32_t) (p->offs->allocated / sizeof(MYFLT));
+
+    while (k < nmax && (m = osc_due(csound, &p->c, &offset)) != NULL) {
+      for (i = 0; i < nargs; i++)
+        args[k * nargs + i] = m[i].number;
+      offs[k++] = (MYFLT) offset;
+      osc_ring_pop(&p->c);
+    }
+    p->args->sizes[0] = k;
+    p->offs->sizes[0] = k;
+    *p->kans = (MYFLT) k;
     return OK;
 }
 
@@ -1120,6 +1120,8 @@ static OENTRY localops[] = {
     (SUBR)OSC_list_init, (SUBR)OSC_list, NULL, NULL },
   { "OSClisten", S(OSCLISTENA),0, 3, "kk[]", "iSS",
     (SUBR)OSC_alist_init, (SUBR)OSC_alist, NULL, NULL },
+  { "OSClisten", S(OSCLISTENB),0, 3, "kk[]k[]", "iSSj",
+    (SUBR)OSC_blist_init, (SUBR)OSC_blist, NULL, NULL },
   { "OSCcount", S(OSCcount), 0, 3, "k", "",
     (SUBR)OSCcounter, (SUBR)OSCcounter, NULL }
 };
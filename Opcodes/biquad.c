@@ -34,6 +34,7 @@
 #include <math.h>
 #include "biquad.h"
 #include "csound_standard_types.h"
+#include "arrays.h"
 
 /***************************************************************************/
 /* The biquadratic filter computes the digital filter two x components and */
@@ -1669,6 +1670,225 @@ int mvmfilter(CSOUND *csound, MVMFILT *p) {
   return OK;
 }
 
+/***************************************************************************/
+/* Filter banks: N parallel biquads (transposed direct form II) or        */
+/* trapezoidal state variable filters fed from one input.  Coefficients   */
+/* and state are kept in structure-of-arrays layout so the inner loop     */
+/* runs over filters with no loop-carried dependency and can be           */
+/* vectorised by the compiler.  Output is either the sum of the bank or   */
+/* one signal per filter in an a-rate array.                              */
+/***************************************************************************/
+
+static int32_t bank_size(CSOUND *csound, ARRAYDAT **arr, int32_t n)
+{
+    int32_t i, sz;
+    for (i = 0; i < n; i++)
+      if (UNLIKELY(arr[i]->data == NULL || arr[i]->dimensions != 1))
+        return csound->InitError(csound, "%s",
+                                 Str("filter bank: array not initialised"));
+    sz = arr[0]->sizes[0];
+    for (i = 1; i < n; i++)
+      if (UNLIKELY(arr[i]->sizes[0] != sz))
+        return csound->InitError(csound, "%s",
+                                 Str("filter bank: arrays differ in size"));
+    if (UNLIKELY(sz < 1))
+      return csound->InitError(csound, "%s", Str("filter bank: empty arrays"));
+    return sz;
+}
+
+static int32_t bank_alloc(CSOUND *csound, AUXCH *coefs, size_t ncoefs,
+                          AUXCH *state, int32_t nfilt, MYFLT reinit)
+{
+    size_t cb = ncoefs*nfilt*sizeof(double), sb = 3*nfilt*sizeof(double);
+    if (coefs->auxp == NULL || coefs->size < cb)
+      csound->AuxAlloc(csound, cb, coefs);
+    if (state->auxp == NULL || state->size < sb)
+      csound->AuxAlloc(csound, sb, state);
+    else if (reinit == FL(0.0))
+      memset(state->auxp, '\0', sb);
+    return OK;
+}
+
+/* Sum the per-filter outputs of one sample, or scatter them into
+   a-rate array member k at sample n */
+static inline void bank_out(double *restrict y, int32_t nf, MYFLT *out,
+                            int32_t arr, uint32_t ksmps, uint32_t n)
+{
+    int32_t k;
+    if (arr) {
+      for (k = 0; k < nf; k++) out[k*ksmps + n] = (MYFLT)y[k];
+    }
+    else {
+      double acc = 0.0;
+      for (k = 0; k < nf; k++) acc += y[k];
+      out[n] = (MYFLT)acc;
+    }
+}
+
+static void bank_clear(MYFLT *out, int32_t nf, int32_t arr, uint32_t ksmps,
+                       uint32_t offset, uint32_t early)
+{
+    int32_t k, nout = arr ? nf : 1;
+    for (k = 0; k < nout; k++, out += ksmps) {
+      if (UNLIKELY(offset)) memset(out, '\0', offset*sizeof(MYFLT));
+      if (UNLIKELY(early)) memset(&out[ksmps-early], '\0', early*sizeof(MYFLT));
+    }
+}
+
+static int32_t bqbankset_(CSOUND *csound, BQBANK *p, int32_t arr)
+{
+    ARRAYDAT *c[5];
+    int32_t nf;
+    c[0] = p->b0; c[1] = p->b1; c[2] = p->b2; c[3] = p->a1; c[4] = p->a2;
+    if (UNLIKELY((nf = bank_size(csound, c, 5)) <= 0)) return NOTOK;
+    p->nfilt = nf;
+    if (arr) tabinit(csound, (ARRAYDAT *) p->out, nf);
+    return bank_alloc(csound, &p->coefs, 5, &p->state, nf, *p->reinit);
+}
+
+static int32_t bqbankset(CSOUND *csound, BQBANK *p)
+{
+    return bqbankset_(csound, p, 0);
+}
+
+static int32_t bqbankset_A(CSOUND *csound, BQBANK *p)
+{
+    return bqbankset_(csound, p, 1);
+}
+
+static int32_t bqbank_(CSOUND *csound, BQBANK *p, int32_t arr)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t n, ksmps = CS_KSMPS, nsmps = ksmps - early;
+    int32_t k, nf = p->nfilt;
+    double *restrict b0 = (double *) p->coefs.auxp, *restrict b1 = b0 + nf,
+           *restrict b2 = b1 + nf, *restrict a1 = b2 + nf,
+           *restrict a2 = a1 + nf;
+    double *restrict z1 = (double *) p->state.auxp, *restrict z2 = z1 + nf,
+           *restrict y = z2 + nf;
+    MYFLT *in = p->in;
+    MYFLT *out = arr ? ((ARRAYDAT *) p->out)->data : p->out;
+
+    if (UNLIKELY(p->b0->sizes[0] < nf || p->b1->sizes[0] < nf ||
+                 p->b2->sizes[0] < nf || p->a1->sizes[0] < nf ||
+                 p->a2->sizes[0] < nf))
+      return csound->PerfError(csound, &(p->h), "%s",
+                               Str("filter bank: arrays shrank"));
+    /* coefficients are k-rate: gather them once per cycle */
+    for (k = 0; k < nf; k++) {
+      b0[k] = (double) p->b0->data[k]; b1[k] = (double) p->b1->data[k];
+      b2[k] = (double) p->b2->data[k]; a1[k] = (double) p->a1->data[k];
+      a2[k] = (double) p->a2->data[k];
+    }
+    bank_clear(out, nf, arr, ksmps, offset, early);
+    for (n = offset; n < nsmps; n++) {
+      double x = (double) in[n];
+      for (k = 0; k < nf; k++) {
+        double yn = b0[k]*x + z1[k];
+        z1[k] = b1[k]*x - a1[k]*yn + z2[k];
+        z2[k] = b2[k]*x - a2[k]*yn;
+        y[k] = yn;
+      }
+      bank_out(y, nf, out, arr, ksmps, n);
+    }
+    return OK;
+}
+
+static int32_t bqbank(CSOUND *csound, BQBANK *p)
+{
+    return bqbank_(csound, p, 0);
+}
+
+static int32_t bqbank_A(CSOUND *csound, BQBANK *p)
+{
+    return bqbank_(csound, p, 1);
+}
+
+static int32_t svfbankset_(CSOUND *csound, SVFBANK *p, int32_t arr)
+{
+    ARRAYDAT *c[2];
+    int32_t k, nf;
+    double *lf, *lq;
+    c[0] = p->freq; c[1] = p->q;
+    if (UNLIKELY((nf = bank_size(csound, c, 2)) <= 0)) return NOTOK;
+    p->nfilt = nf;
+    if (arr) tabinit(csound, (ARRAYDAT *) p->out, nf);
+    bank_alloc(csound, &p->coefs, 7, &p->state, nf, *p->reinit);
+    /* force coefficient calculation on the first cycle */
+    lf = (double *) p->coefs.auxp + 5*nf; lq = lf + nf;
+    for (k = 0; k < nf; k++) lf[k] = lq[k] = -1.0;
+    return OK;
+}
+
+static int32_t svfbankset(CSOUND *csound, SVFBANK *p)
+{
+    return svfbankset_(csound, p, 0);
+}
+
+static int32_t svfbankset_A(CSOUND *csound, SVFBANK *p)
+{
+    return svfbankset_(csound, p, 1);
+}
+
+static int32_t svfbank_(CSOUND *csound, SVFBANK *p, int32_t arr)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t n, ksmps = CS_KSMPS, nsmps = ksmps - early;
+    int32_t k, nf = p->nfilt, mode = (int32_t) *p->mode;
+    double *restrict g = (double *) p->coefs.auxp, *restrict kk = g + nf,
+           *restrict c1 = kk + nf, *restrict c2 = c1 + nf,
+           *restrict c3 = c2 + nf, *lf = c3 + nf, *lq = lf + nf;
+    double *restrict ic1 = (double *) p->state.auxp, *restrict ic2 = ic1 + nf,
+           *restrict y = ic2 + nf;
+    double lim = 0.49*CS_ESR;
+    MYFLT *in = p->in, *fr = p->freq->data, *q = p->q->data;
+    MYFLT *out = arr ? ((ARRAYDAT *) p->out)->data : p->out;
+
+    if (UNLIKELY(p->freq->sizes[0] < nf || p->q->sizes[0] < nf))
+      return csound->PerfError(csound, &(p->h), "%s",
+                               Str("filter bank: arrays shrank"));
+    /* only recalculate the lanes whose parameters moved */
+    for (k = 0; k < nf; k++) {
+      if (fr[k] != lf[k] || q[k] != lq[k]) {
+        double f = fr[k] < 0.0 ? 0.0 : (fr[k] > lim ? lim : fr[k]);
+        double qq = q[k] < 0.5 ? 0.5 : q[k];
+        lf[k] = fr[k]; lq[k] = q[k];
+        g[k] = tan(PI*f/CS_ESR);
+        kk[k] = 1.0/qq;
+        c1[k] = 1.0/(1.0 + g[k]*(g[k] + kk[k]));
+        c2[k] = g[k]*c1[k];
+        c3[k] = g[k]*c2[k];
+      }
+    }
+    bank_clear(out, nf, arr, ksmps, offset, early);
+    for (n = offset; n < nsmps; n++) {
+      double x = (double) in[n];
+      for (k = 0; k < nf; k++) {
+        double v3 = x - ic2[k];
+        double v1 = c1[k]*ic1[k] + c2[k]*v3;
+        double v2 = ic2[k] + c2[k]*ic1[k] + c3[k]*v3;
+        ic1[k] = 2.0*v1 - ic1[k];
+        ic2[k] = 2.0*v2 - ic2[k];
+        /* 0: lowpass, 1: highpass, 2: bandpass */
+        y[k] = mode == 0 ? v2 : (mode == 1 ? x - kk[k]*v1 - v2 : v1);
+      }
+      bank_out(y, nf, out, arr, ksmps, n);
+    }
+    return OK;
+}
+
+static int32_t svfbank(CSOUND *csound, SVFBANK *p)
+{
+    return svfbank_(csound, p, 0);
+}
+
+static int32_t svfbank_A(CSOUND *csound, SVFBANK *p)
+{
+    return svfbank_(csound, p, 1);
+}
+
 
 #define S(x)    sizeof(x)
 
@@ -1697,6 +1917,14 @@ static OENTRY localops[] = {
 { "mode",  S(MODE),   0, 3,      "a", "axxo", (SUBR)modeset,  (SUBR)mode   },
 { "mvmfilter", S(MVMFILT), 0, 3, "a", "axxo",
                                   (SUBR) mvmfilterset, (SUBR) mvmfilter },
+{ "biquadbank", S(BQBANK), 0, 3, "a", "ak[]k[]k[]k[]k[]o",
+                                  (SUBR) bqbankset, (SUBR) bqbank },
+{ "biquadbank.A", S(BQBANK), 0, 3, "a[]", "ak[]k[]k[]k[]k[]o",
+                                  (SUBR) bqbankset_A, (SUBR) bqbank_A },
+{ "svfbank", S(SVFBANK), 0, 3, "a", "ak[]k[]oo",
+                                  (SUBR) svfbankset, (SUBR) svfbank },
+{ "svfbank.A", S(SVFBANK), 0, 3, "a[]", "ak[]k[]oo",
+                                  (SUBR) svfbankset_A, (SUBR) svfbank_A },
 };
 
 int32_t biquad_init_(CSOUND *csound)
@@ -133,3 +133,28 @@ typedef struct {
   MYFLT *in, *f0, *tau, *reinit;
   MYFLT x, y;
 } MVMFILT;
+
+/* Structures for the biquadbank and svfbank filter banks. Per-filter
+   coefficients and state are held as separate double arrays (SoA) so
+   the inner loop runs across filters */
+typedef struct {
+    OPDS    h;
+    MYFLT   *out;
+    MYFLT   *in;
+    ARRAYDAT *b0, *b1, *b2, *a1, *a2;
+    MYFLT   *reinit;
+    int32_t nfilt;
+    AUXCH   coefs;              /* b0[n], b1[n], b2[n], a1[n], a2[n] */
+    AUXCH   state;              /* z1[n], z2[n], y[n] */
+} BQBANK;
+
+typedef struct {
+    OPDS    h;
+    MYFLT   *out;
+    MYFLT   *in;
+    ARRAYDAT *freq, *q;
+    MYFLT   *mode, *reinit;
+    int32_t nfilt;
+    AUXCH   coefs;              /* g[n], k[n], c1[n], c2[n], c3[n], lf[n], lq[n] */
+    AUXCH   state;              /* ic1[n], ic2[n], y[n] */
+} SVFBANK;
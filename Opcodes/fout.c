@@ -273,6 +273,14 @@ static CS_NOINLINE int32_t fout_open_file(CSOUND *csound, FOUT_FILE *p, void *fp
     return idx;
 }
 
+/* counts the frames written to a capture file, for its index */
+
+static inline void fout_capture(CSOUND *csound, FOUT_FILE *p, int32_t nframes)
+{
+    STDOPCOD_GLOBALS  *pp = (STDOPCOD_GLOBALS*) csound->stdOp_Env;
+    csound->CaptureWrite(csound, pp->file_opened[p->idx - 1].fd, nframes);
+}
+
 static int32_t outfile(CSOUND *csound, OUTFILE *p)
 {
     uint32_t offset = p->h.insdshead->ksmps_offset;
@@ -307,6 +315,7 @@ static int32_t outfile(CSOUND *csound, OUTFILE *p)
         if (p->f.async==1)
           csound->WriteAsync(csound, p->f.fd, buf, p->buf_pos);
         else sf_write_MYFLT(p->f.sf, buf, p->buf_pos);
+        fout_capture(csound, &p->f, p->buf_pos / nargs);
         p->buf_pos = 0;
       }
 
@@ -350,6 +359,7 @@ static int32_t outfile_array(CSOUND *csound, OUTFILEA *p)
           csound->WriteAsync(csound, p->f.fd, buf, p->buf_pos);
         else
           sf_write_MYFLT(p->f.sf, buf, p->buf_pos);
+        fout_capture(csound, &p->f, p->buf_pos / nargs);
         p->buf_pos = 0;
        }
 
@@ -357,7 +367,7 @@ static int32_t outfile_array(CSOUND *csound, OUTFILEA *p)
     return OK;
 }
 
-static const int32_t fout_format_table[51] = {
+static const int32_t fout_format_table[52] = {
     /* 0 - 9 */
     (SF_FORMAT_FLOAT | SF_FORMAT_RAW), (SF_FORMAT_PCM_16 | SF_FORMAT_RAW),
     SF_FORMAT_PCM_16, SF_FORMAT_ULAW, SF_FORMAT_PCM_16, SF_FORMAT_PCM_32,
@@ -386,8 +396,8 @@ static const int32_t fout_format_table[51] = {
     (SF_FORMAT_PCM_16 | SF_FORMAT_IRCAM), (SF_FORMAT_PCM_32 | SF_FORMAT_IRCAM),
     (SF_FORMAT_FLOAT | SF_FORMAT_IRCAM), (SF_FORMAT_PCM_U8 | SF_FORMAT_IRCAM),
     (SF_FORMAT_PCM_24 | SF_FORMAT_IRCAM), (SF_FORMAT_DOUBLE | SF_FORMAT_IRCAM),
-    /* 50 */
-    (SF_FORMAT_OGG | SF_FORMAT_VORBIS)
+    /* 50 - 51 */
+    (SF_FORMAT_OGG | SF_FORMAT_VORBIS), TYPE2SF(TYP_CAPTURE)
 };
 
 static int32_t fout_flush_callback(CSOUND *csound, void *p_)
@@ -404,6 +414,7 @@ static int32_t fout_flush_callback(CSOUND *csound, void *p_)
         csound->WriteAsync(csound, p->f.fd, (MYFLT *) p->buf.auxp, p->buf_pos);
       else
         sf_write_MYFLT(p->f.sf, (MYFLT *) p->buf.auxp, p->buf_pos);
+      fout_capture(csound, &p->f, p->buf_pos / p->nargs);
     }
     return OK;
 }
@@ -422,6 +433,7 @@ static int32_t fouta_flush_callback(CSOUND *csound, void *p_)
         csound->WriteAsync(csound, p->f.fd, (MYFLT *) p->buf.auxp, p->buf_pos);
       else
         sf_write_MYFLT(p->f.sf, (MYFLT *) p->buf.auxp, p->buf_pos);
+      fout_capture(csound, &p->f, p->buf_pos / p->tabin->sizes[0]);
     }
     return OK;
 }
@@ -434,7 +446,7 @@ static int32_t outfile_set_S(CSOUND *csound, OUTFILE *p/*, int32_t istring*/)
 
     memset(&sfinfo, 0, sizeof(SF_INFO));
     format_ = (int32_t) MYFLT2LRND(*p->iflag);
-    if (format_ >= 51)
+    if (format_ >= 52)
       sfinfo.format = SF_FORMAT_PCM_16 | SF_FORMAT_RAW;
     else if (format_ < 0) {
       sfinfo.format = FORMAT2SF(csound->oparms->outformat);
@@ -493,7 +505,7 @@ static int32_t outfile_set_A(CSOUND *csound, OUTFILEA *p)
 
     memset(&sfinfo, 0, sizeof(SF_INFO));
     format_ = (int32_t) MYFLT2LRND(*p->iflag);
-     if (format_ >=  51)
+     if (format_ >=  52)
       sfinfo.format = SF_FORMAT_PCM_16 | SF_FORMAT_RAW;
     else if (format_ < 0) {
       sfinfo.format = FORMAT2SF(csound->oparms->outformat);
@@ -1280,6 +1292,47 @@ static int32_t clear(CSOUND *csound, CLEARS *p)
 }
 
 /*---------------------------------*/
+/* adds a marker to the index of a capture file: the -o output, or a
+   file written by fout */
+
+static int32_t capmark_(CSOUND *csound, CAPMARK *p, const char *fname)
+{
+    STDOPCOD_GLOBALS  *pp = (STDOPCOD_GLOBALS*) csound->stdOp_Env;
+    void    *fd = NULL;
+    int64_t sample;
+    int32_t idx;
+
+    if (fname != NULL) {
+      for (idx = 0; idx <= pp->file_num; idx++) {
+        if (pp->file_opened[idx].file != (SNDFILE*) NULL &&
+            strcmp(pp->file_opened[idx].name, fname) == 0)
+          break;
+      }
+      if (UNLIKELY(idx > pp->file_num))
+        return csound->InitError(csound, Str("capmark: %s is not open"),
+                                 fname);
+      fd = pp->file_opened[idx].fd;
+    }
+    sample = csound->GetCurrentTimeSamples(csound)
+             + p->h.insdshead->ksmps_offset;
+    /* an output that is not a capture is left alone */
+    if (csound->CaptureMarker(csound, fd, sample, p->label->data) != 0 &&
+        fname != NULL)
+      csound->Warning(csound, Str("capmark: %s is not a capture file"),
+                      fname);
+    return OK;
+}
+
+static int32_t capmark(CSOUND *csound, CAPMARK *p)
+{
+    return capmark_(csound, p, NULL);
+}
+
+static int32_t capmark_S(CSOUND *csound, CAPMARK *p)
+{
+    return capmark_(csound, p, p->fname->data);
+}
+
 /* formatted output to a text file */
 
 static int32_t fprintf_set_(CSOUND *csound, FPRINTF *p, int32_t istring)
@@ -1578,6 +1631,10 @@ static OENTRY localops[] = {
         (SUBR) fiopen_S,          (SUBR) NULL,        (SUBR) NULL, NULL},
     { "fiopen.i",     S(FIOPEN),      0, 1,  "i",    "ii",
         (SUBR) fiopen,          (SUBR) NULL,        (SUBR) NULL, NULL},
+    { "capmark",    S(CAPMARK),     0, 1,  "",     "S",
+        (SUBR) capmark,         (SUBR) NULL,        (SUBR) NULL, NULL},
+    { "capmark.S",  S(CAPMARK),     0, 1,  "",     "SS",
+        (SUBR) capmark_S,       (SUBR) NULL,        (SUBR) NULL, NULL},
     { "ficlose",    S(FICLOSE),     0, 1,  "",     "S",
         (SUBR) ficlose_opcode_S,  (SUBR) NULL,        (SUBR) NULL, NULL},
     { "ficlose.S",  S(FICLOSE),     0, 1,  "",     "i",
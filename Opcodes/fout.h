@@ -145,6 +145,11 @@ typedef struct {
     MYFLT   *iFile;
 } FICLOSE;
 
+typedef struct {
+    OPDS    h;
+    STRINGDAT *label, *fname;
+} CAPMARK;
+
 typedef struct {
     OPDS    h;
     MYFLT   *ihandle, *iascii, *iflag, *argums[VARGMAX-3];
@@ -44,6 +44,8 @@ typedef struct {
   uint8_t  *buf;
   AUXCH    auxch;
   FDCH     fdch;
+  void     *stream;       /* frames decoded by the I/O thread */
+  AUXCH    frames;
 } MP3IN;
 
 
@@ -56,7 +58,10 @@ typedef struct {
 
 int32_t mp3in_cleanup(CSOUND *csound, MP3IN *p)
 {
-    IGN(csound);
+    /* the I/O thread uses the decoder until the stream is closed */
+    if (p->stream != NULL)
+      csound->StreamClose(csound, p->stream);
+    p->stream = NULL;
     if (LIKELY(p->mpa != NULL))
       mp3dec_uninit(p->mpa);
     p->mpa = NULL;
@@ -64,6 +69,35 @@ int32_t mp3in_cleanup(CSOUND *csound, MP3IN *p)
 }
 
 
+/* decodes for csound->StreamOpen(), on the I/O thread: 16 bit samples
+   are converted to MYFLT, unscaled */
+
+static int32_t mp3in_stream_read(void *data, MYFLT *buf, int32_t nframes)
+{
+    MP3IN   *p = (MP3IN*) data;
+    int16_t *bb = (int16_t*) p->buf;
+    uint32_t nbytes = (uint32_t) nframes * p->OUTOCOUNT * sizeof(int16_t);
+    uint32_t used = 0, i;
+
+    if (nbytes > (uint32_t) p->bufSize)
+      nbytes = (uint32_t) p->bufSize;
+    nbytes -= nbytes % (p->OUTOCOUNT * sizeof(int16_t));  /* whole frames */
+    p->r = mp3dec_decode(p->mpa, p->buf, nbytes, &used);
+    if (p->r != MP3DEC_RETCODE_OK)
+      return 0;
+    used /= sizeof(int16_t);
+    for (i = 0; i < used; i++)
+      buf[i] = (MYFLT) bb[i] * (FL(1.0) / (MYFLT) 0x7fff);
+    return (int32_t) (used / p->OUTOCOUNT);
+}
+
+static int32_t mp3in_stream_seek(void *data, int64_t frame)
+{
+    MP3IN   *p = (MP3IN*) data;
+    return (mp3dec_seek(p->mpa, frame, MP3DEC_SEEK_SAMPLES)
+            == MP3DEC_RETCODE_OK ? 0 : -1);
+}
+
 int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
 {
     char    name[1024];
@@ -81,11 +115,16 @@ int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
     int32_t skip;
     if (p->OUTOCOUNT==1) config.mode = MPADEC_CONFIG_MONO;
     /* if already open, close old file first */
-    if (p->fdch.fd != NULL) {
-      /* skip initialisation if requested */
+    if (p->stream != NULL || p->fdch.fd != NULL) {
+      /* skip initialisation if requested, keeping the stream going */
       if (*(p->iSkipInit) != FL(0.0))
         return OK;
-      csound->FDClose(csound, &(p->fdch));
+      if (p->stream != NULL) {
+        csound->StreamClose(csound, p->stream);
+        p->stream = NULL;
+      }
+      if (p->fdch.fd != NULL)
+        csound->FDClose(csound, &(p->fdch));
     }
     /* set default format parameters */
     /* open file */
@@ -188,6 +227,15 @@ int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
     //if(!skip)
     //mp3dec_seek(mpa, skip, MP3DEC_SEEK_SAMPLES);
     p->r = r;
+    /* decode ahead on the I/O thread from here on */
+    if (r == MP3DEC_RETCODE_OK) {
+      csound->AuxAlloc(csound, CS_KSMPS * p->OUTOCOUNT * sizeof(MYFLT),
+                       &p->frames);
+      p->stream = csound->StreamOpen(csound, name, p->OUTOCOUNT, -1, 0,
+                                     mp3in_stream_read, mp3in_stream_seek,
+                                     (void*) p, csound->oparms->realtime ?
+                                     0 : CS_STREAM_WAIT);
+    }
     if (p->initDone == 0)
       csound->RegisterDeinitCallback(csound, p,
                                      (int32_t (*)(CSOUND*, void*)) mp3in_cleanup);
@@ -228,6 +276,23 @@ int32_t mp3in(CSOUND *csound, MP3IN *p)
       memset(&al[nsmps], '\0', early*sizeof(MYFLT));
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
+    if (p->stream != NULL) {
+      MYFLT   *fr = (MYFLT*) p->frames.auxp;
+      uint32_t nch = p->OUTOCOUNT, got = 0;
+      if (nsmps > offset)
+        got = (uint32_t) csound->StreamRead(csound, p->stream, -1, fr,
+                                            (int32_t) (nsmps - offset));
+      for (n = 0; n < got; n++) {
+        al[offset + n] = fr[n * nch] * csound->e0dbfs;
+        if (nch > 1)
+          ar[offset + n] = fr[n * nch + 1] * csound->e0dbfs;
+      }
+      /* end of file, or the decoder fell behind */
+      memset(&al[offset + got], 0, (nsmps - offset - got) * sizeof(MYFLT));
+      if (nch > 1)
+        memset(&ar[offset + got], 0, (nsmps - offset - got) * sizeof(MYFLT));
+      return OK;
+    }
     for (n=offset; n<nsmps; n++) {
       for (i=0; i<p->OUTOCOUNT; i++) {     /* stereo */
         MYFLT xx;
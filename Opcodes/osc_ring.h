@@ -0,0 +1,156 @@
+/*
+    osc_ring.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* The ring of messages received for one OSClisten (Opcodes/OSC.c).  It
+   knows nothing of liblo, so that it can be tested on its own. */
+
+#ifndef OSC_RING_H
+#define OSC_RING_H
+
+#include "csdl.h"
+
+#define OSC_ARG_CNT     (64)
+#define OSC_RING_SIZE   (4096)
+
+/* one argument of a received message */
+typedef union {
+    MYFLT   number;
+    char    *string;
+    void    *blob;
+} OSC_ARG;
+
+/* Messages received for one OSClisten, from the server thread of its port
+   (the only writer) to the performance thread (the only reader).  It is
+   a fixed number of records, so nothing is allocated for a number; when
+   it is full, messages are dropped and counted. */
+typedef struct {
+    OSC_ARG *args;              /* 'size' records of 'nargs' arguments */
+    double  *time;              /* bundle time of each, 0.0 for now */
+    int32_t nargs;
+    uint32_t size;              /* a power of two */
+    volatile long rp, wp;
+    volatile long dropped;
+} OSC_RING;
+
+/* the ring of one listener, set up at init time */
+
+static inline void osc_ring_init(CSOUND *csound, OSC_RING *r, int32_t nargs,
+                                 uint32_t size)
+{
+    uint32_t n = 1;
+
+    while (n < size)
+      n <<= 1;
+    r->nargs = (nargs > 0 ? nargs : 1);
+    r->size = n;
+    r->args = (OSC_ARG*) csound->Calloc(csound, (size_t) n * r->nargs
+                                                * sizeof(OSC_ARG));
+    r->time = (double*) csound->Calloc(csound, (size_t) n * sizeof(double));
+    r->rp = r->wp = 0;
+    r->dropped = 0;
+}
+
+/* the record to fill in for the next message, or NULL if the ring is
+   full, which counts the message as dropped; only the server thread
+   calls this */
+
+static inline OSC_ARG *osc_ring_next(OSC_RING *r)
+{
+    uint32_t wp = (uint32_t) r->wp;
+
+    if (wp - (uint32_t) ATOMIC_GET(r->rp) >= r->size) {
+      ATOMIC_INCR(r->dropped);
+      return NULL;
+    }
+    return &r->args[(size_t) (wp & (r->size - 1)) * r->nargs];
+}
+
+static inline void osc_ring_push(OSC_RING *r, double time)
+{
+    uint32_t wp = (uint32_t) r->wp;
+
+    r->time[wp & (r->size - 1)] = time;
+    ATOMIC_SET(r->wp, (long) (uint32_t) (wp + 1));
+}
+
+/* done with the record osc_ring_due() returned */
+
+static inline void osc_ring_take(OSC_RING *r)
+{
+    uint32_t rp = (uint32_t) r->rp;
+
+    ATOMIC_SET(r->rp, (long) (uint32_t) (rp + 1));
+}
+
+/* Moves the message at 'i' to the front of the ring, before the held
+   messages from rp; the reader owns the records from rp to wp. */
+
+static inline void osc_ring_rotate(OSC_RING *r, uint32_t rp, uint32_t i)
+{
+    OSC_ARG  tmp[OSC_ARG_CNT];
+    uint32_t mask = r->size - 1;
+    size_t   len = (size_t) r->nargs * sizeof(OSC_ARG);
+    double   t = r->time[i & mask];
+
+    memcpy(tmp, &r->args[(size_t) (i & mask) * r->nargs], len);
+    for ( ; i != rp; i--) {
+      memcpy(&r->args[(size_t) (i & mask) * r->nargs],
+             &r->args[(size_t) ((i - 1) & mask) * r->nargs], len);
+      r->time[i & mask] = r->time[(i - 1) & mask];
+    }
+    memcpy(&r->args[(size_t) (rp & mask) * r->nargs], tmp, len);
+    r->time[rp & mask] = t;
+}
+
+/* The oldest message if it is due in the cycle of ksmps samples from
+   'start', with its sample in the cycle in 'offset'.  Messages that are
+   not in a bundle are due at once, and pass bundled messages held for
+   a later cycle.  now(data, start) gives the wall clock in samples
+   less the score time; it is only asked when a bundle is at the front. */
+
+static inline OSC_ARG *osc_ring_due(OSC_RING *r, double start, double ksmps,
+                                    double sr,
+                                    double (*now)(void *, double),
+                                    void *data, int32_t *offset)
+{
+    uint32_t rp = (uint32_t) r->rp, wp = (uint32_t) ATOMIC_GET(r->wp), i;
+    double   t;
+
+    if (wp == rp)
+      return NULL;
+    *offset = 0;
+    if ((t = r->time[rp & (r->size - 1)]) > 0.0) {
+      t = t * sr - now(data, start);
+      if (t >= start + ksmps) {
+        for (i = rp + 1; i != wp; i++)
+          if (r->time[i & (r->size - 1)] == 0.0)
+            break;
+        if (i == wp)
+          return NULL;
+        osc_ring_rotate(r, rp, i);
+      }
+      else if (t > start)
+        *offset = (int32_t) (t - start);
+    }
+    return &r->args[(size_t) (rp & (r->size - 1)) * r->nargs];
+}
+
+#endif  /* OSC_RING_H */
@@ -87,7 +87,8 @@ typedef struct {
 
 typedef struct {
     OPDS        h;
-    MYFLT       *instrnum, *ipercent, *iopc;    /* IV - Oct 31 2002 */
+    MYFLT       *instrnum, *ipercent;           /* IV - Oct 31 2002 */
+    MYFLT       *isteal, *ifade;                /* maxalloc voice stealing */
 } CPU_PERC;
 
 typedef struct {
@@ -157,6 +157,29 @@ int32_t cpuperc_S(CSOUND *csound, CPU_PERC *p)
     return OK;
 }
 
+/* maxalloc insnum, icount [, isteal [, ifade]]: past icount voices,
+   a new MIDI note is refused (isteal 0), or takes over the oldest voice
+   (1), the quietest one (2) or one playing the same note (3, else the
+   oldest), which fades out over ifade seconds (default 5 ms). */
+
+static int32_t set_maxalloc(CSOUND *csound, CPU_PERC *p, int32_t n)
+{
+    int32_t steal = (int32_t) *p->isteal;
+    INSTRTXT *tp;
+
+    if (UNLIKELY(steal < VOICE_STEAL_NONE || steal > VOICE_STEAL_SAMENOTE))
+      return csound->InitError(csound, Str("maxalloc: invalid stealing "
+                                           "mode %d"), steal);
+    if (n > 0 && n <= csound->engineState.maxinsno &&
+        (tp = csound->engineState.instrtxtp[n]) != NULL) {
+      /* If instrument exists */
+      tp->maxalloc = (int32_t)*p->ipercent;
+      tp->steal = steal;
+      tp->stealfade = (*p->ifade < FL(0.0) ? FL(0.005) : *p->ifade);
+    }
+    return OK;
+}
+
 int32_t maxalloc(CSOUND *csound, CPU_PERC *p)
 {
     int32_t n;
@@ -166,21 +189,13 @@ int32_t maxalloc(CSOUND *csound, CPU_PERC *p)
       n = csound->strarg2insno(csound,ss,1);
     }
     else n = *p->instrnum;
-    if (n > 0 && n <= csound->engineState.maxinsno &&
-        csound->engineState.instrtxtp[n] != NULL)
-      /* If instrument exists */
-      csound->engineState.instrtxtp[n]->maxalloc = (int32_t)*p->ipercent;
-    return OK;
+    return set_maxalloc(csound, p, n);
 }
 
 int32_t maxalloc_S(CSOUND *csound, CPU_PERC *p)
 {
     int32_t n = csound->strarg2insno(csound, ((STRINGDAT *)p->instrnum)->data, 1);
-    if (n > 0 && n <= csound->engineState.maxinsno &&
-        csound->engineState.instrtxtp[n] != NULL)
-      /* If instrument exists */
-      csound->engineState.instrtxtp[n]->maxalloc = (int32_t)*p->ipercent;
-    return OK;
+    return set_maxalloc(csound, p, n);
 }
 
 int32_t pfun(CSOUND *csound, PFUN *p)
@@ -0,0 +1,687 @@
+/*
+  sockstream.c:
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/* streamsend and streamrecv: audio over UDP between Csound processes.
+
+   Unlike socksend/sockrecv, each packet is numbered and carries the
+   frame time of its first sample, so the receiver can put packets back
+   in order, tell a lost packet from a late one and measure the network
+   jitter.  A packet holds one block of interleaved frames from any
+   number of channels, as 32 bit floats in network byte order, after a
+   header (all fields big endian):
+
+     uint32   magic             'CSst'
+     uint32   sequence          block number
+     uint32   time (high)       frame number of the first frame
+     uint32   time (low)
+     uint16   channels
+     uint16   frames            per block
+     uint8    redundancy        copies of earlier blocks that follow
+     uint8    flags             zero
+     uint16   reserved          zero
+
+   With redundancy R, block n is followed by blocks n-1 ... n-R, so a
+   lost packet is recovered from any of the next R.  The block is as
+   long as fits in one datagram, so it is shorter for more channels or
+   more redundancy.
+
+   The receiving thread stores blocks in a ring of slots indexed by
+   sequence number, each guarded by a version count (odd while it is
+   written), so the performance thread never waits for it.  streamrecv
+   plays out a number of frames behind the newest block: the target
+   latency starts at ilatency, grows by a block after each underrun
+   and, while the stream is steady, shrinks back towards four times the
+   measured jitter, never below ilatency or above imaxlatency.  Latency
+   is given up by skipping a block, crossfaded.  A block that is missing
+   when it is due is concealed by the previous one played backwards and
+   faded out; playing resumes with a fade in.
+
+   To test over loopback, use "127.0.0.1" as the address; streamrecv's
+   iloss discards that fraction of the packets it receives, to hear the
+   recovery and concealment at work.  If istats is a table, streamrecv
+   writes its counts there every k-cycle: packets received, blocks
+   recovered, late packets, blocks concealed, blocks skipped, underruns
+   and the latency in frames. */
+
+/* Haiku 'int32' etc definitions in net headers conflict with sysdep.h */
+#define __HAIKU_CONFLICT
+
+#include "csoundCore.h"
+#include <stdlib.h>
+#include <sys/types.h>
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#define SOCKET_ERROR (-1)
+#endif
+#include <string.h>
+#include <errno.h>
+
+#define MTU             (1456)
+#define STREAM_MAGIC    0x43537374U
+#define STREAM_HDR      24
+#define STREAM_MAXSAMPS ((MTU - STREAM_HDR) / 4)
+#define STREAM_MAXREDUND 8
+#define STREAM_SLOTS    256             /* a power of two */
+/* outputs of streamrecv: as many as there are 'm's in its OENTRY, which
+   is where the engine puts the first input */
+#define STREAM_MAXOUT   24
+
+#ifndef WIN32
+extern  int32_t     inet_aton(const char *cp, struct in_addr *inp);
+#endif
+
+typedef struct {
+  OPDS    h;
+  STRINGDAT *ipaddress;
+  MYFLT   *port, *redund;
+  MYFLT   *asig[VARGMAX];
+  AUXCH   hist, pkt;
+  int32_t sock;
+  int32_t chans, frames, redundancy;
+  int32_t wp;                           /* frames in the current block  */
+  uint32_t seq;                         /* of the current block         */
+  int64_t stamp;                        /* its first frame              */
+  int32_t warned;
+  struct sockaddr_in server_addr;
+} STREAMSEND;
+
+typedef struct {
+  volatile long ver;                    /* odd while being written      */
+  uint32_t  seq;
+  MYFLT     data[STREAM_MAXSAMPS];
+} STREAMSLOT;
+
+typedef struct {
+  OPDS    h;
+  MYFLT   *aout[STREAM_MAXOUT];
+  MYFLT   *port, *latency, *maxlatency, *loss, *istats;
+  AUXCH   slots, buffers, pkt;
+  FUNC    *stats;
+  STREAMSLOT *slot;
+  int32_t sock;
+  CSOUND  *cs;
+  void    *thrid;
+  volatile long threadon;
+  /* written by the receiving thread */
+  volatile long gen;                    /* new stream, or new layout    */
+  volatile long hiseq;                  /* newest block stored          */
+  volatile long jitter;                 /* in frames                    */
+  int32_t rchans, rframes;
+  double  transit, jit;
+  int32_t havetransit;
+  RTCLOCK clock;
+  uint32_t seed;
+  long    received, recovered, late;
+  /* written by the performance thread */
+  volatile long playgen, playseq;
+  long    mygen;
+  int32_t chans, frames, nout;
+  uint32_t pseq;                        /* next block to play           */
+  int32_t pofs;                         /* frames played of 'cur'       */
+  int32_t playing, fadein, concealing, hasprev;
+  int32_t target, minlat, maxlat, stable;
+  MYFLT   *cur, *prev, *next;
+  long    concealed, dropped, underruns;
+  struct sockaddr_in server_addr;
+} STREAMRECV;
+
+static inline void put_u32(unsigned char *b, uint32_t v)
+{
+    v = htonl(v);
+    memcpy(b, &v, 4);
+}
+
+static inline uint32_t get_u32(const unsigned char *b)
+{
+    uint32_t v;
+    memcpy(&v, b, 4);
+    return ntohl(v);
+}
+
+static inline void put_float(unsigned char *b, MYFLT x)
+{
+    float   f = (float) x;
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    put_u32(b, v);
+}
+
+static inline MYFLT get_float(const unsigned char *b)
+{
+    uint32_t v = get_u32(b);
+    float   f;
+    memcpy(&f, &v, 4);
+    return (MYFLT) f;
+}
+
+static void stream_close_socket(int32_t sock)
+{
+#ifndef WIN32
+    close(sock);
+#else
+    closesocket(sock);
+#endif
+}
+
+/* streamsend */
+
+static int32_t stream_send_deinit(CSOUND *csound, void *pdata)
+{
+    STREAMSEND *p = (STREAMSEND *) pdata;
+    (void) csound;
+    stream_close_socket(p->sock);
+    return OK;
+}
+
+static int32_t init_stream_send(CSOUND *csound, STREAMSEND *p)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+    WSADATA wsaData = {0};
+    int32_t err;
+    if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0))
+      return csound->InitError(csound, Str("Winsock2 failed to start: %d"), err);
+#endif
+    p->chans = (int32_t) p->INOCOUNT - 3;
+    p->redundancy = (int32_t) *p->redund;
+    if (UNLIKELY(p->redundancy < 0 || p->redundancy > STREAM_MAXREDUND))
+      return csound->InitError(csound, Str("streamsend: redundancy must be "
+                                           "between 0 and %d"),
+                               STREAM_MAXREDUND);
+    p->frames = STREAM_MAXSAMPS / (p->chans * (p->redundancy + 1));
+    if (UNLIKELY(p->frames < 1))
+      return csound->InitError(csound, Str("streamsend: %d channels with "
+                                           "redundancy %d do not fit in a "
+                                           "packet"),
+                               p->chans, p->redundancy);
+    p->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (UNLIKELY(p->sock == SOCKET_ERROR))
+      return csound->InitError(csound, Str("creating socket"));
+    /* create server address: where we want to send to and clear it out */
+    memset(&p->server_addr, 0, sizeof(p->server_addr));
+    p->server_addr.sin_family = AF_INET;    /* it is an INET address */
+#if defined(WIN32) && !defined(__CYGWIN__)
+    p->server_addr.sin_addr.S_un.S_addr =
+      inet_addr((const char *) p->ipaddress->data);
+#else
+    inet_aton((const char *) p->ipaddress->data,
+              &p->server_addr.sin_addr);    /* the server IP address */
+#endif
+    p->server_addr.sin_port = htons((int32_t) *p->port);    /* the port */
+    csound->RegisterDeinitCallback(csound, (void *) p, stream_send_deinit);
+
+    /* the last redundancy+1 blocks, interleaved */
+    csound->AuxAlloc(csound, (p->redundancy + 1) * p->frames * p->chans
+                             * sizeof(MYFLT), &p->hist);
+    csound->AuxAlloc(csound, MTU, &p->pkt);
+    p->wp = 0;
+    p->seq = 0;
+    p->stamp = 0;
+    p->warned = 0;
+    return OK;
+}
+
+static void stream_send_block(CSOUND *csound, STREAMSEND *p)
+{
+    unsigned char *pkt = (unsigned char *) p->pkt.auxp;
+    MYFLT   *hist = (MYFLT *) p->hist.auxp;
+    int32_t blksmps = p->frames * p->chans;
+    int32_t nredund, k, i, len;
+    unsigned char *b;
+
+    /* the first blocks have fewer to repeat */
+    nredund = ((uint32_t) p->redundancy > p->seq ?
+               (int32_t) p->seq : p->redundancy);
+    put_u32(pkt, STREAM_MAGIC);
+    put_u32(pkt + 4, p->seq);
+    put_u32(pkt + 8, (uint32_t) ((uint64_t) p->stamp >> 32));
+    put_u32(pkt + 12, (uint32_t) p->stamp);
+    pkt[16] = (unsigned char) (p->chans >> 8);
+    pkt[17] = (unsigned char) p->chans;
+    pkt[18] = (unsigned char) (p->frames >> 8);
+    pkt[19] = (unsigned char) p->frames;
+    pkt[20] = (unsigned char) nredund;
+    pkt[21] = pkt[22] = pkt[23] = 0;
+    b = pkt + STREAM_HDR;
+    for (k = 0; k <= nredund; k++) {
+      MYFLT *blk = hist + ((p->seq - k) % (p->redundancy + 1)) * blksmps;
+      for (i = 0; i < blksmps; i++, b += 4)
+        put_float(b, blk[i]);
+    }
+    len = (int32_t) (b - pkt);
+    if (UNLIKELY(sendto(p->sock, (void *) pkt, len, 0,
+                        (const struct sockaddr *) &p->server_addr,
+                        sizeof(p->server_addr)) == SOCKET_ERROR)) {
+      /* the network may come back; the stream carries on */
+      if (!p->warned)
+        csound->Warning(csound, Str("streamsend: sendto failed"));
+      p->warned = 1;
+    }
+    p->seq++;
+    p->stamp += p->frames;
+}
+
+static int32_t perf_stream_send(CSOUND *csound, STREAMSEND *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t i, nsmps = CS_KSMPS;
+    int32_t c, chans = p->chans, frames = p->frames;
+    MYFLT   *blk;
+
+    blk = (MYFLT *) p->hist.auxp
+          + (p->seq % (p->redundancy + 1)) * frames * chans;
+    /* a late start or early end still sends whole blocks, of silence */
+    for (i = 0; i < nsmps; i++) {
+      MYFLT *f = blk + p->wp * chans;
+      if (UNLIKELY(i < offset || i >= nsmps - early))
+        for (c = 0; c < chans; c++)
+          f[c] = FL(0.0);
+      else
+        for (c = 0; c < chans; c++)
+          f[c] = p->asig[c][i] / csound->e0dbfs;
+      if (++p->wp == frames) {
+        stream_send_block(csound, p);
+        p->wp = 0;
+        blk = (MYFLT *) p->hist.auxp
+              + (p->seq % (p->redundancy + 1)) * frames * chans;
+      }
+    }
+    return OK;
+}
+
+/* streamrecv: the receiving thread */
+
+#define SLOT_AT(p, s)   (&(p)->slot[(s) & (STREAM_SLOTS - 1)])
+
+static void stream_store(STREAMRECV *p, uint32_t seq,
+                         const unsigned char *b, int32_t nsmps)
+{
+    STREAMSLOT *s = SLOT_AT(p, seq);
+    int32_t i;
+
+    ATOMIC_SET(s->ver, s->ver + 1);
+    s->seq = seq;
+    for (i = 0; i < nsmps; i++, b += 4)
+      s->data[i] = get_float(b);
+    ATOMIC_SET(s->ver, s->ver + 1);
+}
+
+/* a new stream (or one with a new layout): forget all that was stored */
+
+static void stream_restart(STREAMRECV *p, uint32_t seq, int32_t chans,
+                           int32_t frames)
+{
+    int32_t i;
+    for (i = 0; i < STREAM_SLOTS; i++) {
+      STREAMSLOT *s = &p->slot[i];
+      ATOMIC_SET(s->ver, s->ver + 1);
+      s->seq = seq + 0x80000000U;
+      ATOMIC_SET(s->ver, s->ver + 1);
+    }
+    p->rchans = chans;
+    p->rframes = frames;
+    p->jit = 0.0;
+    p->havetransit = 0;
+    ATOMIC_SET(p->jitter, 0);
+    ATOMIC_SET(p->hiseq, (long) (seq - 1));
+    ATOMIC_SET(p->gen, p->gen + 1);
+}
+
+static void stream_packet(STREAMRECV *p, const unsigned char *pkt,
+                          int32_t bytes)
+{
+    uint32_t seq, hiseq;
+    uint64_t stamp;
+    int32_t chans, frames, nredund, blksmps, k;
+    double  arrival, transit;
+
+    if (bytes < STREAM_HDR || get_u32(pkt) != STREAM_MAGIC)
+      return;
+    seq = get_u32(pkt + 4);
+    stamp = ((uint64_t) get_u32(pkt + 8) << 32) | get_u32(pkt + 12);
+    chans = (pkt[16] << 8) | pkt[17];
+    frames = (pkt[18] << 8) | pkt[19];
+    nredund = pkt[20];
+    blksmps = chans * frames;
+    if (chans < 1 || frames < 1 || blksmps > STREAM_MAXSAMPS ||
+        bytes < STREAM_HDR + (nredund + 1) * blksmps * 4)
+      return;
+    if (*p->loss > FL(0.0) &&
+        (double) (p->seed = p->seed * 1664525U + 1013904223U)
+        < *p->loss * 4294967296.0)
+      return;                           /* lost on purpose, for testing */
+    p->received++;
+    hiseq = (uint32_t) ATOMIC_GET(p->hiseq);
+    if (p->gen == 0 || chans != p->rchans || frames != p->rframes ||
+        (int32_t) (seq - hiseq) > STREAM_SLOTS ||
+        (int32_t) (seq - hiseq) < -STREAM_SLOTS) {
+      stream_restart(p, seq, chans, frames);
+      hiseq = seq - 1;
+    }
+    if (ATOMIC_GET(p->playgen) == p->gen &&
+        (int32_t) (seq - (uint32_t) ATOMIC_GET(p->playseq)) < 0) {
+      p->late++;
+      return;
+    }
+    /* interarrival jitter, as RTP has it, in frames */
+    arrival = p->cs->GetRealTime(&p->clock) * p->cs->esr;
+    transit = arrival - (double) stamp;
+    if ((int32_t) (seq - hiseq) > 0) {
+      if (p->havetransit) {
+        double d = transit - p->transit;
+        p->jit += ((d < 0.0 ? -d : d) - p->jit) / 16.0;
+        ATOMIC_SET(p->jitter, (long) (p->jit + 0.5));
+      }
+      p->transit = transit;
+      p->havetransit = 1;
+    }
+    for (k = 0; k <= nredund; k++) {
+      uint32_t   bseq = seq - k;
+      STREAMSLOT *s = SLOT_AT(p, bseq);
+      if (k > 0) {
+        if (ATOMIC_GET(p->playgen) == p->gen &&
+            (int32_t) (bseq - (uint32_t) ATOMIC_GET(p->playseq)) < 0)
+          break;                        /* too late to be of use */
+        if (s->seq == bseq)
+          continue;                     /* we have it already */
+        p->recovered++;
+      }
+      stream_store(p, bseq, pkt + STREAM_HDR + k * blksmps * 4, blksmps);
+    }
+    if ((int32_t) (seq - hiseq) > 0)
+      ATOMIC_SET(p->hiseq, (long) seq);
+}
+
+static uintptr_t stream_recv_thread(void *pdata)
+{
+    STREAMRECV *p = (STREAMRECV *) pdata;
+    unsigned char *pkt = (unsigned char *) p->pkt.auxp;
+    struct sockaddr from;
+    socklen_t clilen;
+    int32_t bytes;
+
+    while (ATOMIC_GET(p->threadon)) {
+      clilen = sizeof(from);
+      /* times out now and then, to see if it should stop */
+      if ((bytes = recvfrom(p->sock, (void *) pkt, MTU, 0,
+                            &from, &clilen)) > 0)
+        stream_packet(p, pkt, bytes);
+    }
+    return (uintptr_t) 0;
+}
+
+static int32_t stream_recv_deinit(CSOUND *csound, void *pdata)
+{
+    STREAMRECV *p = (STREAMRECV *) pdata;
+
+    ATOMIC_SET(p->threadon, 0);
+    csound->JoinThread(p->thrid);
+    stream_close_socket(p->sock);
+    if (p->received)
+      csound->Message(csound, Str("streamrecv: %ld packets, %ld blocks "
+                                  "recovered, %ld late, %ld concealed, "
+                                  "%ld skipped, %ld underruns; latency "
+                                  "%d frames\n"),
+                      p->received, p->recovered, p->late, p->concealed,
+                      p->dropped, p->underruns, p->target);
+    return OK;
+}
+
+static int32_t init_stream_recv(CSOUND *csound, STREAMRECV *p)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+    WSADATA wsaData = {0};
+    DWORD   tv = 100;
+    int32_t err;
+    if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0))
+      return csound->InitError(csound, Str("Winsock2 failed to start: %d"), err);
+#else
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+#endif
+    p->nout = (int32_t) p->OUTOCOUNT;
+    p->minlat = (int32_t) (*p->latency > FL(0.0) ?
+                           *p->latency * FL(0.001) * csound->esr :
+                           FL(0.005) * csound->esr);
+    p->maxlat = (int32_t) (*p->maxlatency > FL(0.0) ?
+                           *p->maxlatency * FL(0.001) * csound->esr :
+                           FL(0.1) * csound->esr);
+    if (p->maxlat < p->minlat)
+      p->maxlat = p->minlat;
+    p->cs = csound;
+    p->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (UNLIKELY(p->sock == SOCKET_ERROR))
+      return csound->InitError(csound, Str("creating socket"));
+    if (UNLIKELY(setsockopt(p->sock, SOL_SOCKET, SO_RCVTIMEO,
+                            (const char *) &tv, sizeof(tv)) < 0)) {
+      stream_close_socket(p->sock);
+      return csound->InitError(csound, Str("streamrecv: cannot set a "
+                                           "receive timeout"));
+    }
+    /* create server address: where we want to send to and clear it out */
+    memset(&p->server_addr, 0, sizeof(p->server_addr));
+    p->server_addr.sin_family = AF_INET;    /* it is an INET address */
+    p->server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    p->server_addr.sin_port = htons((int32_t) *p->port);    /* the port */
+    /* associate the socket with the address and port */
+    if (UNLIKELY(bind(p->sock, (struct sockaddr *) &p->server_addr,
+                      sizeof(p->server_addr)) == SOCKET_ERROR)) {
+      stream_close_socket(p->sock);
+      return csound->InitError(csound, Str("bind failed"));
+    }
+
+    csound->AuxAlloc(csound, STREAM_SLOTS * sizeof(STREAMSLOT), &p->slots);
+    csound->AuxAlloc(csound, 3 * STREAM_MAXSAMPS * sizeof(MYFLT), &p->buffers);
+    csound->AuxAlloc(csound, MTU, &p->pkt);
+    p->slot = (STREAMSLOT *) p->slots.auxp;
+    p->cur = (MYFLT *) p->buffers.auxp;
+    p->prev = p->cur + STREAM_MAXSAMPS;
+    p->next = p->prev + STREAM_MAXSAMPS;
+    p->gen = p->mygen = p->playgen = 0;
+    p->hiseq = p->playseq = 0;
+    p->jitter = 0;
+    p->rchans = p->rframes = 0;
+    p->chans = p->frames = p->pofs = 0;
+    p->target = p->minlat;
+    p->received = p->recovered = p->late = 0;
+    p->concealed = p->dropped = p->underruns = 0;
+    p->seed = 0x9E3779B9U;
+    p->stats = NULL;
+    if (*p->istats > FL(0.0) &&
+        UNLIKELY((p->stats = csound->FTnp2Find(csound, p->istats)) == NULL)) {
+      stream_close_socket(p->sock);
+      return csound->InitError(csound, Str("streamrecv: stats table %d "
+                                           "not found"), (int32_t) *p->istats);
+    }
+    csound->InitTimerStruct(&p->clock);
+    /* create thread */
+    p->threadon = 1;
+    p->thrid = csound->CreateThread(stream_recv_thread, (void *) p);
+    csound->RegisterDeinitCallback(csound, (void *) p, stream_recv_deinit);
+    return OK;
+}
+
+/* streamrecv: the performance thread */
+
+/* copies block 'seq' into 'buf'; zero if it is not there (yet) */
+
+static int32_t stream_fetch(STREAMRECV *p, uint32_t seq, MYFLT *buf)
+{
+    STREAMSLOT *s = SLOT_AT(p, seq);
+    long    ver = ATOMIC_GET(s->ver);
+
+    if ((ver & 1) || s->seq != seq)
+      return 0;
+    memcpy(buf, s->data, p->frames * p->chans * sizeof(MYFLT));
+    return (ATOMIC_GET(s->ver) == ver);
+}
+
+/* the previous block backwards, fading out, or silence after that */
+
+static void stream_conceal(STREAMRECV *p)
+{
+    int32_t i, c, chans = p->chans, frames = p->frames;
+    MYFLT   g, dg = FL(1.0) / (MYFLT) frames;
+
+    p->fadein = 1;
+    if (p->concealing++ || !p->hasprev) {
+      memset(p->cur, 0, frames * chans * sizeof(MYFLT));
+      return;
+    }
+    for (i = 0, g = FL(1.0); i < frames; i++, g -= dg)
+      for (c = 0; c < chans; c++)
+        p->cur[i * chans + c] = p->prev[(frames - 1 - i) * chans + c] * g;
+}
+
+static void stream_next_block(STREAMRECV *p)
+{
+    int32_t i, c, chans = p->chans, frames = p->frames;
+    int32_t ahead, ideal;
+    uint32_t hiseq = (uint32_t) ATOMIC_GET(p->hiseq);
+    MYFLT   g, dg = FL(1.0) / (MYFLT) frames;
+
+    /* the target follows the measured jitter up at once, down slowly */
+    ideal = frames + 4 * (int32_t) ATOMIC_GET(p->jitter);
+    if (ideal < p->minlat) ideal = p->minlat;
+    if (ideal > p->maxlat) ideal = p->maxlat;
+    if (ideal > p->target)
+      p->target = ideal;
+    else if (ideal < p->target && ++p->stable * frames > 2 * p->cs->esr) {
+      p->target = (p->target - frames > ideal ? p->target - frames : ideal);
+      p->stable = 0;
+    }
+    if (p->target > (STREAM_SLOTS / 2) * frames)
+      p->target = (STREAM_SLOTS / 2) * frames;
+
+    ahead = (int32_t) (hiseq - p->pseq) + 1;        /* blocks to play */
+    if (!p->playing) {
+      if (ahead * frames < p->target) {
+        stream_conceal(p);
+        return;
+      }
+      p->playing = 1;
+    }
+    if (ahead <= 0) {                               /* ran dry */
+      p->underruns++;
+      p->playing = 0;
+      p->stable = 0;
+      p->target = (p->target + frames < p->maxlat ?
+                   p->target + frames : p->maxlat);
+      stream_conceal(p);
+      return;
+    }
+    if (!stream_fetch(p, p->pseq, p->cur)) {         /* lost */
+      p->concealed++;
+      p->pseq++;
+      stream_conceal(p);
+      ATOMIC_SET(p->playseq, (long) p->pseq);
+      return;
+    }
+    p->pseq++;
+    if ((ahead - 1) * frames > p->target + frames &&
+        stream_fetch(p, p->pseq, p->next)) {
+      /* too far behind: skip a block, crossfading into the one after */
+      for (i = 0, g = FL(0.0); i < frames; i++, g += dg)
+        for (c = 0; c < chans; c++)
+          p->cur[i * chans + c] = p->cur[i * chans + c] * (FL(1.0) - g)
+                                  + p->next[i * chans + c] * g;
+      p->pseq++;
+      p->dropped++;
+    }
+    ATOMIC_SET(p->playseq, (long) p->pseq);
+    if (p->fadein) {
+      for (i = 0, g = FL(0.0); i < frames; i++, g += dg)
+        for (c = 0; c < chans; c++)
+          p->cur[i * chans + c] *= g;
+      p->fadein = 0;
+    }
+    p->concealing = 0;
+    memcpy(p->prev, p->cur, frames * chans * sizeof(MYFLT));
+    p->hasprev = 1;
+}
+
+static int32_t perf_stream_recv(CSOUND *csound, STREAMRECV *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t i, nsmps = CS_KSMPS;
+    int32_t c, nout = p->nout, chans;
+    long    gen = ATOMIC_GET(p->gen);
+
+    for (c = 0; c < nout; c++)
+      memset(p->aout[c], 0, nsmps * sizeof(MYFLT));
+    if (p->stats != NULL) {
+      MYFLT   v[7];
+      int32_t n = (p->stats->flen < 7 ? (int32_t) p->stats->flen : 7);
+      v[0] = (MYFLT) p->received;  v[1] = (MYFLT) p->recovered;
+      v[2] = (MYFLT) p->late;      v[3] = (MYFLT) p->concealed;
+      v[4] = (MYFLT) p->dropped;   v[5] = (MYFLT) p->underruns;
+      v[6] = (MYFLT) p->target;
+      memcpy(p->stats->ftable, v, n * sizeof(MYFLT));
+    }
+    if (gen == 0)                       /* nothing received yet */
+      return OK;
+    if (gen != p->mygen) {
+      /* a new stream: wait for the target latency again */
+      p->mygen = gen;
+      p->chans = p->rchans;
+      p->frames = p->rframes;
+      p->pseq = (uint32_t) ATOMIC_GET(p->hiseq) + 1;
+      p->pofs = p->frames;
+      p->playing = p->hasprev = p->concealing = p->stable = 0;
+      p->fadein = 1;
+      ATOMIC_SET(p->playseq, (long) p->pseq);
+      ATOMIC_SET(p->playgen, gen);
+    }
+    chans = p->chans;
+    if (UNLIKELY(early)) nsmps -= early;
+    for (i = offset; i < nsmps; i++) {
+      MYFLT *f;
+      if (p->pofs >= p->frames) {
+        stream_next_block(p);
+        p->pofs = 0;
+      }
+      f = p->cur + p->pofs++ * chans;
+      for (c = 0; c < nout && c < chans; c++)
+        p->aout[c][i] = f[c] * csound->e0dbfs;
+    }
+    return OK;
+}
+
+#define S(x)    sizeof(x)
+
+static OENTRY sockstream_localops[] = {
+  { "streamsend", S(STREAMSEND), 0, 3, "", "Siiy",
+    (SUBR) init_stream_send, (SUBR) perf_stream_send, NULL },
+  /* STREAM_MAXOUT 'm's */
+  { "streamrecv", S(STREAMRECV), 0, 3, "mmmmmmmmmmmmmmmmmmmmmmmm", "ioooo",
+    (SUBR) init_stream_recv, (SUBR) perf_stream_recv, NULL }
+};
+
+LINKAGE_BUILTIN(sockstream_localops)
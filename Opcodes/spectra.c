@@ -1277,9 +1277,9 @@ static OENTRY spectra_localops[] = {
                               (SUBR)trnsetr,(SUBR)trnsegr      },
 { "clip", S(CLIP),      0, 3,  "a", "aiiv", (SUBR)clip_set, (SUBR)clip  },
 { "cpuprc", S(CPU_PERC),0, 1,     "",     "Si",   (SUBR)cpuperc_S, NULL, NULL   },
-{ "maxalloc", S(CPU_PERC),0, 1,   "",     "Si",   (SUBR)maxalloc_S, NULL, NULL  },
+{ "maxalloc", S(CPU_PERC),0, 1,   "",     "Sioj", (SUBR)maxalloc_S, NULL, NULL  },
 { "cpuprc", S(CPU_PERC),0, 1,     "",     "ii",   (SUBR)cpuperc, NULL, NULL   },
-{ "maxalloc", S(CPU_PERC),0, 1,   "",     "ii",   (SUBR)maxalloc, NULL, NULL  },
+{ "maxalloc", S(CPU_PERC),0, 1,   "",     "iioj", (SUBR)maxalloc, NULL, NULL  },
 { "active", 0xffff                                                          },
 { "active.iS", S(INSTCNT),0,1,    "i",    "Soo",   (SUBR)instcount_S, NULL, NULL },
 { "active.kS", S(INSTCNT),0,2,    "k",    "Soo",   NULL, (SUBR)instcount_S, NULL },
@@ -83,6 +83,7 @@ int32_t stdopc_ModuleInit(CSOUND *csound)
     err |= sndwarp_init_(csound);
     err |= space_init_(csound);
     err |= spat3d_init_(csound);
+    err |= stems_init_(csound);
     err |= syncgrain_init_(csound);
     err |= ugens7_init_(csound);
     err |= ugens9_init_(csound);
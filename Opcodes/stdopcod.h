@@ -72,6 +72,8 @@ typedef struct STDOPCOD_GLOBALS_ {
     MYFLT       *tb[16];       /* gab: updated */
     int32_t         tb_ixmode[16]; /* gab: added */
     int32       tb_size[16];   /* gab: added */
+    /* stems.c */
+    struct STEMS_ *stems;
 } STDOPCOD_GLOBALS;
 
 extern int32_t ambicode_init_(CSOUND *);
@@ -108,6 +110,7 @@ extern int32_t sndloop_init_(CSOUND *);
 extern int32_t sndwarp_init_(CSOUND *);
 extern int32_t space_init_(CSOUND *);
 extern int32_t spat3d_init_(CSOUND *);
+extern int32_t stems_init_(CSOUND *);
 extern int32_t syncgrain_init_(CSOUND *);
 extern int32_t ugens7_init_(CSOUND *);
 extern int32_t ugens9_init_(CSOUND *);
@@ -0,0 +1,452 @@
+/*
+    stems.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Stem output: named buses, each written to a sound file of its own.
+
+   stemout Sname, asig1 [, asig2, ...] mixes its inputs into the bus
+   Sname, which is created, with as many channels, the first time it is
+   used.  At the start of every k-cycle the previous cycle of each bus
+   is scaled to 0dBFS = 1, interleaved into a lock-free ring, and
+   cleared; a pool of --stem-jobs encoder threads empties the rings into
+   the files, so the performance thread never waits for the disk or an
+   encoder.  A bus starts with the silence up to the time it was
+   created, so every stem lines up with the others and with the main
+   output.
+
+   The file name is the bus name, in SFDIR if it is relative.  Its
+   format is given by its extension if that is one of the codecs below,
+   otherwise by --stem-format (wav by default), whose extension is then
+   added. */
+
+#include <inttypes.h>
+#include "stdopcod.h"
+#include "soundio.h"
+#include "aops.h"
+
+typedef struct STEM_CODEC_ {
+    const char  *name;
+    const char  *ext;
+    int32_t     (*format)(CSOUND *);    /* libsndfile format */
+} STEM_CODEC;
+
+/* the sample format of -o, where the container can hold it */
+
+static int32_t wav_format(CSOUND *csound)
+{
+    int32_t fmt = csound->oparms->outformat;
+    if (fmt != AE_SHORT && fmt != AE_24INT && fmt != AE_LONG &&
+        fmt != AE_FLOAT && fmt != AE_DOUBLE)
+      fmt = AE_24INT;
+    return TYPE2SF(TYP_WAV) | FORMAT2SF(fmt);
+}
+
+static int32_t flac_format(CSOUND *csound)
+{
+    int32_t fmt = csound->oparms->outformat;
+    if (fmt != AE_CHAR && fmt != AE_SHORT)
+      fmt = AE_24INT;
+    return TYPE2SF(TYP_FLAC) | FORMAT2SF(fmt);
+}
+
+static int32_t float_format(CSOUND *csound)
+{
+    IGN(csound);
+    return TYPE2SF(TYP_RAW) | FORMAT2SF(AE_FLOAT);
+}
+
+static const STEM_CODEC stem_codecs[] = {
+    { "wav",    ".wav",     wav_format      },
+    { "flac",   ".flac",    flac_format     },
+    { "float",  ".f32",     float_format    },
+    { NULL,     NULL,       NULL            }
+};
+
+typedef struct STEM_ {
+    struct STEM_    *nxt;       /* all stems, used by the perf thread */
+    struct STEM_    *wnxt;      /* stems of the same encoder thread */
+    char            *name, *path;
+    SNDFILE         *sf;
+    int32_t         nchnls;
+    MYFLT           *bus;       /* nchnls * ksmps, one channel after
+                                   the other */
+    float           *ring;      /* interleaved frames */
+    uint32_t        size;       /* in samples, a power of two */
+    volatile uint32_t wp, rp;   /* free running sample counts */
+    int64_t         lead;       /* frames of silence before the ring */
+    int32_t         overflows;
+    int64_t         dropped;    /* sample frames */
+    int32_t         errors;
+} STEM;
+
+typedef struct STEMS_ STEMS;
+
+typedef struct STEM_WORKER_ {
+    STEMS           *g;
+    STEM            *stems;     /* changed under g->lock */
+    void            *thread;
+} STEM_WORKER;
+
+struct STEMS_ {
+    CSOUND          *csound;
+    STEM            *stems;
+    int32_t         nstems;
+    STEM_WORKER     *workers;
+    int32_t         nworkers;
+    void            *lock;
+    volatile int32_t quit;
+    const STEM_CODEC *codec;    /* for names without a known extension */
+    int32_t         wait;       /* wait for ring space instead of dropping */
+};
+
+typedef struct {
+    OPDS      h;
+    STRINGDAT *name;
+    MYFLT     *asig[VARGMAX-1];
+    STEM      *stem;
+} STEMOUT;
+
+/* writes what is waiting in a stem's ring; encoder thread only */
+
+static int32_t stem_encode(STEM *s)
+{
+    uint32_t  rp = s->rp, avail = ATOMIC_GET(s->wp) - rp;
+    int32_t   done = (avail > 0);
+
+    if (UNLIKELY(s->lead > 0)) {
+      float   zero[VARGMAX];      /* at least one frame of any stem */
+      memset(zero, 0, sizeof(zero));
+      while (s->lead > 0) {
+        int64_t n = VARGMAX / s->nchnls;
+        n = (n < s->lead ? n : s->lead);
+        if (sf_writef_float(s->sf, zero, (sf_count_t) n) != (sf_count_t) n)
+          s->errors++;
+        s->lead -= n;
+      }
+    }
+    while (avail > 0) {
+      uint32_t  ofs = rp & (s->size - 1);
+      uint32_t  n = s->size - ofs;
+      n = (n < avail ? n : avail);
+      if (UNLIKELY(sf_write_float(s->sf, s->ring + ofs, (sf_count_t) n)
+                   != (sf_count_t) n))
+        s->errors++;
+      rp += n;
+      avail -= n;
+      ATOMIC_SET(s->rp, rp);
+    }
+    return done;
+}
+
+static uintptr_t stem_thread(void *p)
+{
+    STEM_WORKER *w = (STEM_WORKER*) p;
+    STEMS       *g = w->g;
+    CSOUND      *csound = g->csound;
+    int32_t     wakeup = (int32_t) (1000 * csound->ksmps / csound->esr);
+
+    if (wakeup < 1)
+      wakeup = 1;
+    for (;;) {
+      STEM    *s;
+      int32_t done = 0, quit = ATOMIC_GET(g->quit);
+      /* stems are only ever added at the head of the list */
+      csound->LockMutex(g->lock);
+      s = w->stems;
+      csound->UnlockMutex(g->lock);
+      for ( ; s != NULL; s = s->wnxt)
+        done |= stem_encode(s);
+      if (quit)                 /* rings were emptied after the last block */
+        break;
+      if (!done)
+        csound->Sleep(wakeup);
+    }
+    return 0;
+}
+
+/* at the end of each k-cycle: queue the bus of every stem */
+
+static void stems_kcycle(CSOUND *csound, void *p)
+{
+    STEMS     *g = (STEMS*) p;
+    STEM      *s;
+    uint32_t  ksmps = csound->ksmps;
+    MYFLT     scale = csound->dbfs_to_float;
+
+    for (s = g->stems; s != NULL; s = s->nxt) {
+      uint32_t  n = ksmps * s->nchnls, wp = s->wp, ofs, i;
+      int32_t   c;
+      while (UNLIKELY(n > s->size - (wp - ATOMIC_GET(s->rp)))) {
+        if (!g->wait) {
+          s->overflows++;
+          s->dropped += ksmps;
+          goto next;
+        }
+        csound->Sleep(1);       /* offline: let the encoders catch up */
+      }
+      ofs = wp & (s->size - 1);
+      if (LIKELY(ofs + n <= s->size)) {
+        /* most blocks do not wrap around the end of the ring */
+        for (c = 0; c < s->nchnls; c++) {
+          const MYFLT *in = s->bus + c * ksmps;
+          float       *out = s->ring + ofs + c;
+          for (i = 0; i < ksmps; i++)
+            out[i * s->nchnls] = (float) (in[i] * scale);
+        }
+      }
+      else {
+        for (i = 0; i < ksmps; i++)
+          for (c = 0; c < s->nchnls; c++)
+            s->ring[(wp + i * s->nchnls + c) & (s->size - 1)] =
+              (float) (s->bus[c * ksmps + i] * scale);
+      }
+      ATOMIC_SET(s->wp, wp + n);
+    next:
+      memset(s->bus, 0, n * sizeof(MYFLT));
+    }
+}
+
+static STEMS *stems_start(CSOUND *csound)
+{
+    STDOPCOD_GLOBALS  *pp = (STDOPCOD_GLOBALS*) csound->stdOp_Env;
+    OPARMS    *O = csound->oparms;
+    STEMS     *g;
+    int32_t   i;
+
+    if (pp->stems != NULL)
+      return pp->stems;
+    g = (STEMS*) csound->Calloc(csound, sizeof(STEMS));
+    g->csound = csound;
+    g->codec = &stem_codecs[0];
+    if (O->stemFormat != NULL) {
+      for (i = 0; stem_codecs[i].name != NULL; i++)
+        if (strcmp(stem_codecs[i].name, O->stemFormat) == 0)
+          break;
+      if (stem_codecs[i].name != NULL)
+        g->codec = &stem_codecs[i];
+      else
+        csound->Warning(csound, Str("stemout: unknown stem format '%s', "
+                                    "using wav"), O->stemFormat);
+    }
+    /* offline renders lose nothing: the k-cycle waits for the encoders */
+    g->wait = !O->realtime;
+    g->nworkers = (O->stemJobs > 0 ? O->stemJobs : 2);
+    g->workers = (STEM_WORKER*) csound->Calloc(csound, g->nworkers
+                                                       * sizeof(STEM_WORKER));
+    g->lock = csound->Create_Mutex(0);
+    for (i = 0; i < g->nworkers; i++) {
+      g->workers[i].g = g;
+      g->workers[i].thread = csound->CreateThread(stem_thread,
+                                                  (void*) &g->workers[i]);
+    }
+    csound->kcycleEndData = (void*) g;
+    csound->kcycleEndFunc = stems_kcycle;
+    pp->stems = g;
+    return g;
+}
+
+static STEM *stem_open(CSOUND *csound, STEMS *g, const char *name,
+                       int32_t nchnls)
+{
+    const STEM_CODEC *codec = g->codec;
+    STEM      *s;
+    SF_INFO   sfinfo;
+    char      *fname, *path;
+    size_t    len = strlen(name);
+    int64_t   frames = csound->oparms->writeBuffer;
+    int32_t   i;
+    uint32_t  size = 1024;
+
+    for (i = 0; stem_codecs[i].name != NULL; i++) {
+      size_t  l = strlen(stem_codecs[i].ext);
+      if (len > l && strcmp(name + len - l, stem_codecs[i].ext) == 0)
+        break;
+    }
+    if (stem_codecs[i].name != NULL) {
+      codec = &stem_codecs[i];
+      fname = cs_strdup(csound, (char*) name);
+    }
+    else {
+      fname = (char*) csound->Malloc(csound, len + strlen(codec->ext) + 1);
+      strcpy(fname, name);
+      strcat(fname, codec->ext);
+    }
+    path = csound->FindOutputFile(csound, fname, "SFDIR");
+    csound->Free(csound, fname);
+    if (UNLIKELY(path == NULL))
+      return NULL;
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    sfinfo.samplerate = (int32_t) MYFLT2LRND(csound->esr);
+    sfinfo.channels = nchnls;
+    sfinfo.format = codec->format(csound);
+    s = (STEM*) csound->Calloc(csound, sizeof(STEM));
+    if (UNLIKELY((s->sf = sf_open(path, SFM_WRITE, &sfinfo)) == NULL)) {
+      csound->Free(csound, path);
+      csound->Free(csound, s);
+      return NULL;
+    }
+    if (SF2FORMAT(sfinfo.format) != AE_FLOAT)
+      sf_command(s->sf, SFC_SET_CLIPPING, NULL, SF_TRUE);
+    csound->NotifyFileOpened(csound, path,
+                             csound->sftype2csfiletype(sfinfo.format), 1, 0);
+    s->name = cs_strdup(csound, (char*) name);
+    s->path = path;
+    s->nchnls = nchnls;
+    s->bus = (MYFLT*) csound->Calloc(csound, nchnls * csound->ksmps
+                                             * sizeof(MYFLT));
+    if (frames <= 0)
+      frames = (int64_t) csound->esr;
+    while ((int64_t) size < frames * nchnls && size < 0x40000000U)
+      size <<= 1;
+    s->ring = (float*) csound->Malloc(csound, size * sizeof(float));
+    s->size = size;
+    s->lead = csound->icurTime;
+    /* hand it to an encoder thread, round robin */
+    {
+      STEM_WORKER *w = &g->workers[g->nstems % g->nworkers];
+      csound->LockMutex(g->lock);
+      s->wnxt = w->stems;
+      w->stems = s;
+      csound->UnlockMutex(g->lock);
+    }
+    s->nxt = g->stems;
+    g->stems = s;
+    g->nstems++;
+    return s;
+}
+
+/* Called by csoundCleanup(): lets the encoders finish and closes the
+   files. */
+
+void stems_close(CSOUND *csound)
+{
+    STDOPCOD_GLOBALS  *pp = (STDOPCOD_GLOBALS*) csound->stdOp_Env;
+    STEMS     *g;
+    STEM      *s;
+    int32_t   i;
+
+    if (pp == NULL || (g = pp->stems) == NULL)
+      return;
+    pp->stems = NULL;
+    csound->kcycleEndFunc = NULL;
+    csound->kcycleEndData = NULL;
+    ATOMIC_SET(g->quit, 1);
+    for (i = 0; i < g->nworkers; i++)
+      if (g->workers[i].thread != NULL)
+        csound->JoinThread(g->workers[i].thread);
+    while ((s = g->stems) != NULL) {
+      g->stems = s->nxt;
+      if (s->wp != s->rp || s->lead > 0)     /* no encoder thread */
+        stem_encode(s);
+      if (UNLIKELY(s->overflows))
+        csound->Warning(csound, Str("stemout: %s: %" PRId64 " sample frames "
+                                    "dropped (try a larger --write-buffer "
+                                    "or more --stem-jobs)"),
+                        s->name, s->dropped);
+      if (UNLIKELY(s->errors))
+        csound->Warning(csound, Str("stemout: %s: %d writes failed"),
+                        s->name, s->errors);
+      sf_close(s->sf);
+      csound->Message(csound, Str("stemout: wrote %s\n"), s->path);
+      csound->Free(csound, s->ring);
+      csound->Free(csound, s->bus);
+      csound->Free(csound, s->path);
+      csound->Free(csound, s->name);
+      csound->Free(csound, s);
+    }
+    csound->DestroyMutex(g->lock);
+    csound->Free(csound, g->workers);
+    csound->Free(csound, g);
+}
+
+static int32_t stemout_init(CSOUND *csound, STEMOUT *p)
+{
+    STEMS     *g;
+    STEM      *s;
+    int32_t   nchnls = (int32_t) p->INOCOUNT - 1;
+
+    if (UNLIKELY(p->name->data == NULL || p->name->data[0] == '\0'))
+      return csound->InitError(csound, Str("stemout: empty stem name"));
+    g = stems_start(csound);
+    for (s = g->stems; s != NULL; s = s->nxt)
+      if (strcmp(s->name, p->name->data) == 0)
+        break;
+    if (s == NULL) {
+      if (UNLIKELY((s = stem_open(csound, g, p->name->data, nchnls)) == NULL))
+        return csound->InitError(csound, Str("stemout: cannot open stem "
+                                             "'%s'"), p->name->data);
+    }
+    else if (UNLIKELY(s->nchnls != nchnls))
+      return csound->InitError(csound, Str("stemout: stem '%s' has %d "
+                                           "channels, not %d"),
+                               p->name->data, s->nchnls, nchnls);
+    p->stem = s;
+    return OK;
+}
+
+/* Where this cycle starts in the bus: under a local ksmps an instance
+   runs several cycles per k-cycle, moving its spout on by nchnls
+   samples per frame each time (see kperf). */
+
+static uint32_t stem_subcycle(CSOUND *csound, INSDS *ip)
+{
+    int64_t   d = (int64_t) (ip->spout - csound->spraw);
+
+    if (ip->ksmps == csound->ksmps || d < 0 || d >= (int64_t) csound->nspout)
+      return 0;
+    return (uint32_t) (d / csound->nchnls);
+}
+
+static int32_t stemout_perf(CSOUND *csound, STEMOUT *p)
+{
+    STEM      *s = p->stem;
+    uint32_t  offset = p->h.insdshead->ksmps_offset;
+    uint32_t  early  = p->h.insdshead->ksmps_no_end;
+    uint32_t  n, nsmps = CS_KSMPS;
+    uint32_t  sub = stem_subcycle(csound, p->h.insdshead);
+    int32_t   c;
+
+    if (UNLIKELY(early)) nsmps -= early;
+    if (UNLIKELY(sub + nsmps > csound->ksmps))
+      nsmps = csound->ksmps - sub;
+    /* other threads may be mixing into the same stem */
+    CSOUND_SPOUT_SPINLOCK
+    for (c = 0; c < s->nchnls; c++) {
+      MYFLT   *bus = s->bus + c * csound->ksmps + sub;
+      MYFLT   *in = p->asig[c];
+      for (n = offset; n < nsmps; n++)
+        bus[n] += in[n];
+    }
+    CSOUND_SPOUT_SPINUNLOCK
+    return OK;
+}
+
+#define S(x)    sizeof(x)
+
+static OENTRY localops[] = {
+    { "stemout",    S(STEMOUT),     _CB, 3,  "",     "Sy",
+        (SUBR) stemout_init,    (SUBR) stemout_perf,    NULL }
+};
+
+int32_t stems_init_(CSOUND *csound)
+{
+    return csound->AppendOpcodes(csound, &(localops[0]),
+                                 (int32_t) (sizeof(localops) / sizeof(OENTRY)));
+}
@@ -186,7 +186,8 @@ static const char *shortUsageList[] = {
 
 static const char *longUsageList[] = {
   "--format={wav,aiff,au,raw,paf,svx,nist,voc,ircam,w64,mat4,mat5",
-  "          pvf,xi,htk,sds,avr,wavex,sd2,flac,caf,wve,ogg,mpc2k,rf64}",
+  "          pvf,xi,htk,sds,avr,wavex,sd2,flac,caf,wve,ogg,mpc2k,rf64,",
+  "          capture}",
   "--format={alaw,ulaw,schar,uchar,float,double,short,long,24bit,vorbis}",
   Str_noop("  Set output file format"),
   Str_noop("--aiff                  set AIFF format"),
@@ -314,6 +315,20 @@ static const char *longUsageList[] = {
   Str_noop("--udp-echo              echo UDP commands on terminal"),
   Str_noop("--aft-zero              set aftertouch to zero, not 127 (default)"),
   Str_noop("--limiter[=num]         include clipping in audio output"),
+  Str_noop("--instr-guard           turn off instances that output NaN/Inf"),
+  Str_noop("--render-jobs=N         render score sections to file on N "
+           "threads"),
+  Str_noop("--render-warmup=SECS    time performed before each section "
+           "(default 1)"),
+  Str_noop("--write-buffer=N        sample frames queued for sound files "
+           "written in the background (default: one second)"),
+  Str_noop("--look-ahead=N          render N host buffers ahead in "
+           "csoundPerformBuffer(); control channels and MIDI input "
+           "are then up to N buffers late"),
+  Str_noop("--stem-jobs=N           encoder threads for stemout "
+           "(default 2)"),
+  Str_noop("--stem-format=FMT       stemout file format: wav, flac or "
+           "float (default wav)"),
   " ",
   Str_noop("--help                  long help"),
   NULL
@@ -496,6 +511,7 @@ static const SOUNDFILE_TYPE_ENTRY file_type_map[] = {
     { "flac",   TYP_FLAC  },  { "caf",    TYP_CAF   },
     { "wve",    TYP_WVE   },  { "ogg",    TYP_OGG   },
     { "mpc2k",  TYP_MPC2K },  { "rf64",   TYP_RF64  },
+    { "capture", TYP_CAPTURE },
     { NULL , -1 }
 };
 
@@ -1243,6 +1259,42 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->limiter = 0.5;
       return 1;
     }
+    else if (!(strcmp(s, "instr-guard"))) {
+      O->instrGuard = 1;
+      return 1;
+    }
+    else if (!(strncmp(s, "render-jobs=", 12))) {
+      s += 12;
+      O->renderJobs = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp(s, "render-warmup=", 14))) {
+      s += 14;
+      O->renderWarmup = atof(s);
+      if (O->renderWarmup < 0.0)
+        O->renderWarmup = 0.0;
+      return 1;
+    }
+    else if (!(strncmp(s, "write-buffer=", 13))) {
+      s += 13;
+      O->writeBuffer = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp(s, "look-ahead=", 11))) {
+      s += 11;
+      O->lookAhead = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp(s, "stem-jobs=", 10))) {
+      s += 10;
+      O->stemJobs = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp(s, "stem-format=", 12))) {
+      s += 12;
+      O->stemFormat = cs_strdup(csound, s);
+      return 1;
+    }
     csoundErrorMsg(csound, Str("unknown long option: '--%s'"), s);
     return 0;
 }
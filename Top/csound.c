@@ -85,6 +85,10 @@ static int  defaultCsoundYield(CSOUND *);
 static int  csoundDoCallback_(CSOUND *, void *, unsigned int);
 static void reset(CSOUND *);
 static int  csoundPerformKsmpsInternal(CSOUND *csound);
+static void csoundSetPerformDriver(CSOUND *,
+                                   void (*)(CSOUND *, void *, int), void *);
+static int  csoundPerformDriven(CSOUND *, int);
+static int  perform_driven(CSOUND *);
 void csoundTableSetInternal(CSOUND *csound, int table, int index,
                                    MYFLT value);
 static INSTRTXT **csoundGetInstrumentList(CSOUND *csound);
@@ -517,8 +521,17 @@ static const CSOUND cenviron_ = {
     csoundLPCeps,
     csoundCepsLP,
     csoundLPrms,
+    csoundPushMidiMessage,
+    csoundSetPerformDriver,
+    csoundPerformDriven,
+    csoundGetSampleConverters,
+    csoundStreamOpen,
+    csoundStreamRead,
+    csoundStreamClose,
+    csoundFileCaptureWrite,
+    csoundFileCaptureMarker,
+    csoundCaptureInfo,
     {
-      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL
     },
@@ -718,6 +731,10 @@ static const CSOUND cenviron_ = {
     FL(0.0),
     NULL,
     NULL,
+    0,              /*  offkcnt */
+    NULL,           /*  prvoff */
+    0, 0, 0, 0,     /*  voiceno, stealcyc, stealkcnt, mskcnt */
+    FL(0.0), FL(0.0), /*  outms, outacc */
     {NULL, FL(0.0)},
    {NULL, FL(0.0)},
    {NULL, FL(0.0)},
@@ -828,7 +845,13 @@ static const CSOUND cenviron_ = {
       0,0,          /*  pipdevin, pipdevout */
       1U,           /*  nframes             */
       NULL, NULL,   /*  pin, pout           */
-      0,            /*dither                */
+      {{0}, 0},     /*  dither              */
+      NULL,         /*  conv                */
+      0,            /*  outconv             */
+      NULL, 0,      /*  convbuf, convbufsmps */
+      NULL,         /*  outwr               */
+      NULL, NULL,   /*  hostinbuf, hostoutbuf */
+      NULL          /*  capture             */
     },
     0,              /*  warped              */
     0,              /*  sstrlen             */
@@ -925,7 +948,14 @@ static const CSOUND cenviron_ = {
       0,             /*    fft_lib */
       0,             /* echo */
       0.0,           /* limiter */
-      DFLT_SR, DFLT_KR  /* defaults */
+      DFLT_SR, DFLT_KR,  /* defaults */
+      0,             /* instrGuard */
+      0,             /* renderJobs */
+      1.0,           /* renderWarmup */
+      0,             /* writeBuffer */
+      0,             /* stemJobs */
+      NULL,          /* stemFormat */
+      0              /* lookAhead */
     },
     {0, 0, {0}}, /* REMOT_BUF */
     NULL,           /* remoteGlobals        */
@@ -1318,7 +1348,7 @@ PUBLIC CSOUND *csoundCreate(void *hostdata)
 {
     CSOUND        *csound;
     csInstance_t  *p;
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    CS_SET_FTZ_MODE();
 
     if (init_done != 1) {
       if (csoundInitialize(0) < 0) return NULL;
@@ -1427,6 +1457,15 @@ PUBLIC void csoundDestroy(CSOUND *csound)
     free((void*) csound);
 }
 
+PUBLIC int csoundSetTemplate(CSOUND *csound, CSOUND *tmpl)
+{
+    if (tmpl == csound ||
+        (csound->ftTemplate != NULL && csound->ftTemplate != tmpl))
+      return CSOUND_ERROR;
+    csound->ftTemplate = tmpl;
+    return CSOUND_SUCCESS;
+}
+
 PUBLIC int csoundGetVersion(void)
 {
     return (int) (CS_VERSION * 1000 + CS_SUBVER * 10 + CS_PATCHLEVEL);
@@ -1554,18 +1593,29 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
         done = insds->init_done;
 #endif
         if (done) {
+          int pending = insds->ksmps_offset | insds->ksmps_no_end;
           opstart = (OPDS*)task_map[which_task];
           if (insds->ksmps == csound->ksmps) {
             insds->spin = csound->spin;
             insds->spout = csound->spraw;
             insds->kcounter =  csound->kcounter;
             csound->mode = 2;
-            while ((opstart = opstart->nxtp) != NULL) {
-              /* In case of jumping need this repeat of opstart */
-              opstart->insdshead->pds = opstart;
-              csound->op = opstart->optext->t.opcod;
-              (*opstart->opadr)(csound, opstart); /* run each opcode */
-              opstart = opstart->insdshead->pds;
+            if (LIKELY(!pending)) {   /* the one offset test per instance */
+              while ((opstart = opstart->nxtp) != NULL) {
+                /* In case of jumping need this repeat of opstart */
+                opstart->insdshead->pds = opstart;
+                csound->op = opstart->optext->t.opcod;
+                (*opstart->opadr)(csound, opstart); /* run each opcode */
+                opstart = opstart->insdshead->pds;
+              }
+            }
+            else {
+              while ((opstart = opstart->nxtp) != NULL) {
+                opstart->insdshead->pds = opstart;
+                csound->op = opstart->optext->t.opcod;
+                (*CS_GENERIC_PERF(opstart))(csound, opstart);
+                opstart = opstart->insdshead->pds;
+              }
             }
             csound->mode = 0;
           } else {
@@ -1599,15 +1649,17 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
               while ((opstart = opstart->nxtp) != NULL) {
                 opstart->insdshead->pds = opstart;
                 csound->op = opstart->optext->t.opcod;
-                (*opstart->opadr)(csound, opstart); /* run each opcode */
+                (*CS_GENERIC_PERF(opstart))(csound, opstart);
                 opstart = opstart->insdshead->pds;
               }
               csound->mode = 0;
               insds->kcounter++;
             }
           }
-          insds->ksmps_offset = 0; /* reset sample-accuracy offset */
-          insds->ksmps_no_end = 0;  /* reset end of loop samples */
+          if (UNLIKELY(pending)) {
+            insds->ksmps_offset = 0; /* reset sample-accuracy offset */
+            insds->ksmps_no_end = 0;  /* reset end of loop samples */
+          }
           played_count++;
         }
         //printf("******** finished task %d\n", which_task);
@@ -1656,7 +1708,7 @@ unsigned long kperfThread(void * cs)
     void *threadId;
     int index;
     int numThreads;
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    CS_SET_FTZ_MODE();
 
     csound->WaitBarrier(csound->barrier2);
 
@@ -1697,10 +1749,62 @@ unsigned long kperfThread(void * cs)
     }
 }
 
+/* Instance guard (--instr-guard): after the k-cycle, on whichever
+   perf path ran it, check the a- and k-rate variables of each active
+   instance, i.e. what it has just computed.  An instance holding NaN
+   or Inf has blown up: it is turned off, so that its opcodes are
+   initialised afresh if the instance is used again, and its bad values
+   are cleared.  The mix itself is then cleaned once: non-finite
+   samples are removed and subnormal ones flushed to zero. */
+static int guard_vars(INSDS *ip)
+{
+    CS_VARIABLE *var = ip->instr->varPool->head;
+    int         bad = 0;
+
+    for ( ; var != NULL; var = var->next) {
+      MYFLT     *val;
+      uint32_t  i, n;
+      if (var->varType != &CS_VAR_TYPE_A && var->varType != &CS_VAR_TYPE_K)
+        continue;
+      val = ip->lclbas + var->memBlockIndex;
+      n = (uint32_t) (var->memBlockSize / sizeof(MYFLT));
+      for (i = 0; i < n; i++)
+        if (UNLIKELY(!isfinite(val[i]))) {
+          val[i] = FL(0.0);
+          bad = 1;
+        }
+    }
+    return bad;
+}
+
+static void instr_guard(CSOUND *csound)
+{
+    INSDS    *ip = csound->actanchor.nxtact;
+    MYFLT    *out = csound->spraw;
+    uint32_t i, n = csound->nspout;
+
+    while (ip != NULL) {
+      INSDS *nxt = ip->nxtact;
+      if (ATOMIC_GET(ip->init_done) == 1 && ip->lclbas != NULL &&
+          UNLIKELY(guard_vars(ip))) {
+        csound->Warning(csound, Str("instr %d produced NaN/Inf: "
+                                    "instance turned off\n"), ip->insno);
+        xturnoff_now(csound, ip);
+      }
+      ip = nxt;
+    }
+    for (i = 0; i < n; i++) {
+      MYFLT x = out[i];
+      if (UNLIKELY(!isnormal(x) && x != FL(0.0)))
+        out[i] = FL(0.0);
+    }
+}
+
 int kperf_nodebug(CSOUND *csound)
 {
     INSDS *ip;
     int lksmps = csound->ksmps;
+    CS_SET_FTZ_MODE();
     /* update orchestra time */
     csound->kcounter = ++(csound->global_kcounter);
     csound->icurTime += csound->ksmps;
@@ -1774,13 +1878,27 @@ int kperf_nodebug(CSOUND *csound)
             ip->kcounter =  csound->kcounter;
             if (ip->ksmps == csound->ksmps) {
               csound->mode = 2;
-              while (error == 0 &&
-                     (opstart = opstart->nxtp) != NULL &&
-                     ip->actflg) {
-                opstart->insdshead->pds = opstart;
-                csound->op = opstart->optext->t.opcod;
-                error = (*opstart->opadr)(csound, opstart); /* run each opcode */
-                opstart = opstart->insdshead->pds;
+              /* the one offset test per instance: offsets are only set
+                 on its first and last cycles */
+              if (LIKELY(!(ip->ksmps_offset | ip->ksmps_no_end))) {
+                while (error == 0 &&
+                       (opstart = opstart->nxtp) != NULL &&
+                       ip->actflg) {
+                  opstart->insdshead->pds = opstart;
+                  csound->op = opstart->optext->t.opcod;
+                  error = (*opstart->opadr)(csound, opstart); /* run each opcode */
+                  opstart = opstart->insdshead->pds;
+                }
+              }
+              else {
+                while (error == 0 &&
+                       (opstart = opstart->nxtp) != NULL &&
+                       ip->actflg) {
+                  opstart->insdshead->pds = opstart;
+                  csound->op = opstart->optext->t.opcod;
+                  error = (*CS_GENERIC_PERF(opstart))(csound, opstart);
+                  opstart = opstart->insdshead->pds;
+                }
               }
               csound->mode = 0;
             } else {
@@ -1818,7 +1936,7 @@ int kperf_nodebug(CSOUND *csound)
                     opstart->insdshead->pds = opstart;
                     csound->op = opstart->optext->t.opcod;
                     //csound->ids->optext->t.oentry->opname;
-                    error = (*opstart->opadr)(csound, opstart); /* run each opcode */
+                    error = (*CS_GENERIC_PERF(opstart))(csound, opstart);
                     opstart = opstart->insdshead->pds;
                     
                   }
@@ -1829,8 +1947,10 @@ int kperf_nodebug(CSOUND *csound)
           }
           /*else csound->Message(csound, "time %f\n",
                                  csound->kcounter/csound->ekr);*/
-          ip->ksmps_offset = 0; /* reset sample-accuracy offset */
-          ip->ksmps_no_end = 0; /* reset end of loop samples */
+          if (UNLIKELY(ip->ksmps_offset | ip->ksmps_no_end)) {
+            ip->ksmps_offset = 0; /* reset sample-accuracy offset */
+            ip->ksmps_no_end = 0; /* reset end of loop samples */
+          }
           if(nxt == NULL)
              ip = ip->nxtact;
           /* VL 13.04.21 this allows for deletions to operate 
@@ -1846,11 +1966,15 @@ int kperf_nodebug(CSOUND *csound)
       }
     }
 
+    if (UNLIKELY(csound->oparms->instrGuard))
+      instr_guard(csound);
     if (!csound->spoutactive) { /* results now in spout? */
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
     make_interleave(csound, lksmps);
+    if (csound->kcycleEndFunc != NULL)
+      csound->kcycleEndFunc(csound, csound->kcycleEndData);
     csound->spoutran(csound); /* send to audio_out */
     //#ifdef ANDROID
     //struct timespec ts;
@@ -1898,7 +2022,7 @@ static inline void opcode_perf_debug(CSOUND *csound,
         }
       opstart->insdshead->pds = opstart;
       csound->mode = 2;
-      (*opstart->opadr)(csound, opstart); /* run each opcode */
+      (*CS_GENERIC_PERF(opstart))(csound, opstart); /* run each opcode */
       opstart = opstart->insdshead->pds;
       csound->mode = 0;
     }
@@ -1948,6 +2072,7 @@ int kperf_debug(CSOUND *csound)
     INSDS *ip;
     csdebug_data_t *data = (csdebug_data_t *) csound->csdebug_data;
     int lksmps = csound->ksmps;
+    CS_SET_FTZ_MODE();
     /* call message_dequeue to run API calls */
     message_dequeue(csound);
 
@@ -2113,8 +2238,10 @@ int kperf_debug(CSOUND *csound)
                 }
             }
           }
-          ip->ksmps_offset = 0; /* reset sample-accuracy offset */
-          ip->ksmps_no_end = 0;  /* reset end of loop samples */
+          if (UNLIKELY(ip->ksmps_offset | ip->ksmps_no_end)) {
+            ip->ksmps_offset = 0; /* reset sample-accuracy offset */
+            ip->ksmps_no_end = 0;  /* reset end of loop samples */
+          }
           ip = ip->nxtact; /* but this does not allow for all deletions */
           if (/*data &&*/ data->status == CSDEBUG_STATUS_NEXT) {
             data->debug_instr_ptr = ip; /* we have reached the next
@@ -2132,12 +2259,16 @@ int kperf_debug(CSOUND *csound)
 
     if (!data || data->status != CSDEBUG_STATUS_STOPPED)
     {
+    if (UNLIKELY(csound->oparms->instrGuard))
+      instr_guard(csound);
     if (!csound->spoutactive) {             /*   results now in spout? */
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
     else
       make_interleave(csound, lksmps);
+    if (csound->kcycleEndFunc != NULL)
+      csound->kcycleEndFunc(csound, csound->kcycleEndData);
     csound->spoutran(csound);               /*      send to audio_out  */
     }
     return 0;
@@ -2195,6 +2326,10 @@ PUBLIC int csoundPerformKsmps(CSOUND *csound)
       if (UNLIKELY((returnValue = setjmp(csound->exitjmp))))
         return ((returnValue - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
     }
+    /* the audio driver performs: this does not return before the end of
+       the whole score (see csound.h) */
+    if (UNLIKELY(csound->performDriver != NULL))
+      return perform_driven(csound);
     if(!csound->oparms->realtime) // no API lock in realtime mode
       csoundLockMutex(csound->API_lock);
     do {
@@ -2242,6 +2377,81 @@ static int csoundPerformKsmpsInternal(CSOUND *csound)
     return 0;
 }
 
+/* Performance driven by an audio driver's own thread (e.g. the JACK
+   process callback): the driver registers itself while opening, and
+   csoundPerform() (or the first csoundPerformKsmps()) then only starts it
+   with run = 1 and waits; the driver calls PerformDriven() for each
+   k-cycle, or with abort set if it cannot go on (e.g. the server quit).
+   run = 0 tells the driver to stop calling it. */
+
+static void csoundSetPerformDriver(CSOUND *csound,
+                                   void (*driver)(CSOUND *, void *, int),
+                                   void *userData)
+{
+    csound->performDriver = driver;
+    csound->performDriverData = userData;
+}
+
+static int csoundPerformDriven(CSOUND *csound, int abort)
+{
+    volatile int  done = 0;
+    int           returnValue;
+
+    if (UNLIKELY(csound->driverDone))
+      return 1;
+    if (UNLIKELY(abort))
+      done = CSOUND_ERROR;
+    else {
+      /* same locking as csoundPerformKsmps(), and the exit jump must
+         return to this (the driver's) thread */
+      if (!csound->oparms->realtime)
+        csoundLockMutex(csound->API_lock);
+      if (UNLIKELY((returnValue = setjmp(csound->exitjmp)))) {
+        /* csoundDie() or an exit during the k-cycle */
+        done = (returnValue == CSOUND_EXITJMP_SUCCESS ?
+                1 : CSOUND_ERROR);
+      }
+      else {
+        do {
+          if (UNLIKELY((done = sensevents(csound))))
+            break;
+        } while (csound->kperf(csound));
+      }
+      if (!csound->oparms->realtime)
+        csoundUnlockMutex(csound->API_lock);
+    }
+    if (UNLIKELY(done || csound->performState)) {
+      csound->driverRetval = done;            /* 0 if csoundStop() */
+      csound->driverDone = 1;
+      csoundNotifyThreadLock(csound->driverLock);
+      return 1;
+    }
+    return 0;
+}
+
+static int perform_driven(CSOUND *csound)
+{
+    if (csound->driverLock == NULL &&
+        (csound->driverLock = csoundCreateThreadLock()) == NULL)
+      return CSOUND_MEMORY;
+    csoundWaitThreadLock(csound->driverLock, 0);    /* make sure it is taken */
+    csound->performState = 0;
+    csound->driverDone = 0;
+    csound->driverRetval = 0;
+    csound->performDriver(csound, csound->performDriverData, 1);
+    while (!csound->driverDone)
+      csoundWaitThreadLockNoTimeout(csound->driverLock);
+    csound->performDriver(csound, csound->performDriverData, 0);
+    csound->performState = 0;
+    if (csound->driverRetval < 0)
+      csoundErrorMsg(csound, Str("csoundPerform(): audio driver failed\n"));
+    else if (csound->driverRetval)
+      csoundMessage(csound, Str("Score finished in csoundPerform().\n"));
+    else
+      csoundMessage(csound, Str("csoundPerform(): stopped.\n"));
+    return csound->driverRetval;
+}
+
 /* external host's outbuffer passed in csoundPerformBuffer() */
 PUBLIC int csoundPerformBuffer(CSOUND *csound)
 {
@@ -2254,6 +2464,10 @@ PUBLIC int csoundPerformBuffer(CSOUND *csound)
                           "has not been called\n"));
       return CSOUND_ERROR;
     }
+    /* --look-ahead: the buffer was rendered by another thread */
+    if (csound->lookAhead != NULL ||
+        (csound->oparms->lookAhead > 0 && csoundLookAheadStart(csound)))
+      return csoundLookAheadBuffer(csound);
     /* Setup jmp for return after an exit(). */
     if (UNLIKELY((returnValue = setjmp(csound->exitjmp)))) {
 #ifndef MACOSX
@@ -2304,6 +2518,11 @@ PUBLIC int csoundPerform(CSOUND *csound)
 #endif
       return ((returnValue - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
     }
+    if (csound->oparms->renderJobs > 1 &&
+        (returnValue = csoundRenderParallel(csound)) != 0)
+      return returnValue;
+    if (csound->performDriver != NULL)
+      return perform_driven(csound);
     do {
         if(!csound->oparms->realtime)
            csoundLockMutex(csound->API_lock);
@@ -2713,6 +2932,8 @@ void csoundLongJmp(CSOUND *csound, int retval)
     csound->perferrcnt += csound->inerrcnt;
     csound->inerrcnt = 0;
     csound->engineStatus |= CS_STATE_JMP;
+    if (UNLIKELY(csound->lookAhead != NULL))
+      csoundLookAheadLongJmp(csound, n);
     //printf("**** longjmp with %d\n", n);
     longjmp(csound->exitjmp, n);
 }
@@ -2767,6 +2988,80 @@ int csoundScoreEventInternal(CSOUND *csound, char type,
     return ret;
 }
 
+/* Bytes needed for the string block of an event whose p-fields
+   strfields[i] (where not NULL) are strings. */
+
+static size_t score_event_strsize(const char *const *strfields,
+                                  long numFields)
+{
+    size_t  n = 0;
+    long    i;
+    if (strfields != NULL)
+      for (i = 0; i < numFields; i++)
+        if (strfields[i] != NULL)
+          n += strlen(strfields[i]) + 1;
+    return n + 1;           /* insert_score_event() copies a final NUL */
+}
+
+/* Fill evt as a line event would be: each string p-field is coded as
+   SSTRCOD plus its index, and its text appended to strbuf, which must
+   hold score_event_strsize() bytes. */
+
+static void score_event_fill(EVTBLK *evt, char type, const MYFLT *pfields,
+                             const char *const *strfields, long numFields,
+                             char *strbuf)
+{
+    char    *s = strbuf;
+    long    i;
+
+    evt->strarg = NULL; evt->scnt = 0;
+    evt->pinstance = NULL;
+    evt->opcod = type;
+    evt->pcnt = (int16) numFields;
+    for (i = 0; i < numFields; i++) {
+      if (strfields != NULL && strfields[i] != NULL) {
+        union {
+          MYFLT d;
+          int32 i;
+        } ch;
+        size_t  n = strlen(strfields[i]) + 1;
+        ch.d = SSTRCOD; ch.i += evt->scnt++;
+        evt->p[i + 1] = ch.d;
+        memcpy(s, strfields[i], n);
+        s += n;
+      }
+      else
+        evt->p[i + 1] = pfields[i];
+    }
+    *s = '\0';
+    if (evt->scnt > 0)
+      evt->strarg = strbuf;
+}
+
+int csoundScoreEventStringsInternal(CSOUND *csound, char type,
+                                    const MYFLT *pfields,
+                                    const char *const *strfields,
+                                    long numFields)
+{
+    EVTBLK  evt;
+    char    buf[256], *strbuf = buf;
+    size_t  n;
+    int     ret;
+
+    if (UNLIKELY(numFields < 0 || numFields > PMAX))
+      return CSOUND_ERROR;
+    n = score_event_strsize(strfields, numFields);
+    if (n > sizeof(buf))
+      strbuf = (char*) csound->Malloc(csound, n);
+    memset(&evt, 0, sizeof(EVTBLK));
+    score_event_fill(&evt, type, pfields, strfields, numFields, strbuf);
+    /* straight into the event queue: no text formatting or parsing */
+    ret = insert_score_event_at_sample(csound, &evt, csound->icurTime);
+    if (strbuf != buf)
+      csound->Free(csound, strbuf);
+    return ret;
+}
+
 int csoundScoreEventAbsoluteInternal(CSOUND *csound, char type,
                                     const MYFLT *pfields, long numFields,
                                     double time_ofs)
@@ -3324,6 +3619,8 @@ static void reset(CSOUND *csound)
        csound->Free(csound,csound->filedir[n++]);
 
      memRESET(csound);
+     if (csound->driverLock != NULL)
+       csoundDestroyThreadLock(csound->driverLock);
 
     /**
      * Copy everything EXCEPT the function pointers.
@@ -0,0 +1,299 @@
+/*
+    lookahead.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Look-ahead performance (--look-ahead=N).
+
+   With host implemented audio I/O, csoundPerformBuffer() normally does
+   all of its work in the host's audio callback.  With look-ahead a
+   thread renders up to N buffers ahead of the host instead, and
+   csoundPerformBuffer() only hands over the next one, so a buffer that
+   is expensive to compute does not have to be finished before its
+   deadline.
+
+   Score events, line events and kill requests sent through the API are
+   counted (lookAheadGen) when they are sent; each rendered buffer is
+   tagged with the count at the time it was started, when the engine
+   takes all the events sent so far.  Buffers started before the latest
+   event are dropped, and the first buffer that has it is crossfaded in from
+   the first one dropped, so an event is heard after one buffer instead
+   of N, at the cost of skipping the score material that was dropped.
+   Audio input reaches the engine up to N buffers late.
+
+   Control channel writes and MIDI input are not counted: they are read
+   by the engine when a buffer is rendered, and so reach the output up
+   to N buffers late.  Counting them would drop the look-ahead on every
+   controller move. */
+
+#include "csoundCore.h"
+#include "prototyp.h"
+
+extern int sensevents(CSOUND *);
+
+typedef struct {
+    MYFLT     *buf;
+    long      gen;              /* API events seen when it was finished */
+    int       status;           /* what csoundPerformBuffer() returns   */
+} LA_SLOT;
+
+typedef struct {
+    CSOUND    *csound;
+    LA_SLOT   *slot;
+    int       nslots;
+    int       rp, wp;           /* slots read and written               */
+    int       quit, done, status;
+    long      playgen;
+    int       fade;             /* crossfade from 'xfade'               */
+    MYFLT     *xfade;
+    MYFLT     *in;              /* the host's last input buffer         */
+    MYFLT     *rin, *rout;      /* the engine's buffers                 */
+    void      *lock, *cond, *thread;
+    void      *self;            /* the render thread's id               */
+    jmp_buf   exitjmp;          /* csound->LongJmp() from the render    */
+} LOOKAHEAD;
+
+#define LA_SLOT_AT(la, n)   (&(la)->slot[(n) % (la)->nslots])
+
+/* renders one host buffer; with the API lock held, so that API calls
+   run between buffers */
+
+static int lookahead_render(CSOUND *csound, LOOKAHEAD *la, LA_SLOT *s)
+{
+    int     nsmps = csound->oparms->outbufsamps, done = 0;
+
+    csoundLockMutex(la->lock);
+    memcpy(la->rin, la->in, csound->oparms->inbufsamps * sizeof(MYFLT));
+    csoundUnlockMutex(la->lock);
+    csoundLockMutex(csound->API_lock);
+    /* events sent through the API after this are not in the buffer */
+    s->gen = ATOMIC_GET(csound->lookAheadGen);
+    csound->sampsNeeded += nsmps;
+    while (csound->sampsNeeded > 0) {
+      do {
+        if (UNLIKELY((done = sensevents(csound))))
+          goto end;
+      } while (csound->kperf(csound));
+      csound->sampsNeeded -= csound->nspout;
+    }
+ end:
+    memcpy(s->buf, la->rout, nsmps * sizeof(MYFLT));
+    s->status = done;
+    csoundUnlockMutex(csound->API_lock);
+    return done;
+}
+
+static uintptr_t lookahead_thread(void *p)
+{
+    LOOKAHEAD *la = (LOOKAHEAD*) p;
+    CSOUND    *csound = la->csound;
+    volatile int status = 0;
+    int       retval, quit;
+
+    /* not csound->exitjmp, which the host thread may set at any time */
+    la->self = csoundGetCurrentThreadId();
+    if (UNLIKELY((retval = setjmp(la->exitjmp)))) {
+      /* csound->LongJmp() from inside the render: the lock is ours */
+      csoundUnlockMutex(csound->API_lock);
+      status = (retval - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS;
+      LA_SLOT_AT(la, la->wp)->status = status;
+      goto finish;
+    }
+    while (!status) {
+      csoundLockMutex(la->lock);
+      while (!la->quit && la->wp - la->rp >= la->nslots)
+        csoundCondWait(la->cond, la->lock);
+      quit = la->quit;
+      csoundUnlockMutex(la->lock);
+      if (quit)
+        break;
+      /* only this thread changes wp, and the slot is not being read */
+      status = lookahead_render(csound, la, LA_SLOT_AT(la, la->wp));
+      csoundLockMutex(la->lock);
+      la->wp++;
+      la->done = (status != 0);
+      csoundCondSignal(la->cond);
+      csoundUnlockMutex(la->lock);
+    }
+    return 0;
+ finish:
+    csoundLockMutex(la->lock);
+    la->wp++;
+    la->done = 1;
+    csoundCondSignal(la->cond);
+    csoundUnlockMutex(la->lock);
+    return 0;
+}
+
+/* starts the render thread on the first csoundPerformBuffer(); returns
+   zero if look-ahead cannot be used */
+
+int csoundLookAheadStart(CSOUND *csound)
+{
+    OPARMS    *O = csound->oparms;
+    LOOKAHEAD *la;
+    int       i;
+
+    if (!csound->enableHostImplementedAudioIO ||
+        !csound->hostRequestedBufferSize) {
+      csound->Warning(csound, Str("--look-ahead needs host implemented "
+                                  "audio I/O with host buffers; ignored\n"));
+      O->lookAhead = 0;
+      return 0;
+    }
+    la = (LOOKAHEAD*) csound->Calloc(csound, sizeof(LOOKAHEAD));
+    la->csound = csound;
+    la->nslots = O->lookAhead;
+    la->slot = (LA_SLOT*) csound->Calloc(csound, la->nslots * sizeof(LA_SLOT));
+    for (i = 0; i < la->nslots; i++)
+      la->slot[i].buf = (MYFLT*) csound->Calloc(csound, O->outbufsamps
+                                                        * sizeof(MYFLT));
+    la->xfade = (MYFLT*) csound->Calloc(csound, O->outbufsamps
+                                                * sizeof(MYFLT));
+    la->in = (MYFLT*) csound->Calloc(csound, O->inbufsamps * sizeof(MYFLT));
+    la->playgen = ATOMIC_GET(csound->lookAheadGen);
+    /* the host keeps the buffers it was given; the engine gets new ones */
+    la->rin = (MYFLT*) csound->Calloc(csound, O->inbufsamps * sizeof(MYFLT));
+    la->rout = (MYFLT*) csound->Calloc(csound, O->outbufsamps * sizeof(MYFLT));
+    csound->libsndStatics.hostinbuf = csound->libsndStatics.inbuf;
+    csound->libsndStatics.hostoutbuf = csound->libsndStatics.outbuf;
+    csound->libsndStatics.inbuf = la->rin;
+    csound->libsndStatics.outbuf = la->rout;
+    csound->libsndStatics.outbufp = la->rout +
+      (csound->libsndStatics.outbufp - csound->libsndStatics.hostoutbuf);
+    la->lock = csoundCreateMutex(0);
+    la->cond = csoundCreateCondVar();
+    csound->lookAhead = (void*) la;
+    la->thread = csoundCreateThread(lookahead_thread, (void*) la);
+    csound->Message(csound, Str("rendering %d buffers ahead\n"), la->nslots);
+    return 1;
+}
+
+/* csoundPerformBuffer() with --look-ahead: passes the input on and
+   returns the next rendered buffer, waiting for it if need be */
+
+int csoundLookAheadBuffer(CSOUND *csound)
+{
+    OPARMS    *O = csound->oparms;
+    LOOKAHEAD *la = (LOOKAHEAD*) csound->lookAhead;
+    LA_SLOT   *s;
+    MYFLT     *out;
+    long      gen;
+    int       status;
+
+    out = csound->libsndStatics.hostoutbuf;
+    gen = ATOMIC_GET(csound->lookAheadGen);
+    csoundLockMutex(la->lock);
+    memcpy(la->in, csound->libsndStatics.hostinbuf,
+           O->inbufsamps * sizeof(MYFLT));
+    if (gen != la->playgen)
+      la->playgen = gen;
+    for (;;) {
+      /* drop what was rendered before the latest event, including a
+         buffer that was being rendered when it was sent */
+      int dropped = 0;
+      while (la->rp < la->wp && LA_SLOT_AT(la, la->rp)->gen < la->playgen &&
+             LA_SLOT_AT(la, la->rp)->status == 0) {
+        if (!la->fade) {
+          memcpy(la->xfade, LA_SLOT_AT(la, la->rp)->buf,
+                 O->outbufsamps * sizeof(MYFLT));
+          la->fade = 1;
+        }
+        la->rp++;
+        dropped = 1;
+      }
+      if (dropped)
+        csoundCondSignal(la->cond);
+      if (la->rp < la->wp || la->done)
+        break;
+      csoundCondWait(la->cond, la->lock);
+    }
+    if (la->rp == la->wp) {                     /* performance ended */
+      csoundUnlockMutex(la->lock);
+      return la->status;
+    }
+    csoundUnlockMutex(la->lock);
+    s = LA_SLOT_AT(la, la->rp);
+    if (la->fade) {
+      int   nchnls = csound->nchnls, nframes = O->outbufsamps / nchnls;
+      int   i, c;
+      MYFLT g, dg = FL(1.0) / (MYFLT) nframes;
+      for (i = 0, g = FL(0.0); i < nframes; i++, g += dg)
+        for (c = 0; c < nchnls; c++)
+          out[i * nchnls + c] = s->buf[i * nchnls + c] * g
+                                + la->xfade[i * nchnls + c] * (FL(1.0) - g);
+      la->fade = 0;
+    }
+    else
+      memcpy(out, s->buf, O->outbufsamps * sizeof(MYFLT));
+    status = s->status;
+    csoundLockMutex(la->lock);
+    if (status)
+      la->status = status;
+    la->rp++;
+    csoundCondSignal(la->cond);
+    csoundUnlockMutex(la->lock);
+    return status;
+}
+
+/* called by csoundLongJmp(): jumps out of the render if called from the
+   render thread, returns otherwise */
+
+void csoundLookAheadLongJmp(CSOUND *csound, int n)
+{
+    LOOKAHEAD *la = (LOOKAHEAD*) csound->lookAhead;
+
+    if (la != NULL && csoundIsCurrentThread(la->self))
+      longjmp(la->exitjmp, n);
+}
+
+/* stops the render thread and gives the engine back the host's buffers;
+   called by csoundCleanup() before it takes the API lock */
+
+void csoundLookAheadStop(CSOUND *csound)
+{
+    LOOKAHEAD *la = (LOOKAHEAD*) csound->lookAhead;
+    int       i;
+
+    if (la == NULL)
+      return;
+    csoundLockMutex(la->lock);
+    la->quit = 1;
+    csoundCondSignal(la->cond);
+    csoundUnlockMutex(la->lock);
+    csoundJoinThread(la->thread);
+    csound->lookAhead = NULL;
+    free(la->self);
+    csound->libsndStatics.outbufp = csound->libsndStatics.hostoutbuf +
+      (csound->libsndStatics.outbufp - la->rout);
+    csound->libsndStatics.inbuf = csound->libsndStatics.hostinbuf;
+    csound->libsndStatics.outbuf = csound->libsndStatics.hostoutbuf;
+    csound->libsndStatics.hostinbuf = NULL;
+    csound->libsndStatics.hostoutbuf = NULL;
+    for (i = 0; i < la->nslots; i++)
+      csound->Free(csound, la->slot[i].buf);
+    csound->Free(csound, la->slot);
+    csound->Free(csound, la->xfade);
+    csound->Free(csound, la->in);
+    csound->Free(csound, la->rin);
+    csound->Free(csound, la->rout);
+    csoundDestroyCondVar(la->cond);
+    csoundDestroyMutex(la->lock);
+    csound->Free(csound, la);
+}
@@ -175,6 +175,12 @@ PUBLIC int csoundCompileArgs(CSOUND *csound, int argc, const char **argv)
     if (UNLIKELY(--argc <= 0)) {
       dieu(csound, Str("insufficient arguments"));
     }
+    /* keep the command line, for --render-jobs (render.c) */
+    csound->renderArgc = ac;
+    csound->renderArgv = (const char**) csound->Malloc(csound,
+                                                       ac * sizeof(char*));
+    for (n = 0; n < ac; n++)
+      csound->renderArgv[n] = cs_strdup(csound, (char*) argv[n]);
     /* command line: allow orc/sco/csd name */
     csound->orcname_mode = 0;   /* 0: normal, 1: ignore, 2: fail */
     if (UNLIKELY(argdecode(csound, argc, argv) == 0))
@@ -336,47 +342,65 @@ PUBLIC int csoundCompileArgs(CSOUND *csound, int argc, const char **argv)
     /* IV - Oct 31 2002: now we can read and sort the score */
 
     if (csound->scorename != NULL &&
-        (n = strlen(csound->scorename)) > 4 &&  /* if score ?.srt or ?.xtr */
-        (!strcmp(csound->scorename + (n - 4), ".srt") ||
-         !strcmp(csound->scorename + (n - 4), ".xtr"))) {
-      csound->Message(csound, Str("using previous %s\n"), csound->scorename);
-      //playscore = sortedscore = csound->scorename;   /*  use that one */
-      csound->scorestr = NULL;
-      csound->scorestr = copy_to_corefile(csound, csound->scorename, NULL, 1);
+        (n = strlen(csound->scorename)) > 4 &&  /* binary sorted score */
+        !strcmp(csound->scorename + (n - 4), ".bsc")) {
+      csound->Message(csound, Str("using binary score %s\n"),
+                      csound->scorename);
+      if (UNLIKELY(scorebin_open(csound, csound->scorename) != CSOUND_SUCCESS))
+        csoundDie(csound, Str("cannot open scorefile %s"), csound->scorename);
+      if (csound->xfilename != NULL)
+        csound->Warning(csound, Str("score extract (-x) ignored for a "
+                                    "binary score"));
+      csound->Message(csound, Str("\t... done\n"));
+      O->playscore = NULL;
     }
     else {
-      //sortedscore = NULL;
-      if (csound->scorestr==NULL) {
+      if (csound->scorename != NULL &&
+          (n = strlen(csound->scorename)) > 4 &&  /* if score ?.srt or ?.xtr */
+          (!strcmp(csound->scorename + (n - 4), ".srt") ||
+           !strcmp(csound->scorename + (n - 4), ".xtr"))) {
+        csound->Message(csound, Str("using previous %s\n"), csound->scorename);
+        //playscore = sortedscore = csound->scorename;   /*  use that one */
+        csound->scorestr = NULL;
         csound->scorestr = copy_to_corefile(csound, csound->scorename, NULL, 1);
-        if (UNLIKELY(csound->scorestr==NULL))
-          csoundDie(csound, Str("cannot open scorefile %s"), csound->scorename);
       }
-      csound->Message(csound, Str("sorting score ...\n"));
-      //printf("score:\n%s", corfile_current(csound->scorestr));
-      scsortstr(csound, csound->scorestr);
-      //printf("*** keep_tmp = %d\n", csound->keep_tmp);
-      if (csound->keep_tmp) {
-        FILE *ff = fopen("score.srt", "w");
-        if (csound->keep_tmp==1)
-          fputs(corfile_body(csound->scstr), ff);
-        else
-          put_sorted_score(csound, corfile_body(csound->scstr), ff);
-        fclose(ff);
+      else {
+        //sortedscore = NULL;
+        if (csound->scorestr==NULL) {
+          csound->scorestr = copy_to_corefile(csound, csound->scorename,
+                                              NULL, 1);
+          if (UNLIKELY(csound->scorestr==NULL))
+            csoundDie(csound, Str("cannot open scorefile %s"),
+                      csound->scorename);
+        }
+        csound->Message(csound, Str("sorting score ...\n"));
+        //printf("score:\n%s", corfile_current(csound->scorestr));
+        scsortstr(csound, csound->scorestr);
+        //printf("*** keep_tmp = %d\n", csound->keep_tmp);
+        if (csound->keep_tmp) {
+          FILE *ff = fopen("score.srt", "w");
+          if (csound->keep_tmp==1)
+            fputs(corfile_body(csound->scstr), ff);
+          else
+            put_sorted_score(csound, corfile_body(csound->scstr), ff);
+          fclose(ff);
+        }
       }
+      if (csound->xfilename != NULL) {            /* optionally extract */
+        if (UNLIKELY(!(xfile = fopen(csound->xfilename, "r"))))
+          csoundDie(csound, Str("cannot open extract file %s"),
+                    csound->xfilename);
+        csoundNotifyFileOpened(csound, csound->xfilename,
+                               CSFTYPE_EXTRACT_PARMS, 0, 0);
+        csound->Message(csound, Str("  ... extracting ...\n"));
+        scxtract(csound, csound->scstr, xfile);
+        fclose(xfile);
+        csound->tempStatus &= ~csPlayScoMask;
+      }
+      csound->Message(csound, Str("\t... done\n"));
+      /* copy sorted score name */
+      O->playscore = csound->scstr;
     }
-    if (csound->xfilename != NULL) {            /* optionally extract */
-      if (UNLIKELY(!(xfile = fopen(csound->xfilename, "r"))))
-        csoundDie(csound, Str("cannot open extract file %s"),csound->xfilename);
-      csoundNotifyFileOpened(csound, csound->xfilename,
-                             CSFTYPE_EXTRACT_PARMS, 0, 0);
-      csound->Message(csound, Str("  ... extracting ...\n"));
-      scxtract(csound, csound->scstr, xfile);
-      fclose(xfile);
-      csound->tempStatus &= ~csPlayScoMask;
-    }
-    csound->Message(csound, Str("\t... done\n"));
-    /* copy sorted score name */
-    O->playscore = csound->scstr;
     /* IV - Jan 28 2005 */
     print_benchmark_info(csound, Str("end of score sort"));
     if (O->syntaxCheckOnly) {
@@ -0,0 +1,295 @@
+/*
+    render.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Parallel offline rendering (--render-jobs=N).
+
+   The score is cut at its sections.  A first instance runs the whole
+   score init-only (-I) to find the sample at which each section starts;
+   then every section is rendered by its own instance, up to N at a time,
+   each one started --render-warmup seconds before its section (skipping
+   earlier events) so that global instruments, reverb tails and the like
+   have the same state as in a serial render.  The instances run with -n
+   and hand their spout to temporary files; this instance writes them to
+   its own output in order, through its usual output path, so the file
+   format, dither, peak chunks and amplitude reports are unchanged.
+
+   Events created at performance time (event, schedkwhen, MIDI, line
+   events, API calls) are only seen by the segment that makes them, so a
+   score whose sections depend on each other that way should be rendered
+   serially, or with enough warm-up. */
+
+#include "csoundCore.h"
+#include "prototyp.h"
+
+typedef struct {
+    int64_t   begin, end;       /* samples of the output kept           */
+    char      *tmpname;
+    int       state;            /* 0: waiting, 1: running, 2: done,
+                                   -1: failed                           */
+} RSEGMENT;
+
+typedef struct {
+    CSOUND    *csound;
+    RSEGMENT  *seg;
+    int       nseg, next;
+    double    warmup;
+    void      *lock, *cond;
+} RENDER;
+
+#define SEG_DONE(s)     ((s)->state == 2 || (s)->state < 0)
+
+static void render_msg(CSOUND *child, int attr, const char *fmt, va_list args)
+{
+    CSOUND  *csound = (CSOUND*) csoundGetHostData(child);
+    /* only pass errors on: N instances would make the log unreadable */
+    if ((attr & CSOUNDMSG_TYPE_MASK) == CSOUNDMSG_ERROR)
+      csoundMessageV(csound, attr, fmt, args);
+}
+
+/* creates and starts an instance with the same arguments as csound, plus
+   the overrides in 'extra' */
+
+static CSOUND *render_child(CSOUND *csound, const char **extra, int nextra)
+{
+    CSOUND  *child;
+    const char **argv;
+    int     argc = csound->renderArgc, i;
+
+    if ((child = csoundCreate((void*) csound)) == NULL)
+      return NULL;
+    csoundSetMessageCallback(child, render_msg);
+    argv = (const char**) malloc(sizeof(char*) * (argc + nextra + 1));
+    for (i = 0; i < argc; i++)
+      argv[i] = csound->renderArgv[i];
+    for (i = 0; i < nextra; i++)
+      argv[argc + i] = extra[i];
+    argv[argc + nextra] = NULL;
+    i = csoundCompileArgs(child, argc + nextra, argv);
+    free(argv);
+    if (i != CSOUND_SUCCESS || csoundStart(child) != CSOUND_SUCCESS ||
+        child->esr != csound->esr || child->ksmps != csound->ksmps ||
+        child->nchnls != csound->nchnls) {
+      csoundDestroy(child);
+      return NULL;
+    }
+    return child;
+}
+
+/* finds the sample at which each section starts, without performing */
+
+static int64_t *render_sections(CSOUND *csound, int *nsect)
+{
+    const char *extra[] = { "-n", "-I", "-d", "-m0", "--render-jobs=1" };
+    CSOUND  *probe;
+    int64_t *bound;
+    int     n = 1, max = 16;
+    double  offs = 0.0;
+
+    if ((probe = render_child(csound, extra, 5)) == NULL)
+      return NULL;
+    bound = (int64_t*) csound->Malloc(csound, max * sizeof(int64_t));
+    bound[0] = 0;
+    while (csoundPerformKsmps(probe) == 0) {
+      if (probe->timeOffs > offs) {             /* a new section started */
+        offs = probe->timeOffs;
+        if (n + 1 >= max) {
+          max *= 2;
+          bound = (int64_t*) csound->ReAlloc(csound, bound,
+                                             max * sizeof(int64_t));
+        }
+        bound[n++] = (int64_t) (offs * probe->esr + 0.5);
+      }
+    }
+    bound[n] = probe->icurTime;                 /* end of score */
+    csoundCleanup(probe);
+    csoundDestroy(probe);
+    *nsect = n;
+    return bound;
+}
+
+static int render_segment(RENDER *r, RSEGMENT *seg)
+{
+    CSOUND  *csound = r->csound;
+    char    skip[64];
+    const char *extra[] = { "-n", "-d", "-m0", "--limiter=0",
+                            "--render-jobs=1", skip };
+    CSOUND  *child;
+    FILE    *f;
+    int64_t start, t;
+    int     n = csound->nspout, ok = 1;
+
+    /* start on a k-cycle boundary, warm-up seconds early */
+    start = seg->begin - (int64_t) (r->warmup * csound->esr);
+    start = start > 0 ? start - start % csound->ksmps : 0;
+    snprintf(skip, sizeof(skip), "-+skip_seconds=%.17g",
+             (double) start / csound->esr);
+    if ((child = render_child(csound, extra, 6)) == NULL)
+      return -1;
+    if ((f = fopen(seg->tmpname, "wb")) == NULL) {
+      csoundDestroy(child);
+      return -1;
+    }
+    while (csoundPerformKsmps(child) == 0) {
+      t = child->icurTime - child->ksmps;       /* first sample in spout */
+      if (t >= seg->end)
+        break;
+      if (t >= seg->begin &&
+          fwrite(child->spout, sizeof(MYFLT), n, f) != (size_t) n) {
+        ok = 0;
+        break;
+      }
+    }
+    ok = (fclose(f) == 0 && ok);
+    csoundCleanup(child);
+    csoundDestroy(child);
+    return ok ? 2 : -1;
+}
+
+static uintptr_t render_thread(void *p)
+{
+    RENDER  *r = (RENDER*) p;
+    for (;;) {
+      RSEGMENT *seg;
+      int     state;
+      csoundLockMutex(r->lock);
+      if (r->next >= r->nseg) {
+        csoundUnlockMutex(r->lock);
+        return 0;
+      }
+      seg = &r->seg[r->next++];
+      seg->state = 1;
+      csoundUnlockMutex(r->lock);
+      state = render_segment(r, seg);
+      csoundLockMutex(r->lock);
+      seg->state = state;
+      csoundCondSignal(r->cond);
+      csoundUnlockMutex(r->lock);
+    }
+}
+
+/* copies a rendered segment to the output, one k-cycle at a time */
+
+static int render_write(CSOUND *csound, RSEGMENT *seg)
+{
+    FILE    *f;
+    int64_t t;
+    int     n = csound->nspout;
+
+    if ((f = fopen(seg->tmpname, "rb")) == NULL)
+      return -1;
+    for (t = seg->begin; t < seg->end; t += csound->ksmps) {
+      size_t  got = fread(csound->spout, sizeof(MYFLT), n, f);
+      if (got == 0)                             /* score ended early */
+        break;
+      if (got < (size_t) n)
+        memset(csound->spout + got, 0, (n - got) * sizeof(MYFLT));
+      csound->icurTime = t + csound->ksmps;
+      csound->spoutran(csound);
+      if (got < (size_t) n)
+        break;
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Performs the score in parallel if --render-jobs asked for it and the
+   performance allows it.  Returns 0 if the score should be performed the
+   usual way instead, otherwise what csoundPerform() returns. */
+
+int csoundRenderParallel(CSOUND *csound)
+{
+    OPARMS  *O = csound->oparms;
+    RENDER  r;
+    int64_t *bound;
+    void    **threads;
+    int     i, nthreads, nsect = 0, retval = 2;
+
+    if (csound->renderArgv == NULL || !O->sfwrite || O->sfread ||
+        (O->outfilename != NULL && strncmp(O->outfilename, "dac", 3) == 0) ||
+        O->RTevents || O->Midiin || O->FMidiin || O->usingcscore ||
+        O->Linein || csound->csoundScoreOffsetSeconds_ > FL(0.0)) {
+      csound->Warning(csound, Str("--render-jobs: only scores rendered to "
+                                  "a file from the command line can be "
+                                  "rendered in parallel; performing "
+                                  "serially\n"));
+      return 0;
+    }
+    if ((bound = render_sections(csound, &nsect)) == NULL) {
+      csound->Warning(csound, Str("--render-jobs: could not read score "
+                                  "sections; performing serially\n"));
+      return 0;
+    }
+    if (nsect < 2) {
+      csound->Message(csound, Str("--render-jobs: score has one section; "
+                                  "performing serially\n"));
+      csound->Free(csound, bound);
+      return 0;
+    }
+    memset(&r, 0, sizeof(RENDER));
+    r.csound = csound;
+    r.nseg = nsect;
+    r.warmup = O->renderWarmup;
+    r.seg = (RSEGMENT*) csound->Calloc(csound, nsect * sizeof(RSEGMENT));
+    for (i = 0; i < nsect; i++) {
+      r.seg[i].begin = bound[i];
+      r.seg[i].end = bound[i + 1];
+      r.seg[i].tmpname = csoundTmpFileName(csound, NULL);
+    }
+    csound->Free(csound, bound);
+    r.lock = csoundCreateMutex(0);
+    r.cond = csoundCreateCondVar();
+    nthreads = O->renderJobs < nsect ? O->renderJobs : nsect;
+    csound->Message(csound, Str("rendering %d sections with %d jobs\n"),
+                    nsect, nthreads);
+    threads = (void**) csound->Calloc(csound, nthreads * sizeof(void*));
+    for (i = 0; i < nthreads; i++)
+      threads[i] = csoundCreateThread(render_thread, (void*) &r);
+    /* write each section as soon as it is ready */
+    for (i = 0; i < nsect; i++) {
+      RSEGMENT *seg = &r.seg[i];
+      csoundLockMutex(r.lock);
+      while (!SEG_DONE(seg))
+        csoundCondWait(r.cond, r.lock);
+      csoundUnlockMutex(r.lock);
+      if (seg->state < 0 || render_write(csound, seg) != 0) {
+        csound->ErrorMsg(csound, Str("--render-jobs: section %d failed\n"),
+                         i + 1);
+        retval = CSOUND_ERROR;
+        csoundLockMutex(r.lock);
+        r.next = r.nseg;                        /* start no more */
+        csoundUnlockMutex(r.lock);
+        break;
+      }
+      remove(seg->tmpname);
+    }
+    for (i = 0; i < nthreads; i++)
+      if (threads[i] != NULL)
+        csoundJoinThread(threads[i]);
+    for (i = 0; i < nsect; i++) {
+      remove(r.seg[i].tmpname);
+      csound->Free(csound, r.seg[i].tmpname);
+    }
+    csound->Free(csound, threads);
+    csound->Free(csound, r.seg);
+    csoundDestroyCondVar(r.cond);
+    csoundDestroyMutex(r.lock);
+    return retval;
+}
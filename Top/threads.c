@@ -197,6 +197,13 @@ PUBLIC void *csoundGetCurrentThreadId(void)
     return ppthread;
 }
 
+/* non-zero if 'id', from csoundGetCurrentThreadId(), is the caller */
+
+int csoundIsCurrentThread(void *id)
+{
+    return (id != NULL && pthread_equal(*((pthread_t*) id), pthread_self()));
+}
+
 PUBLIC uintptr_t csoundJoinThread(void *thread)
 {
     void *threadRoutineReturnValue = NULL;
@@ -553,6 +560,26 @@ PUBLIC void csoundCondWait(void* condVar, void* mutex) {
         pthread_cond_wait(condVar, mutex);
 }
 
+PUBLIC int csoundCondTimedWait(void* condVar, void* mutex,
+                               size_t milliseconds) {
+    struct timeval  tv;
+    struct timespec ts;
+    register size_t n, s;
+#ifndef HAVE_GETTIMEOFDAY
+    gettimeofday_(&tv, NULL);
+#else
+    gettimeofday(&tv, NULL);
+#endif
+    s = milliseconds / (size_t) 1000;
+    n = milliseconds - (s * (size_t) 1000);
+    s += (size_t) tv.tv_sec;
+    n = (size_t) (((int) n * 1000 + (int) tv.tv_usec) * 1000);
+    ts.tv_nsec = (long) (n < (size_t) 1000000000 ? n : n - 1000000000);
+    ts.tv_sec = (time_t) (n < (size_t) 1000000000 ? s : s + 1);
+    return pthread_cond_timedwait((pthread_cond_t*) condVar,
+                                  (pthread_mutex_t*) mutex, &ts);
+}
+
 PUBLIC void csoundCondSignal(void* condVar) {
         pthread_cond_signal(condVar);
 }
@@ -617,6 +644,11 @@ PUBLIC void *csoundGetCurrentThreadId(void)
     return (void*) d;
 }
 
+int csoundIsCurrentThread(void *id)
+{
+    return (id != NULL && *((DWORD*) id) == GetCurrentThreadId());
+}
+
 PUBLIC uintptr_t csoundJoinThread(void *thread)
 {
   DWORD   retval = (DWORD) 0;
@@ -782,6 +814,13 @@ PUBLIC void csoundCondWait(void* condVar, void* mutex) {
     SleepConditionVariableCS(cv, cs, INFINITE);
 }
 
+PUBLIC int csoundCondTimedWait(void* condVar, void* mutex,
+                               size_t milliseconds) {
+    CONDITION_VARIABLE* cv = (CONDITION_VARIABLE*)condVar;
+    CRITICAL_SECTION* cs = (CRITICAL_SECTION*)mutex;
+    return (SleepConditionVariableCS(cv, cs, (DWORD) milliseconds) ? 0 : 1);
+}
+
 PUBLIC void csoundCondSignal(void* condVar) {
     CONDITION_VARIABLE* cv = (CONDITION_VARIABLE*)condVar;
     WakeConditionVariable(cv);
@@ -865,6 +904,9 @@ PUBLIC int csoundWaitBarrier(void *barrier)
 
 #else
 
+#include <errno.h>
+#include <time.h>
+
 PUBLIC void *csoundCreateThread(uintptr_t (*threadRoutine)(void *),
                                 void *userdata)
 {
@@ -878,6 +920,12 @@ PUBLIC void *csoundGetCurrentThreadId(void)
     return NULL;
 }
 
+int csoundIsCurrentThread(void *id)
+{
+    (void) id;
+    return 0;
+}
+
 PUBLIC uintptr_t csoundJoinThread(void *thread)
 {
     //notImplementedWarning_("csoundJoinThread");
@@ -967,6 +1015,14 @@ PUBLIC void csoundCondWait(void* condVar, void* mutex) {
     //notImplementedWarning_("csoundCreateCondWait");
 }
 
+/* with no other thread to signal it, the wait always times out */
+PUBLIC int csoundCondTimedWait(void* condVar, void* mutex,
+                               size_t milliseconds) {
+    (void) condVar; (void) mutex;
+    csoundSleep(milliseconds);
+    return ETIMEDOUT;
+}
+
 PUBLIC void csoundCondSignal(void* condVar) {
     // notImplementedWarning_("csoundCreateCondSignal");
 }
@@ -981,7 +1037,12 @@ PUBLIC long csoundRunCommand(const char * const *argv, int noWait) {
 }
 
 PUBLIC void csoundSleep(size_t milliseconds) {
-    //notImplementedWarning_("csoundSleep");
+    struct timespec ts;
+
+    ts.tv_sec = (time_t) (milliseconds / (size_t) 1000);
+    ts.tv_nsec = (long) (milliseconds % (size_t) 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0)
+      ;
 }
 
 
@@ -47,11 +47,19 @@ int csoundScoreEventInternal(CSOUND *csound, char type,
 int csoundScoreEventAbsoluteInternal(CSOUND *csound, char type,
                                      const MYFLT *pfields, long numFields,
                                      double time_ofs);
+int csoundScoreEventStringsInternal(CSOUND *csound, char type,
+                                    const MYFLT *pfields,
+                                    const char *const *strfields,
+                                    long numFields);
 void set_channel_data_ptr(CSOUND *csound, const char *name,
                           void *ptr, int newSize);
 
+/* counts the events that interrupt look-ahead (see lookahead.c) */
+#define API_EVENT(csound)   ATOMIC_INCR((csound)->lookAheadGen)
+
 enum {INPUT_MESSAGE=1, READ_SCORE, SCORE_EVENT, SCORE_EVENT_ABS,
-      TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE};
+      TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE,
+      SCORE_EVENT_STR};
 
 /* MAX QUEUE SIZE */
 #define API_MAX_QUEUE 1024
@@ -118,6 +126,11 @@ void *message_enqueue(CSOUND *csound, int32_t message, char *args,
     csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wput,
                                          API_MAX_QUEUE)] = msg;
     ATOMIC_INCR(csound->msg_queue_items);
+    /* counted once it can be read, so that a buffer rendered ahead
+       (see lookahead.c) either has it or is dropped */
+    if (message != TABLE_COPY_OUT && message != TABLE_COPY_IN &&
+        message != TABLE_SET && message != MERGE_STATE)
+      API_EVENT(csound);
     return (void *) rtn;
   }
   else return NULL;
@@ -180,6 +193,32 @@ void message_dequeue(CSOUND *csound) {
                                              ofs);
         }
         break;
+      case SCORE_EVENT_STR:
+        {
+          /* type, numFields, p-fields, string flags, then the strings */
+          char type;
+          long i, numFields;
+          const MYFLT *pfields;
+          const char *flags, *s, **strfields;
+          type = msg->args[0];
+          memcpy(&numFields, msg->args + ARG_ALIGN, sizeof(long));
+          pfields = (const MYFLT *) (msg->args + ARG_ALIGN*2);
+          flags = (const char *) (pfields + numFields);
+          s = flags + numFields;
+          strfields = (const char **)
+            csound->Malloc(csound, (numFields + 1) * sizeof(char *));
+          for (i = 0; i < numFields; i++) {
+            if (flags[i]) {
+              strfields[i] = s;
+              s += strlen(s) + 1;
+            }
+            else strfields[i] = NULL;
+          }
+          csoundScoreEventStringsInternal(csound, type, pfields,
+                                          strfields, numFields);
+          csound->Free(csound, strfields);
+        }
+        break;
       case TABLE_COPY_OUT:
         {
           int table;
@@ -318,6 +357,37 @@ static inline int64_t *csoundScoreEventAbsolute_enqueue(CSOUND *csound, char typ
   return message_enqueue(csound,SCORE_EVENT_ABS, args, argsize);
 }
 
+/* unlike the numeric score events, the p-fields and strings are
+   copied into the message, so the caller's arrays can be reused */
+static inline void csoundScoreEventStrings_enqueue(CSOUND *csound, char type,
+                                                   const MYFLT *pfields,
+                                                   const char *const *strfields,
+                                                   long numFields)
+{
+  int argsize = ARG_ALIGN*2 + numFields*(sizeof(MYFLT) + 1);
+  char *args, *flags, *s;
+  long i;
+  for (i = 0; i < numFields; i++)
+    if (strfields != NULL && strfields[i] != NULL)
+      argsize += strlen(strfields[i]) + 1;
+  args = (char *) csound->Calloc(csound, argsize);
+  args[0] = type;
+  memcpy(args+ARG_ALIGN, &numFields, sizeof(long));
+  memcpy(args+2*ARG_ALIGN, pfields, numFields*sizeof(MYFLT));
+  flags = args + 2*ARG_ALIGN + numFields*sizeof(MYFLT);
+  s = flags + numFields;
+  for (i = 0; i < numFields; i++) {
+    if (strfields != NULL && strfields[i] != NULL) {
+      size_t n = strlen(strfields[i]) + 1;
+      flags[i] = 1;
+      memcpy(s, strfields[i], n);
+      s += n;
+    }
+  }
+  message_enqueue(csound, SCORE_EVENT_STR, args, argsize);
+  csound->Free(csound, args);
+}
+
 /* this is to be called from
    csoundKillInstanceInternal() in insert.c
 */
@@ -353,6 +423,7 @@ void mergeState_enqueue(CSOUND *csound, ENGINE_STATE *e, TYPE_TABLE* t, OPDS *id
 void csoundInputMessage(CSOUND *csound, const char *message){
   csoundLockMutex(csound->API_lock);
   csoundInputMessageInternal(csound, message);
+  API_EVENT(csound);
   csoundUnlockMutex(csound->API_lock);
 }
 
@@ -360,6 +431,7 @@ int csoundReadScore(CSOUND *csound, const char *message){
   int res;
   csoundLockMutex(csound->API_lock);
   res = csoundReadScoreInternal(csound, message);
+  API_EVENT(csound);
   csoundUnlockMutex(csound->API_lock);
   return res;
 }
@@ -390,6 +462,7 @@ int csoundScoreEvent(CSOUND *csound, char type,
 
   csoundLockMutex(csound->API_lock);
   csoundScoreEventInternal(csound, type, pfields, numFields);
+  API_EVENT(csound);
   csoundUnlockMutex(csound->API_lock);
   return OK;
 
@@ -401,15 +474,31 @@ int csoundScoreEventAbsolute(CSOUND *csound, char type,
 {
   csoundLockMutex(csound->API_lock);
   csoundScoreEventAbsoluteInternal(csound, type, pfields, numFields, time_ofs);
+  API_EVENT(csound);
   csoundUnlockMutex(csound->API_lock);
   return OK;
 }
 
+int csoundScoreEventStrings(CSOUND *csound, char type,
+                            const MYFLT *pfields,
+                            const char *const *strfields, long numFields)
+{
+  int ret;
+  csoundLockMutex(csound->API_lock);
+  ret = csoundScoreEventStringsInternal(csound, type, pfields,
+                                        strfields, numFields);
+  API_EVENT(csound);
+  csoundUnlockMutex(csound->API_lock);
+  return ret;
+}
+
 int csoundKillInstance(CSOUND *csound, MYFLT instr, char *instrName,
                        int mode, int allow_release){
-  int async = 0;
-  return csoundKillInstanceInternal(csound, instr, instrName, mode,
-                                    allow_release, async);
+  int async = 0, res;
+  res = csoundKillInstanceInternal(csound, instr, instrName, mode,
+                                   allow_release, async);
+  API_EVENT(csound);
+  return res;
 }
 
 int csoundCompileTree(CSOUND *csound, TREE *root) {
@@ -479,6 +568,16 @@ void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
   csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs);
 }
 
+void csoundScoreEventStringsAsync(CSOUND *csound, char type,
+                                  const MYFLT *pfields,
+                                  const char *const *strfields,
+                                  long numFields)
+{
+  if (numFields < 0 || numFields > PMAX)
+    return;
+  csoundScoreEventStrings_enqueue(csound, type, pfields, strfields, numFields);
+}
+
 int csoundCompileTreeAsync(CSOUND *csound, TREE *root) {
   int async = 1;
   return csoundCompileTreeInternal(csound, root, async);
@@ -263,6 +263,32 @@ PUBLIC int csoundScoreSort(CSOUND *csound, FILE *inFile, FILE *outFile)
     return 0;
 }
 
+/**
+ * Sorts score file 'inFile' and writes the result to 'outFile' as a
+ * binary score (see Engine/scorebin.c). The Csound instance should be
+ * initialised before calling this function, and csoundReset() should be
+ * called afterwards to clean up. On success, zero is returned.
+ */
+
+PUBLIC int csoundScoreSortBinary(CSOUND *csound, FILE *inFile, FILE *outFile)
+{
+    int   err;
+    CORFIL *inf = corfile_create_w(csound);
+    int c;
+    if ((err = setjmp(csound->exitjmp)) != 0) {
+      return ((err - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
+    }
+    while ((c=getc(inFile))!=EOF) corfile_putc(csound, c, inf);
+    corfile_puts(csound, "\ne\n#exit\n", inf);
+    corfile_rewind(inf);
+    csound->scorestr = inf;
+    scsortstr(csound, inf);
+    corfile_rewind(csound->scstr);
+    err = scorebin_write(csound, outFile);
+    corfile_rm(csound, &csound->scstr);
+    return err;
+}
+
 /**
  * Extracts from 'inFile', controlled by 'extractFile', and writes
  * the result to 'outFile'. The Csound instance should be initialised
@@ -700,6 +700,23 @@ extern "C" {
    */
   PUBLIC void csoundDestroy(CSOUND *);
 
+  /**
+   * Links an instance to a template instance, which must have been
+   * compiled and started but is never performed itself. Function
+   * tables that csound later creates with the same number, size and
+   * GEN arguments as one in the template reuse the template's table
+   * instead of generating their own copy (not for GENs that read a file
+   * or another table, nor for the random GEN21); such shared tables are
+   * never freed by csound and must be treated as read-only: resize
+   * refuses them, but tablew, tabw and the pointer from csoundGetTable()
+   * are not checked, and a write through them changes the table for the
+   * template and every instance linked to it. The template must outlive
+   * every instance linked to it. Call before compiling; the link is cleared
+   * by csoundReset(). Returns CSOUND_ERROR if tmpl is csound itself
+   * or a different template is already set.
+   */
+  PUBLIC int csoundSetTemplate(CSOUND *csound, CSOUND *tmpl);
+
   /**
    * Returns the version number times 1000 (5.00.0 = 5000).
    */
@@ -905,6 +922,10 @@ extern "C" {
    * If called until it returns true, will perform an entire score.
    * Enables external software to control the execution of Csound,
    * and to synchronize performance with audio input and output.
+   * If the audio driver performs the k-cycles from its own thread
+   * (-+rtaudio=jack with -+jack_callback=1), the first call starts it
+   * and blocks like csoundPerform() until the whole score has finished
+   * or csoundStop() is called, then returns the same value.
    */
   PUBLIC int csoundPerformKsmps(CSOUND *);
 
@@ -1412,6 +1433,21 @@ extern "C" {
                                                             unsigned char *buf,
                                                             int nBytes));
 
+  /**
+   * Queues one complete short MIDI message (at most 8 bytes, including
+   * an optional port byte after the status) received 'age' seconds ago.
+   * May be called from any single driver thread while MIDI input is open;
+   * the messages are read by the engine together with those returned by
+   * the read callback. The queue takes a single producer: calls from more
+   * than one thread must be serialised by the caller. With
+   * --sample-accurate, the arrival time becomes the sample offset of the
+   * notes started by the message.
+   * Returns zero on success, and CSOUND_MEMORY, dropping the message,
+   * when the queue is full.
+   */
+  PUBLIC int csoundPushMidiMessage(CSOUND *, const unsigned char *msg,
+                                   int nBytes, double age);
+
   /**
    * Sets callback for closing real time MIDI input.
    */
@@ -1539,6 +1575,16 @@ extern "C" {
    */
   PUBLIC int csoundScoreSort(CSOUND *, FILE *inFile, FILE *outFile);
 
+  /**
+   * Sorts score file 'inFile' as csoundScoreSort() does, but writes the
+   * result to 'outFile' as a binary score, which Csound plays when given
+   * a score file name ending in ".bsc" without sorting or parsing it
+   * again. 'outFile' should be opened in binary mode. The Csound instance
+   * should be initialised before calling this function, and csoundReset()
+   * should be called afterwards to clean up. On success, zero is returned.
+   */
+  PUBLIC int csoundScoreSortBinary(CSOUND *, FILE *inFile, FILE *outFile);
+
   /**
    * Extracts from 'inFile', controlled by 'extractFile', and writes
    * the result to 'outFile'. The Csound instance should be initialised
@@ -1864,6 +1910,28 @@ extern "C" {
    */
   PUBLIC void csoundScoreEventAbsoluteAsync(CSOUND *,
                  char type, const MYFLT *pfields, long numFields, double time_ofs);
+  /**
+   * Like csoundScoreEvent(), but any p-field may be a string, such as an
+   * instrument name in p1 or a file name. 'strFields' is either NULL or
+   * an array of numFields strings: where strFields[i] is not NULL, p-field
+   * i+1 is that string and pFields[i] is ignored. The event is passed to
+   * the engine directly, without being formatted or parsed as text.
+   * Returns zero on success.
+   */
+  PUBLIC int csoundScoreEventStrings(CSOUND *, char type,
+                                     const MYFLT *pFields,
+                                     const char *const *strFields,
+                                     long numFields);
+
+  /**
+   *  Asynchronous version of csoundScoreEventStrings(). The p-fields
+   *  and strings are copied, so the arrays may be reused on return.
+   */
+  PUBLIC void csoundScoreEventStringsAsync(CSOUND *, char type,
+                                           const MYFLT *pFields,
+                                           const char *const *strFields,
+                                           long numFields);
+
   /**
    * Input a NULL-terminated string (as if from a console),
    * used for line events.
@@ -2259,6 +2327,14 @@ extern "C" {
   /** Waits up on a conditional variable and mutex */
   PUBLIC void csoundCondWait(void* condVar, void* mutex);
 
+  /**
+   * Waits up on a conditional variable and mutex, for at most the
+   * specified number of milliseconds. Returns zero if the conditional
+   * variable was signalled, and non-zero on timeout or error.
+   */
+  PUBLIC int csoundCondTimedWait(void* condVar, void* mutex,
+                                 size_t milliseconds);
+
   /** Signals a conditional variable */
   PUBLIC void csoundCondSignal(void* condVar);
 
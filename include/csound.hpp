@@ -928,6 +928,13 @@ public:
   {
     return csoundGetInputName(csound);
   }
+  /* added last so that the vtable of existing methods is unchanged */
+  virtual int ScoreEventStrings(char type, const MYFLT *pFields,
+                                const char *const *strFields, long numFields)
+  {
+    return csoundScoreEventStrings(csound, type, pFields, strFields,
+                                   numFields);
+  }
 };
 
 class CsoundThreadLock {
@@ -69,6 +69,30 @@
 #define _MM_SET_DENORMALS_ZERO_MODE(mode)
 #endif
 #endif
+
+/* Put the calling thread in flush-to-zero / denormals-are-zero mode
+   so that decaying filter and reverb states do not fall into slow
+   subnormal arithmetic.  Cheap enough to do at the top of each k-cycle,
+   which covers every thread that runs perf code. */
+#if defined(__SSE__) && !defined(EMSCRIPTEN)
+#define CS_SET_FTZ_MODE()   _mm_setcsr(_mm_getcsr() | 0x8040) /* FZ | DAZ */
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define CS_SET_FTZ_MODE()                                               \
+  do {                                                                  \
+    uint64_t fpcr_;                                                     \
+    __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (fpcr_));               \
+    __asm__ __volatile__ ("msr fpcr, %0" : : "r" (fpcr_ | (1ULL << 24))); \
+  } while (0)
+#elif defined(__arm__) && defined(__ARM_FP) && defined(__GNUC__)
+#define CS_SET_FTZ_MODE()                                               \
+  do {                                                                  \
+    uint32_t fpscr_;                                                    \
+    __asm__ __volatile__ ("vmrs %0, fpscr" : "=r" (fpscr_));            \
+    __asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (fpscr_ | (1U << 24))); \
+  } while (0)
+#else
+#define CS_SET_FTZ_MODE()
+#endif
 #endif
 
 #ifdef __cplusplus
@@ -214,6 +238,11 @@ extern int ISSTRCOD(MYFLT);
 #define ASYNC_GLOBAL 1
 #define ASYNC_LOCAL  2
 
+/* flags for csound->StreamOpen() */
+#define CS_STREAM_WAIT  1       /* reads wait for the decoder (not real-time) */
+#define CS_STREAM_LOOP  2       /* decode from the start again at the end */
+#define CS_STREAM_BACK  4       /* reads may also go backwards */
+
 enum {FFT_LIB=0, PFFT_LIB, VDSP_LIB};
 enum {FFT_FWD=0, FFT_INV};
 
@@ -265,6 +294,13 @@ typedef struct CORFIL {
     int     echo;
     MYFLT   limiter;
     float   sr_default, kr_default;
+    int     instrGuard;     /* turn off instances producing NaN/Inf */
+    int     renderJobs;     /* render score sections in parallel */
+    double  renderWarmup;   /* seconds performed before each section */
+    int     writeBuffer;    /* frames queued for background file writes */
+    int     stemJobs;       /* encoder threads for stemout */
+    char    *stemFormat;    /* default stem file format */
+    int     lookAhead;      /* host buffers rendered ahead */
   } OPARMS;
 
   typedef struct arglst {
@@ -312,6 +348,8 @@ typedef struct CORFIL {
     unsigned        int outArgCount;
     char            intype;         /* Type of first input argument (g,k,a,w etc) */
     char            pftype;         /* Type of output argument (k,a etc) */
+    int             (*perf)(CSOUND *, void *); /* specialised perf function,
+                                                  or NULL to use oentry's */
   } TEXT;
 
 
@@ -348,8 +386,17 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    int     steal;                  /* voice stealing mode past maxalloc */
+    MYFLT   stealfade;              /* fade out of a stolen voice, secs */
+    int     stolen;                 /* stolen voices still fading out */
   } INSTRTXT;
 
+  /* voice stealing modes, set with maxalloc */
+#define VOICE_STEAL_NONE      0
+#define VOICE_STEAL_OLDEST    1
+#define VOICE_STEAL_QUIETEST  2
+#define VOICE_STEAL_SAMENOTE  3
+
   typedef struct namedInstr {
     int32        instno;
     char        *name;
@@ -575,7 +622,17 @@ typedef struct CORFIL {
     MYFLT    retval;
     MYFLT   *lclbas;  /* base for variable memory pool */
     char    *strarg;       /* string argument */
-    /* Copy of required p-field values for quick access */
+    /* k-cycle key and back link while queued for turnoff */
+    uint32   offkcnt;
+    struct insds * prvoff;
+    /* voice stealing: activation order, fade out length and start,
+       and output power (last k-cycle, and the one being summed) */
+    uint32   voiceno;
+    uint32   stealcyc;
+    uint64_t stealkcnt, mskcnt;
+    MYFLT    outms, outacc;
+    /* Copy of required p-field values for quick access; p4 and up
+       follow p3 in memory, so nothing may be added after it */
     CS_VAR_MEM  p0;
     CS_VAR_MEM  p1;
     CS_VAR_MEM  p2;
@@ -592,6 +649,21 @@ typedef struct CORFIL {
 #define CS_PDS       (p->h.insdshead->pds)
 #define CS_SPIN      (p->h.insdshead->spin)
 #define CS_SPOUT     (p->h.insdshead->spout)
+
+  /* Zero the samples of an a-rate output outside the sample-accurate
+     window and shorten nsmps to match.  Offsets are only set on an
+     instance's first and last cycles, so on every other cycle this is
+     a single well-predicted test. */
+#define CS_OFFSET_CLEAR(out, offset, early, nsmps)                      \
+  do {                                                                  \
+    if (UNLIKELY((offset) | (early))) {                                 \
+      if (offset) memset(out, '\0', (offset)*sizeof(MYFLT));            \
+      if (early) {                                                      \
+        (nsmps) -= (early);                                             \
+        memset(&(out)[nsmps], '\0', (early)*sizeof(MYFLT));             \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
   typedef int (*SUBR)(CSOUND *, void *);
 
   /**
@@ -685,6 +757,10 @@ typedef struct CORFIL {
     GEN01ARGS gen01args;
     /** table data (flen + 1 MYFLT values) */
     MYFLT   *ftable;
+    /** size (p3) and string arguments the table was made from, so that
+        instances using this one as a template can share it */
+    MYFLT   gensize;
+    char    *genstr;
   } FUNC;
 
   typedef struct {
@@ -769,6 +845,41 @@ typedef struct CORFIL {
     MYFLT       srate;
   } PVOCEX_MEMFILE;
 
+  /**
+   * Sample format conversion and dither (see GetSampleConverters()).
+   * Sample counts are in single samples, not frames.
+   */
+#define CS_DITHER_LANES 8
+  typedef struct {
+    uint32_t seed[CS_DITHER_LANES];   /* one generator per block position */
+    int     type;                     /* 0: none, 1: triangular,
+                                         2: rectangular */
+  } CS_DITHER;
+
+  typedef struct {
+    const char *name;                 /* instruction set, e.g. "avx2" */
+    void (*InitDither)(CS_DITHER *, int type);
+    /* MYFLT (0dbfs = 1) to 16 bit, 24 bit (left justified in 32 bits),
+       32 bit and float; integers are clamped, and the first two are
+       dithered if the CS_DITHER asks for it */
+    void (*ToShort)(int n, const MYFLT *, void *, CS_DITHER *);
+    void (*ToInt24)(int n, const MYFLT *, void *, CS_DITHER *);
+    void (*ToLong)(int n, const MYFLT *, void *, CS_DITHER *);
+    void (*ToFloat)(int n, const MYFLT *, void *, CS_DITHER *);
+    void (*FromShort)(int n, const void *, MYFLT *);
+    void (*FromInt24)(int n, const void *, MYFLT *);
+    void (*FromLong)(int n, const void *, MYFLT *);
+    void (*FromFloat)(int n, const void *, MYFLT *);
+    /* interleaved MYFLT frames to and from one float buffer per channel,
+       starting at frame 'ofs' of the channel buffers */
+    void (*Deinterleave)(int nframes, int nchnls, const MYFLT *,
+                         float **, int ofs);
+    void (*Interleave)(int nframes, int nchnls, float **, int ofs,
+                       MYFLT *);
+    /* adds dither noise of 'lsb' (one step of the target format) */
+    void (*Dither)(int n, MYFLT *, MYFLT lsb, CS_DITHER *);
+  } CS_SAMPCONV;
+
 #ifdef __BUILDING_LIBCSOUND
 
 #define INSTR   1
@@ -823,6 +934,13 @@ typedef struct CORFIL {
     unsigned char mbuf[MBUFSIZ];
     unsigned char *bufp, *endatp;
     int16   datreq, datcnt;
+    /** timestamped messages pushed by the drivers */
+    void    *tsQueue;
+    /** real time of the last two k-cycles that read MIDI */
+    double  tsPrev, tsNow;
+    uint64_t tsKcnt;
+    /** sample offset of the message being parsed */
+    uint32  ksmps_offset;
   } MGLOBAL;
 
   typedef struct eventnode {
@@ -988,6 +1106,7 @@ typedef struct _alloc_data_ {
   MEVENT mep;
   INSDS *ip;
   OPDS *ids;
+  uint32 ksmps_offset;
 } ALLOC_DATA;
 
 #define MAX_MESSAGE_STR 1024
@@ -1404,11 +1523,24 @@ typedef struct _message_queue_t_ {
     MYFLT* (*LPCeps)(CSOUND *, MYFLT *, MYFLT *, int, int);
     MYFLT* (*CepsLP)(CSOUND *, MYFLT *, MYFLT *, int, int);
     MYFLT (*LPrms)(CSOUND *, void *);
+    int (*PushMidiMessage)(CSOUND *, const unsigned char *, int, double);
+    void (*SetPerformDriver)(CSOUND *, void (*)(CSOUND *, void *, int),
+                             void *);
+    int (*PerformDriven)(CSOUND *, int);
+    const CS_SAMPCONV *(*GetSampleConverters)(CSOUND *);
+    void *(*StreamOpen)(CSOUND *, const char *, int, int64_t, int,
+                        int (*)(void *, MYFLT *, int),
+                        int (*)(void *, int64_t), void *, int);
+    int (*StreamRead)(CSOUND *, void *, int64_t, MYFLT *, int);
+    void (*StreamClose)(CSOUND *, void *);
+    void (*CaptureWrite)(CSOUND *, void *, int);
+    int (*CaptureMarker)(CSOUND *, void *, int64_t, const char *);
+    int (*CaptureInfo)(CSOUND *, const char *, void *);
     /**@}*/
     /** @name Placeholders
         To allow the API to grow while maintining backward binary compatibility. */
     /**@{ */
-    SUBR dummyfn_2[23];
+    SUBR dummyfn_2[13];
     /**@}*/
 #ifdef __BUILDING_LIBCSOUND
     /* ------- private data (not to be used by hosts or externals) ------- */
@@ -1680,7 +1812,14 @@ typedef struct _message_queue_t_ {
       int           pipdevin, pipdevout;  /* 0: file, 1: pipe, 2: rtaudio */
       uint32        nframes               /* = 1UL */;
       FILE          *pin, *pout;
-      int           dither;
+      CS_DITHER     dither;
+      const CS_SAMPCONV *conv;
+      int           outconv;              /* format converted by writesf */
+      void          *convbuf;
+      int           convbufsmps;
+      void          *outwr;               /* background writer, or NULL  */
+      MYFLT         *hostinbuf, *hostoutbuf; /* with --look-ahead       */
+      void          *capture;             /* index of a capture output   */
     } libsndStatics;
 
     int           warped;               /* rdscor.c */
@@ -1835,6 +1974,23 @@ typedef struct _message_queue_t_ {
 #ifndef WIN32
     int plain_text_output;
 #endif // !WIN32
+    struct twheel *evtWheel;    /* future OrcTrigEvts, see twheel.h */
+    struct twheel *offWheel;    /* future frstoff entries (time mode) */
+    struct scorebin *scoreBin;  /* binary score being played, scorebin.c */
+    CSOUND        *ftTemplate;    /* instance whose ftables are shared */
+    int           renderArgc;     /* command line, for --render-jobs */
+    const char    **renderArgv;
+    void          (*performDriver)(CSOUND *, void *, int);
+    void          *performDriverData;   /* driver running the k-cycles */
+    void          *driverLock;
+    volatile int  driverDone;
+    int           driverRetval;
+    void          *asyncWriters;  /* sound files written by file_iothread */
+    void          (*kcycleEndFunc)(CSOUND *, void *);
+    void          *kcycleEndData; /* run before spoutran, see stems.c */
+    void          *lookAhead;     /* lookahead.c */
+    volatile long lookAheadGen;   /* score events sent through the API */
+    void          *asyncReaders;  /* streams decoded by file_iothread */
     /*struct CSOUND_ **self;*/
     /**@}*/
 #endif  /* __BUILDING_LIBCSOUND */
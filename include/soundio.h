@@ -98,6 +98,12 @@
 #define TYP_OGG   (SF_FORMAT_OGG >> 16)
 #define TYP_MPC2K (SF_FORMAT_MPC2K >> 16)
 #define TYP_RF64  (SF_FORMAT_RF64 >> 16)
+#define TYP_MPEG  (0x230000 >> 16)      /* SF_FORMAT_MPEG, libsndfile 1.1 */
+#define TYP_CAPTURE (0x7F0000 >> 16)    /* not libsndfile's: see capture.c */
+
+/* formats worth decoding ahead, see csoundStreamOpen() */
+#define TYP_IS_COMPRESSED(x) ((x) == TYP_FLAC || (x) == TYP_OGG ||          \
+                              (x) == TYP_MPEG)
 
 #define FORMAT2SF(x) ((int) (x))
 #define SF2FORMAT(x) ((int) (x) & 0xFFFF)
@@ -108,10 +114,12 @@
 #define sf_write_MYFLT  sf_write_double
 #define sf_writef_MYFLT  sf_writef_double
 #define sf_read_MYFLT   sf_read_double
+#define sf_readf_MYFLT  sf_readf_double
 #else
 #define sf_write_MYFLT  sf_write_float
 #define sf_writef_MYFLT  sf_writef_float
 #define sf_read_MYFLT   sf_read_float
+#define sf_readf_MYFLT  sf_readf_float
 #endif
 
 #ifdef __cplusplus
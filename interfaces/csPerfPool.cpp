@@ -0,0 +1,499 @@
+/*
+    csPerfPool.cpp:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include <algorithm>
+
+#include "csound.h"
+#include "csPerfPool.hpp"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/* k-cycles released up to this early (seconds), as the workers can only
+   sleep with millisecond resolution */
+#define RELEASE_EARLY   0.001
+/* real-time instances this many periods late skip ahead */
+#define MAX_LATE        4
+
+// ----------------------------------------------------------------------------
+
+/**
+ * An instance in the pool.
+ */
+
+class CsPerfPool_Slot {
+ public:
+    CSOUND  *csound;
+    int     handle;
+    bool    realtime;
+    int     slice;
+    double  period;             // seconds performed per slice
+    double  anchor;             // time of first release after Play()
+    long    n;                  // slices since anchor
+    double  release, deadline;
+    int     paused, stopped, busy, queued;
+    int     status;
+    long    misses;
+    void    (*processcallback)(void *cdata);
+    void    *cdata;
+    CsPerfPool_Slot(CSOUND *csound_, int handle_, bool realtime_, int slice_)
+    {
+      csound = csound_;
+      handle = handle_;
+      realtime = realtime_;
+      slice = slice_;
+      period = (double) (slice * csoundGetKsmps(csound)) / csoundGetSr(csound);
+      anchor = release = deadline = 0.0;
+      n = 0;
+      paused = 1;
+      stopped = busy = queued = 0;
+      status = 0;
+      misses = 0;
+      processcallback = 0;
+      cdata = 0;
+    }
+    void Schedule()
+    {
+      release = anchor + (double) n * period;
+      deadline = release + period;
+    }
+};
+
+/* heap orders: std heaps keep the largest element first; ready
+   real-time instances always come before the others, so that a slow
+   instance that is not real-time cannot hold them up, however late
+   its own deadlines are */
+
+static bool laterDeadline(const CsPerfPool_Slot *a, const CsPerfPool_Slot *b)
+{
+    if (a->realtime != b->realtime)
+      return b->realtime;
+    return a->deadline > b->deadline;
+}
+
+static bool laterRelease(const CsPerfPool_Slot *a, const CsPerfPool_Slot *b)
+{
+    return a->release > b->release;
+}
+
+/**
+ * A worker thread.
+ */
+
+class CsPerfPool_Worker {
+ public:
+    CsoundPerformancePool *pool;
+    int     cpu;
+    void    *thread;
+    CsPerfPool_Worker(CsoundPerformancePool *pool_, int cpu_)
+    {
+      pool = pool_;
+      cpu = cpu_;
+      thread = 0;
+    }
+    void Pin()
+    {
+      if (cpu < 0)
+        return;
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+      SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR) 1) << cpu);
+#endif
+    }
+    void Run();
+};
+
+extern "C" {
+  static uintptr_t csoundPerformancePoolWorker_(void *userData)
+  {
+    CsPerfPool_Worker *w = (CsPerfPool_Worker*) userData;
+#ifdef __SSE__
+    _mm_setcsr(_mm_getcsr() | 0x0040);          // denormals are zero
+#endif
+    w->Pin();
+    w->Run();
+    return 0;
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+/* all of the following are called with the pool locked */
+
+double CsoundPerformancePool::Now()
+{
+    return csoundGetRealTime((RTCLOCK*) clock);
+}
+
+CsPerfPool_Slot *CsoundPerformancePool::Find(int handle)
+{
+    for (size_t i = 0; i < slots.size(); i++)
+      if (slots[i]->handle == handle)
+        return slots[i];
+    return (CsPerfPool_Slot*) 0;
+}
+
+/* wakes a worker to look at the heaps again: an idle one, or else the
+   one sleeping until the next release */
+
+void CsoundPerformancePool::Wake()
+{
+    if (nidle)
+      csoundCondSignal(wakeup);
+    else if (timekeeper)
+      csoundCondSignal(tick);
+}
+
+void CsoundPerformancePool::Enqueue(CsPerfPool_Slot *s)
+{
+    s->queued = 1;
+    if (!s->realtime || s->release <= Now() + RELEASE_EARLY) {
+      ready.push_back(s);
+      std::push_heap(ready.begin(), ready.end(), laterDeadline);
+      Wake();
+    }
+    else {
+      waiting.push_back(s);
+      std::push_heap(waiting.begin(), waiting.end(), laterRelease);
+      if (timekeeper)
+        csoundCondSignal(tick);                 // it may be due earlier
+      else if (nidle)
+        csoundCondSignal(wakeup);               // someone has to wait for it
+    }
+}
+
+/* moves instances whose next k-cycle is due to start by 'now' to the
+   ready heap */
+
+void CsoundPerformancePool::Release(double now)
+{
+    int     nready = 0;
+    while (!waiting.empty() && waiting.front()->release <= now) {
+      std::pop_heap(waiting.begin(), waiting.end(), laterRelease);
+      ready.push_back(waiting.back());
+      waiting.pop_back();
+      std::push_heap(ready.begin(), ready.end(), laterDeadline);
+      nready++;
+    }
+    // the caller takes one, idle workers the rest
+    for (nready = std::min(nready - 1, nidle); nready > 0; nready--)
+      csoundCondSignal(wakeup);
+}
+
+/* takes the ready instance with the earliest deadline, dropping paused
+   and finished ones; returns zero if there is none */
+
+int CsoundPerformancePool::Next(CsPerfPool_Slot **sp)
+{
+    while (!ready.empty()) {
+      CsPerfPool_Slot *s;
+      std::pop_heap(ready.begin(), ready.end(), laterDeadline);
+      s = ready.back();
+      ready.pop_back();
+      s->queued = 0;
+      if (s->status)
+        continue;
+      if (s->stopped || !s->paused) {
+        s->busy = 1;
+        *sp = s;
+        return 1;
+      }
+    }
+    *sp = (CsPerfPool_Slot*) 0;
+    return 0;
+}
+
+void CsoundPerformancePool::Finished(CsPerfPool_Slot *s, int retval)
+{
+    s->status = retval;
+    s->busy = 0;
+    csoundCondSignal(done);
+}
+
+// ----------------------------------------------------------------------------
+
+void CsPerfPool_Worker::Run()
+{
+    CsoundPerformancePool *p = pool;
+    CsPerfPool_Slot *s;
+
+    csoundLockMutex(p->lock);
+    while (!p->quit) {
+      p->Release(p->Now() + RELEASE_EARLY);
+      if (p->Next(&s)) {
+        int     retval = 0;
+        double  now;
+        if (s->stopped)
+          retval = 1;
+        csoundUnlockMutex(p->lock);
+        for (int i = 0; i < s->slice && !retval; i++) {
+          if (s->processcallback != NULL)
+            s->processcallback(s->cdata);
+          retval = csoundPerformKsmps(s->csound);
+        }
+        if (retval)
+          csoundCleanup(s->csound);
+        csoundLockMutex(p->lock);
+        now = p->Now();
+        if (!retval && s->stopped) {
+          csoundUnlockMutex(p->lock);
+          csoundCleanup(s->csound);
+          csoundLockMutex(p->lock);
+          retval = 1;
+        }
+        if (retval) {
+          p->Finished(s, retval);
+          continue;
+        }
+        if (s->realtime && now > s->deadline)
+          s->misses++;
+        s->n++;
+        s->Schedule();
+        if (s->realtime && now > s->release + MAX_LATE * s->period) {
+          s->anchor = now;                      // too late: skip ahead
+          s->n = 0;
+          s->Schedule();
+        }
+        s->busy = 0;
+        if (s->paused)
+          csoundCondSignal(p->done);            // Remove() may be waiting
+        else
+          p->Enqueue(s);
+        continue;
+      }
+      if (!p->waiting.empty() && !p->timekeeper) {
+        // wait until the next release, or until woken by a change to
+        // the heaps (Stop(), Remove(), an earlier release); others wait
+        // on 'wakeup'
+        double  gap = p->waiting.front()->release - p->Now();
+        size_t  ms = gap > 0.0 ? (size_t) (gap * 1000.0) : 0;
+        p->timekeeper = 1;
+        csoundCondTimedWait(p->tick, p->lock, ms > 0 ? ms : 1);
+        p->timekeeper = 0;
+        continue;
+      }
+      p->nidle++;
+      csoundCondWait(p->wakeup, p->lock);
+      p->nidle--;
+    }
+    csoundUnlockMutex(p->lock);
+}
+
+// ----------------------------------------------------------------------------
+
+CsoundPerformancePool::CsoundPerformancePool(int nworkers, const int *cpus)
+{
+    RTCLOCK *rt = new RTCLOCK;
+    csoundInitTimerStruct(rt);
+    clock = (void*) rt;
+    quit = 0;
+    nidle = 0;
+    timekeeper = 0;
+    nexthandle = 0;
+    lock = csoundCreateMutex(0);
+    wakeup = csoundCreateCondVar();
+    tick = csoundCreateCondVar();
+    done = csoundCreateCondVar();
+    for (int i = 0; i < nworkers; i++) {
+      CsPerfPool_Worker *w = new CsPerfPool_Worker(this, cpus ? cpus[i] : -1);
+      w->thread = csoundCreateThread(csoundPerformancePoolWorker_, (void*) w);
+      if (!w->thread) {
+        delete w;
+        break;
+      }
+      workers.push_back(w);
+    }
+}
+
+CsoundPerformancePool::~CsoundPerformancePool()
+{
+    csoundLockMutex(lock);
+    quit = 1;
+    for (size_t i = 0; i < workers.size(); i++)
+      csoundCondSignal(wakeup);
+    csoundCondSignal(tick);
+    csoundUnlockMutex(lock);
+    for (size_t i = 0; i < workers.size(); i++) {
+      csoundJoinThread(workers[i]->thread);
+      delete workers[i];
+    }
+    // stop anything still playing, as CsoundPerformanceThread does
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (!slots[i]->status)
+        csoundCleanup(slots[i]->csound);
+      delete slots[i];
+    }
+    csoundDestroyCondVar(done);
+    csoundDestroyCondVar(tick);
+    csoundDestroyCondVar(wakeup);
+    csoundDestroyMutex(lock);
+    delete (RTCLOCK*) clock;
+}
+
+// ----------------------------------------------------------------------------
+
+int CsoundPerformancePool::Add(CSOUND *csound, bool realtime, int slice)
+{
+    int     handle;
+    if (csound == NULL || slice < 1 || workers.empty())
+      return CSOUND_ERROR;
+    csoundLockMutex(lock);
+    handle = nexthandle++;
+    slots.push_back(new CsPerfPool_Slot(csound, handle, realtime, slice));
+    csoundUnlockMutex(lock);
+    return handle;
+}
+
+int CsoundPerformancePool::Remove(int handle)
+{
+    CsPerfPool_Slot *s;
+    int     retval;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) == NULL) {
+      csoundUnlockMutex(lock);
+      return CSOUND_ERROR;
+    }
+    s->paused = 1;
+    while (s->busy)
+      csoundCondWait(done, lock);
+    if (s->queued) {
+      std::vector<CsPerfPool_Slot*>::iterator i;
+      if ((i = std::find(waiting.begin(), waiting.end(), s)) != waiting.end()) {
+        waiting.erase(i);
+        std::make_heap(waiting.begin(), waiting.end(), laterRelease);
+      }
+      else {
+        ready.erase(std::find(ready.begin(), ready.end(), s));
+        std::make_heap(ready.begin(), ready.end(), laterDeadline);
+      }
+    }
+    slots.erase(std::find(slots.begin(), slots.end(), s));
+    if (timekeeper)
+      csoundCondSignal(tick);                   // may have been the next due
+    csoundUnlockMutex(lock);
+    retval = s->status;
+    delete s;
+    return retval;
+}
+
+void CsoundPerformancePool::Play(int handle)
+{
+    CsPerfPool_Slot *s;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL && !s->status && s->paused) {
+      s->paused = 0;
+      if (!s->busy && !s->queued) {
+        s->anchor = Now();
+        s->n = 0;
+        s->Schedule();
+        Enqueue(s);
+      }
+    }
+    csoundUnlockMutex(lock);
+}
+
+void CsoundPerformancePool::Pause(int handle)
+{
+    CsPerfPool_Slot *s;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL)
+      s->paused = 1;
+    csoundUnlockMutex(lock);
+}
+
+void CsoundPerformancePool::Stop(int handle)
+{
+    CsPerfPool_Slot *s;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL && !s->status && !s->stopped) {
+      s->stopped = 1;
+      // a worker finishes it, now if idle or after its current slice
+      if (!s->busy && !s->queued) {
+        s->release = s->deadline = Now();
+        ready.push_back(s);
+        std::push_heap(ready.begin(), ready.end(), laterDeadline);
+        s->queued = 1;
+        Wake();
+      }
+    }
+    csoundUnlockMutex(lock);
+}
+
+int CsoundPerformancePool::GetStatus(int handle)
+{
+    CsPerfPool_Slot *s;
+    int     retval = CSOUND_ERROR;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL)
+      retval = s->status;
+    csoundUnlockMutex(lock);
+    return retval;
+}
+
+long CsoundPerformancePool::GetDeadlineMisses(int handle)
+{
+    CsPerfPool_Slot *s;
+    long    retval = 0;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL)
+      retval = s->misses;
+    csoundUnlockMutex(lock);
+    return retval;
+}
+
+void CsoundPerformancePool::SetProcessCallback(int handle,
+                                               void (*Callback)(void *),
+                                               void *cbdata)
+{
+    CsPerfPool_Slot *s;
+    csoundLockMutex(lock);
+    if ((s = Find(handle)) != NULL) {
+      s->processcallback = Callback;
+      s->cdata = cbdata;
+    }
+    csoundUnlockMutex(lock);
+}
+
+void CsoundPerformancePool::Join()
+{
+    csoundLockMutex(lock);
+    for (;;) {
+      size_t  i;
+      for (i = 0; i < slots.size(); i++)
+        if (!slots[i]->status)
+          break;
+      if (i == slots.size())
+        break;
+      csoundCondWait(done, lock);
+    }
+    csoundUnlockMutex(lock);
+}
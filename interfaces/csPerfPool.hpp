@@ -0,0 +1,142 @@
+/*
+    csPerfPool.hpp:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_CSPERFPOOL_HPP
+#define CSOUND_CSPERFPOOL_HPP
+
+#include <vector>
+
+class CsPerfPool_Slot;
+class CsPerfPool_Worker;
+
+/**
+ * CsoundPerformancePool(int workers, const int *cpus)
+ *
+ * Performs any number of Csound instances on a fixed pool of worker
+ * threads, instead of one CsoundPerformanceThread (and one OS thread)
+ * per instance. Each instance is performed one k-cycle (or 'slice'
+ * k-cycles) at a time; the pool always runs the ready instance with the
+ * earliest deadline next, so every instance gets its share of the
+ * workers and none can starve the others.
+ *
+ * Real-time instances are paced by the wall clock: k-cycle n is released
+ * n * ksmps / sr seconds after Play() and is due one k-cycle later.
+ * Missed deadlines are counted (GetDeadlineMisses()); an instance that
+ * falls far behind skips ahead instead of trying to catch up. Instances
+ * added with realtime = false run as fast as the workers allow, in the
+ * time left over by the real-time ones: a ready real-time instance is
+ * always performed first.
+ *
+ * Instances are expected to be compiled and started (csoundStart()),
+ * and not to block in csoundPerformKsmps(): use -n or host-side I/O
+ * (spin/spout, channels, the process callback) rather than a real-time
+ * audio device, which would stall a worker. Score events and channel
+ * values can be sent with the thread-safe Csound API functions at any
+ * time. As with CsoundPerformanceThread, instances start paused, and
+ * csoundCleanup() is called when one finishes.
+ *
+ * If cpus is not NULL, worker i is pinned to CPU cpus[i] where the
+ * platform supports it.
+ */
+
+class PUBLIC CsoundPerformancePool {
+ private:
+    std::vector<CsPerfPool_Slot*>   slots;
+    std::vector<CsPerfPool_Worker*> workers;
+    std::vector<CsPerfPool_Slot*>   ready;    // heap, earliest deadline
+    std::vector<CsPerfPool_Slot*>   waiting;  // heap, earliest release
+    void    *lock;
+    void    *wakeup;            // workers idle with nothing to run
+    void    *tick;              // the timekeeper, until the next release
+    void    *done;              // an instance finished or left a worker
+    void    *clock;
+    int     quit;
+    int     nidle;              // workers waiting on 'wakeup'
+    int     timekeeper;         // a worker is sleeping until a release
+    int     nexthandle;
+    int     Next(CsPerfPool_Slot **);
+    void    Release(double);
+    void    Finished(CsPerfPool_Slot *, int);
+    void    Enqueue(CsPerfPool_Slot *);
+    void    Wake();
+    double  Now();
+    CsPerfPool_Slot *Find(int);
+ public:
+    /**
+     * Adds a Csound instance to the pool, paused, and returns its
+     * handle (non-negative), or a negative value on error. If realtime
+     * is true the instance is paced to its sample rate, otherwise it
+     * runs as fast as possible. 'slice' is the number of k-cycles
+     * performed each time the instance is scheduled.
+     */
+    int Add(CSOUND *csound, bool realtime = true, int slice = 1);
+    /**
+     * Waits until the instance is not being performed, then removes it
+     * from the pool and returns its status (see GetStatus()). The Csound
+     * instance itself is not destroyed.
+     */
+    int Remove(int handle);
+    /**
+     * Continues performance of the instance if it was paused.
+     */
+    void Play(int handle);
+    /**
+     * Pauses performance of the instance (can be continued by Play()).
+     */
+    void Pause(int handle);
+    /**
+     * Stops performance of the instance (cannot be continued).
+     */
+    void Stop(int handle);
+    /**
+     * Returns the status of the instance: zero if still playing,
+     * positive if the end of score was reached or performance was
+     * stopped, and negative if an error occured.
+     */
+    int GetStatus(int handle);
+    /**
+     * Returns the number of k-cycles of a real-time instance that were
+     * finished after their deadline.
+     */
+    long GetDeadlineMisses(int handle);
+    /**
+     * Sets a function called by the worker before each k-cycle of the
+     * instance.
+     */
+    void SetProcessCallback(int handle, void (*Callback)(void *),
+                            void *cbdata);
+    /**
+     * Waits until every instance in the pool has finished or failed.
+     * Join() and Remove() should be called from one host thread.
+     */
+    void Join();
+    /**
+     * Returns the number of worker threads.
+     */
+    int GetWorkers() { return (int) workers.size(); }
+    // --------
+    CsoundPerformancePool(int nworkers, const int *cpus = 0);
+    ~CsoundPerformancePool();
+    // --------
+    friend class CsPerfPool_Worker;
+};
+
+#endif  // CSOUND_CSPERFPOOL_HPP
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <exception>
+#include <atomic>
 
 #include "csound.hpp"
 #include "csPerfThread.hpp"
@@ -281,6 +282,32 @@ class CsPerfThreadMsg_Stop : public CsoundPerformanceThreadMessage {
     ~CsPerfThreadMsg_Stop() {}
 };
 
+/**
+ * Sends a score event to Csound, adjusting p2 and p3 first if the start
+ * time is absolute. Used by both the queued and the lock-free path.
+ */
+
+static void perfThreadScoreEvent(CSOUND *csound, int absp2mode, char opcod,
+                                 int pcnt, MYFLT *pp)
+{
+    if (absp2mode && pcnt > 1) {
+      double  p2 = (double) pp[1] - csoundGetScoreTime(csound);
+      if (p2 < 0.0) {
+        if (pcnt > 2 && pp[2] >= (MYFLT) 0 &&
+            (opcod == 'a' || opcod == 'i')) {
+          pp[2] = (MYFLT) ((double) pp[2] + p2);
+          if (pp[2] <= (MYFLT) 0)
+            return;
+        }
+        p2 = 0.0;
+      }
+      pp[1] = (MYFLT) p2;
+    }
+    if (csoundScoreEvent(csound, opcod, pp, (long) pcnt) != 0)
+      csoundMessageS(csound, CSOUNDMSG_WARNING,
+                     "WARNING: could not create score event\n");
+}
+
 /**
  * Score event message
  *
@@ -298,12 +325,15 @@ class CsPerfThreadMsg_ScoreEvent : public CsoundPerformanceThreadMessage {
     int     pcnt;
     MYFLT   *pp;
     MYFLT   p[10];
+    std::atomic<int> *spilled;
  public:
     CsPerfThreadMsg_ScoreEvent(CsoundPerformanceThread *pt,
                                int absp2mode, char opcod,
-                               int pcnt, const MYFLT *p)
+                               int pcnt, const MYFLT *p,
+                               std::atomic<int> *spilled)
     : CsoundPerformanceThreadMessage(pt)
     {
+      this->spilled = spilled;
       this->opcod = opcod;
       this->absp2mode = absp2mode;
       this->pcnt = pcnt;
@@ -315,27 +345,12 @@ class CsPerfThreadMsg_ScoreEvent : public CsoundPerformanceThreadMessage {
         this->pp[i] = p[i];
     }
     int run() {
-      CSOUND  *csound = pt_->GetCsound();
-      if (absp2mode && pcnt > 1) {
-        double  p2 = (double) pp[1] - csoundGetScoreTime(csound);
-        if (p2 < 0.0) {
-          if (pcnt > 2 && pp[2] >= (MYFLT) 0 &&
-              (opcod == 'a' || opcod == 'i')) {
-            pp[2] = (MYFLT) ((double) pp[2] + p2);
-            if (pp[2] <= (MYFLT) 0)
-              return 0;
-          }
-          p2 = 0.0;
-        }
-        pp[1] = (MYFLT) p2;
-      }
-      if (csoundScoreEvent(csound, opcod, pp, (long) pcnt) != 0)
-        csoundMessageS(csound, CSOUNDMSG_WARNING,
-                       "WARNING: could not create score event\n");
+      perfThreadScoreEvent(pt_->GetCsound(), absp2mode, opcod, pcnt, pp);
       return 0;
     }
     ~CsPerfThreadMsg_ScoreEvent()
     {
+      spilled->fetch_sub(1, std::memory_order_release);
       if (pcnt > 10)
         delete[] pp;
     }
@@ -350,10 +365,13 @@ class CsPerfThreadMsg_InputMessage : public CsoundPerformanceThreadMessage {
     int     len;
     char    *sp;
     char    s[128];
+    std::atomic<int> *spilled;
  public:
-    CsPerfThreadMsg_InputMessage(CsoundPerformanceThread *pt, const char *s)
+    CsPerfThreadMsg_InputMessage(CsoundPerformanceThread *pt, const char *s,
+                                 std::atomic<int> *spilled)
     : CsoundPerformanceThreadMessage(pt)
     {
+      this->spilled = spilled;
       len = (int) strlen(s);
       if (len < 128)
         this->sp = &(this->s[0]);
@@ -368,6 +386,7 @@ class CsPerfThreadMsg_InputMessage : public CsoundPerformanceThreadMessage {
     }
     ~CsPerfThreadMsg_InputMessage()
     {
+      spilled->fetch_sub(1, std::memory_order_release);
       if (len >= 128)
         delete[] sp;
     }
@@ -396,6 +415,134 @@ public:
     ~CsPerfThreadMsg_SetScoreOffsetSeconds() {}
 };
 
+/**
+ * Does nothing: queued by FlushMessageQueue() to wake up a paused
+ * performance thread, which then empties the lock-free queue.
+ */
+
+class CsPerfThreadMsg_Flush : public CsoundPerformanceThreadMessage {
+ public:
+    CsPerfThreadMsg_Flush(CsoundPerformanceThread *pt)
+    : CsoundPerformanceThreadMessage(pt) {}
+    int run()
+    {
+      return 0;
+    }
+    ~CsPerfThreadMsg_Flush() {}
+};
+
+// ----------------------------------------------------------------------------
+
+/**
+ * Lock-free queue of score events and input messages, from any number
+ * of control threads to the performance thread. The commands are stored
+ * inline in preallocated slots, so sending one does not allocate memory
+ * or take a lock. Each slot has a sequence number telling whether it is
+ * free for the producer at position pos (seq == pos) or filled for the
+ * consumer (seq == pos + 1).
+ * Commands that do not fit, or find the queue full, are sent as messages
+ * instead; 'spilled' counts those not yet run, and while it is non-zero
+ * all commands are sent that way, so that they run in the order sent.
+ */
+
+#define CMDQ_SIZE       512             /* must be a power of two */
+#define CMDQ_PFIELDS    32
+#define CMDQ_STRLEN     256
+
+enum { CMD_SCORE_EVENT, CMD_INPUT_MESSAGE };
+
+struct CsPerfThread_Cmd {
+    std::atomic<size_t> seq;
+    int     type;
+    int     absp2mode;
+    char    opcod;
+    int     pcnt;
+    union {
+      MYFLT   p[CMDQ_PFIELDS];
+      char    s[CMDQ_STRLEN];
+    } u;
+};
+
+class CsPerfThread_CmdQueue {
+ private:
+    CsPerfThread_Cmd    cmd[CMDQ_SIZE];
+    std::atomic<size_t> head;           // next slot to fill
+    std::atomic<size_t> tail;           // next slot to run
+ public:
+    std::atomic<int>    spilled;        // commands sent as messages
+    CsPerfThread_CmdQueue()
+    {
+      for (size_t i = 0; i < CMDQ_SIZE; i++)
+        cmd[i].seq.store(i, std::memory_order_relaxed);
+      head.store(0, std::memory_order_relaxed);
+      tail.store(0, std::memory_order_relaxed);
+      spilled.store(0, std::memory_order_relaxed);
+    }
+    /* claims a free slot, or returns NULL if the queue is full */
+    CsPerfThread_Cmd *Claim(size_t *posp)
+    {
+      size_t  pos = head.load(std::memory_order_relaxed);
+      for (;;) {
+        CsPerfThread_Cmd *c = &cmd[pos & (CMDQ_SIZE - 1)];
+        size_t  seq = c->seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+        if (dif == 0) {
+          if (head.compare_exchange_weak(pos, pos + 1,
+                                         std::memory_order_relaxed))
+            break;
+        }
+        else if (dif < 0)
+          return (CsPerfThread_Cmd*) 0;
+        else
+          pos = head.load(std::memory_order_relaxed);
+      }
+      *posp = pos;
+      return &cmd[pos & (CMDQ_SIZE - 1)];
+    }
+    /* hands a filled slot to the consumer */
+    void Publish(CsPerfThread_Cmd *c, size_t pos)
+    {
+      c->seq.store(pos + 1, std::memory_order_release);
+    }
+    /* performance thread only: the oldest filled slot, or NULL */
+    CsPerfThread_Cmd *Front()
+    {
+      size_t  pos = tail.load(std::memory_order_relaxed);
+      CsPerfThread_Cmd *c = &cmd[pos & (CMDQ_SIZE - 1)];
+      if (c->seq.load(std::memory_order_acquire) != pos + 1)
+        return (CsPerfThread_Cmd*) 0;
+      return c;
+    }
+    void Pop(CsPerfThread_Cmd *c)
+    {
+      size_t  pos = tail.load(std::memory_order_relaxed);
+      c->seq.store(pos + CMDQ_SIZE, std::memory_order_release);
+      tail.store(pos + 1, std::memory_order_release);
+    }
+    /* any thread: whether every command sent has been run */
+    bool Empty()
+    {
+      return (head.load(std::memory_order_acquire) == tail);
+    }
+};
+
+/**
+ * Runs the commands sent through the lock-free queue. Called from the
+ * performance thread only.
+ */
+
+void CsoundPerformanceThread::RunCommands()
+{
+    CsPerfThread_Cmd *c;
+    while ((c = cmdQueue->Front()) != NULL) {
+      if (c->type == CMD_SCORE_EVENT)
+        perfThreadScoreEvent(csound, c->absp2mode, c->opcod, c->pcnt, c->u.p);
+      else
+        csoundInputMessage(csound, c->u.s);
+      cmdQueue->Pop(c);
+    }
+}
+
 // ----------------------------------------------------------------------------
 
 /**
@@ -409,6 +556,7 @@ int CsoundPerformanceThread::Perform()
     do {
       while (firstMessage) {
         csoundLockMutex(queueLock);
+        RunCommands();
         do {
           CsoundPerformanceThreadMessage *msg;
           // get oldest message
@@ -439,6 +587,7 @@ int CsoundPerformanceThread::Perform()
         csoundWaitThreadLockNoTimeout(pauseLock);
         csoundNotifyThreadLock(pauseLock);
       }
+      RunCommands();
       if(processcallback != NULL)
            processcallback(cdata);
       retval = csoundPerformKsmps(csound);
@@ -523,6 +672,7 @@ void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
     flushLock = (void*) 0;
     recordLock = (void *) 0;
     perfThread = (void*) 0;
+    cmdQueue = (CsPerfThread_CmdQueue*) 0;
     paused = 1;
     status = CSOUND_MEMORY;
     cdata = 0;
@@ -541,6 +691,7 @@ void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
     if (!recordLock)
       return;
     try {
+      cmdQueue = new CsPerfThread_CmdQueue;
       lastMessage = new CsPerfThreadMsg_Pause(this);
     }
     catch (std::bad_alloc&) {
@@ -612,6 +763,7 @@ CsoundPerformanceThread::~CsoundPerformanceThread()
     if (recordData.condvar) {
         csoundDestroyCondVar(recordData.condvar);
     }
+    delete cmdQueue;
 }
 
 // ----------------------------------------------------------------------------
@@ -669,16 +821,50 @@ void CsoundPerformanceThread::StopRecord()
     QueueMessage(new CsPerfThreadMsg_StopRecord(this));
 }
 
-void CsoundPerformanceThread::ScoreEvent(int absp2mode, char opcod,
-                                         int pcnt, const MYFLT *p)
+int CsoundPerformanceThread::ScoreEvent(int absp2mode, char opcod,
+                                        int pcnt, const MYFLT *p)
 {
-    QueueMessage(new CsPerfThreadMsg_ScoreEvent(this,
-                                                absp2mode, opcod, pcnt, p));
+    CsPerfThread_Cmd *c;
+    size_t  pos;
+    if (status || !cmdQueue)
+      return CSOUND_ERROR;
+    if (pcnt > CMDQ_PFIELDS ||                  // too big, full, or behind
+        cmdQueue->spilled.load(std::memory_order_acquire) > 0 ||
+        (c = cmdQueue->Claim(&pos)) == NULL) {  // earlier ones: use the lock
+      cmdQueue->spilled.fetch_add(1, std::memory_order_acq_rel);
+      QueueMessage(new CsPerfThreadMsg_ScoreEvent(this, absp2mode, opcod,
+                                                  pcnt, p,
+                                                  &cmdQueue->spilled));
+      return 0;
+    }
+    c->type = CMD_SCORE_EVENT;
+    c->absp2mode = absp2mode;
+    c->opcod = opcod;
+    c->pcnt = pcnt;
+    for (int i = 0; i < pcnt; i++)
+      c->u.p[i] = p[i];
+    cmdQueue->Publish(c, pos);
+    return 0;
 }
 
-void CsoundPerformanceThread::InputMessage(const char *s)
+int CsoundPerformanceThread::InputMessage(const char *s)
 {
-    QueueMessage(new CsPerfThreadMsg_InputMessage(this, s));
+    CsPerfThread_Cmd *c;
+    size_t  pos, len = strlen(s);
+    if (status || !cmdQueue)
+      return CSOUND_ERROR;
+    if (len >= CMDQ_STRLEN ||
+        cmdQueue->spilled.load(std::memory_order_acquire) > 0 ||
+        (c = cmdQueue->Claim(&pos)) == NULL) {
+      cmdQueue->spilled.fetch_add(1, std::memory_order_acq_rel);
+      QueueMessage(new CsPerfThreadMsg_InputMessage(this, s,
+                                                    &cmdQueue->spilled));
+      return 0;
+    }
+    c->type = CMD_INPUT_MESSAGE;
+    memcpy(c->u.s, s, len + 1);
+    cmdQueue->Publish(c, pos);
+    return 0;
 }
 
 void CsoundPerformanceThread::SetScoreOffsetSeconds(double timeVal)
@@ -740,6 +926,8 @@ int CsoundPerformanceThread::Join()
 
 void CsoundPerformanceThread::FlushMessageQueue()
 {
+    if (cmdQueue && !cmdQueue->Empty() && !status)
+      QueueMessage(new CsPerfThreadMsg_Flush(this));
     if (firstMessage) {
       csoundWaitThreadLockNoTimeout(flushLock);
       csoundNotifyThreadLock(flushLock);
@@ -843,16 +1031,16 @@ PUBLIK void CsoundPTstopRecord(Cpt pt)
   cpt->StopRecord();
 }
 
-PUBLIK void CsoundPTscoreEvent(Cpt pt, int absp2mode, char opcod, int pcnt, MYFLT *p)
+PUBLIK int CsoundPTscoreEvent(Cpt pt, int absp2mode, char opcod, int pcnt, MYFLT *p)
 {
   CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
-  cpt->ScoreEvent(absp2mode, opcod, pcnt, p);
+  return cpt->ScoreEvent(absp2mode, opcod, pcnt, p);
 }
 
-PUBLIK void CsoundPTinputMessage(Cpt pt, const char *s)
+PUBLIK int CsoundPTinputMessage(Cpt pt, const char *s)
 {
   CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
-  cpt->InputMessage(s);
+  return cpt->InputMessage(s);
 }
 
 PUBLIK void CsoundPTsetScoreOffsetSeconds(Cpt pt, double timeVal)
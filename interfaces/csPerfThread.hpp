@@ -26,6 +26,7 @@
 
 class CsoundPerformanceThreadMessage;
 class CsPerfThread_PerformScore;
+class CsPerfThread_CmdQueue;
 
 #ifdef SWIG
 %include <std_string.i>
@@ -126,6 +127,7 @@ class PUBLIC CsoundPerformanceThread {
     void    *flushLock;
     void    *recordLock;
     void    *perfThread;
+    CsPerfThread_CmdQueue *cmdQueue;   // lock-free score events
     int     paused;
     int     status;
     void    *cdata;
@@ -135,6 +137,7 @@ class PUBLIC CsoundPerformanceThread {
     int  Perform();
     void csPerfThread_constructor(CSOUND *);
     void QueueMessage(CsoundPerformanceThreadMessage *);
+    void RunCommands();
  public:
 #ifdef SWIGPYTHON
   PyThreadState *_tstate;
@@ -204,12 +207,22 @@ class PUBLIC CsoundPerformanceThread {
      * 'pcnt' p-fields in array 'p' (p[0] is p1). If absp2mode is non-zero,
      * the start time of the event is measured from the beginning of
      * performance, instead of the default of relative to the current time.
+     * Events of up to 32 p-fields go through a preallocated lock-free
+     * queue that the performance thread empties at the start of every
+     * k-cycle, so the caller never waits for, or blocks, the performance
+     * thread; they may be received before Play/Pause/Stop messages sent
+     * earlier. Larger events, and events sent while the queue is full,
+     * are queued with a lock as before; events are always received in
+     * the order sent. Returns zero on success, or non-zero if performance
+     * has finished.
      */
-    void ScoreEvent(int absp2mode, char opcod, int pcnt, const MYFLT *p);
+    int ScoreEvent(int absp2mode, char opcod, int pcnt, const MYFLT *p);
     /**
      * Sends a score event as a string, similarly to line events (-L).
+     * Strings shorter than 256 characters use the same lock-free queue as
+     * ScoreEvent(), and the return value is as for ScoreEvent().
      */
-    void InputMessage(const char *s);
+    int InputMessage(const char *s);
     /**
      * Sets the playback time pointer to the specified value (in seconds).
      */
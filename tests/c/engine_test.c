@@ -1,5 +1,6 @@
 #include "csound.h"
 #include <stdio.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 
 #include "time.h"
@@ -54,6 +55,476 @@ void test_compile_async(void)
     csoundDestroy(csound);
 }
 
+void test_score_event_strings(void)
+{
+    CSOUND  *csound;
+    MYFLT   pfields[6] = { 1, 0, 1, 0, 42, 0 };
+    const char *strfields[6] = { NULL, NULL, NULL, "hello", NULL, "world" };
+    /* a named instrument: a string p1 */
+    const char *named[4] = { "Named", NULL, NULL, "there" };
+    char    buf[64];
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, "instr 1\n"
+                             "Sa strget p4\n"
+                             "Sb strget p6\n"
+                             "chnset Sa, \"a\"\n"
+                             "chnset Sb, \"b\"\n"
+                             "chnset p5, \"n\"\n"
+                             "endin\n"
+                             "instr Named\n"
+                             "Sc strget p4\n"
+                             "chnset Sc, \"c\"\n"
+                             "chnset p3, \"dur\"\n"
+                             "endin\n");
+    csoundStart(csound);
+    CU_ASSERT_EQUAL(csoundScoreEventStrings(csound, 'i', pfields,
+                                            strfields, 6), 0);
+    csoundPerformKsmps(csound);
+    csoundPerformKsmps(csound);
+    csoundGetStringChannel(csound, "a", buf);
+    CU_ASSERT_STRING_EQUAL(buf, "hello");
+    csoundGetStringChannel(csound, "b", buf);
+    CU_ASSERT_STRING_EQUAL(buf, "world");
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n", NULL), 42.0);
+    CU_ASSERT_EQUAL(csoundScoreEventStrings(csound, 'i', pfields,
+                                            named, 4), 0);
+    csoundPerformKsmps(csound);
+    csoundPerformKsmps(csound);
+    csoundGetStringChannel(csound, "c", buf);
+    CU_ASSERT_STRING_EQUAL(buf, "there");
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "dur", NULL), 1.0);
+    csoundDestroy(csound);
+}
+
+void test_template_source_gen(void)
+{
+    CSOUND  *tmpl, *csound;
+    MYFLT   *t2, *c2, *t3, *c3;
+    /* table 2 is made from table 1, which differs between the two;
+       table 3 is the same in both */
+    const char *orc = "gi2 ftgen 2, 0, 1024, 30, 1, 1, 2\n"
+                      "gi3 ftgen 3, 0, 1024, 10, 1\n";
+    tmpl = csoundCreate(NULL);
+    csoundSetOption(tmpl, "-n");
+    csoundCompileOrc(tmpl, "gi1 ftgen 1, 0, 1024, 10, 1\n");
+    csoundCompileOrc(tmpl, orc);
+    csoundStart(tmpl);
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    CU_ASSERT_EQUAL(csoundSetTemplate(csound, tmpl), 0);
+    csoundCompileOrc(csound, "gi1 ftgen 1, 0, 1024, 10, 0, 1\n");
+    csoundCompileOrc(csound, orc);
+    csoundStart(csound);
+    CU_ASSERT_EQUAL(csoundGetTable(tmpl, &t2, 2), 1024);
+    CU_ASSERT_EQUAL(csoundGetTable(csound, &c2, 2), 1024);
+    CU_ASSERT(t2 != c2);
+    /* a quarter of the way in: 1 for the first harmonic, 0 for the second */
+    CU_ASSERT(t2[256] > 0.9 && c2[256] < 0.1 && c2[256] > -0.1);
+    /* the matching GEN10 table is the template's own */
+    CU_ASSERT_EQUAL(csoundGetTable(tmpl, &t3, 3), 1024);
+    CU_ASSERT_EQUAL(csoundGetTable(csound, &c3, 3), 1024);
+    CU_ASSERT(t3 == c3);
+    csoundDestroy(csound);
+    csoundDestroy(tmpl);
+}
+
+/* host MIDI input for test_voice_stealing: the bytes of one message */
+static const unsigned char *midi_bytes;
+static int midi_nbytes;
+
+static int midi_in_open(CSOUND *csound, void **userData, const char *dev)
+{
+    (void) csound; (void) dev;
+    *userData = NULL;
+    return 0;
+}
+
+static int midi_read(CSOUND *csound, void *userData,
+                     unsigned char *buf, int nbytes)
+{
+    int n = midi_nbytes < nbytes ? midi_nbytes : nbytes;
+    (void) csound; (void) userData;
+    memcpy(buf, midi_bytes, n);
+    midi_bytes += n;
+    midi_nbytes -= n;
+    return n;
+}
+
+static void play_note(CSOUND *csound, int note, int vel, int kcycles)
+{
+    unsigned char msg[3];
+    msg[0] = 0x90; msg[1] = (unsigned char) note; msg[2] = (unsigned char) vel;
+    midi_bytes = msg;
+    midi_nbytes = 3;
+    while (kcycles--)
+      csoundPerformKsmps(csound);
+    midi_nbytes = 0;
+}
+
+/* Three notes into an instrument with two voices: returns the velocity
+   still sounding on notes 60, 62 and 64 after the stolen voice has
+   faded out.  Instr 1 runs at a local ksmps, so the fade counts local
+   k-cycles. */
+
+static void steal_notes(int steal, int note3, MYFLT *vel)
+{
+    CSOUND  *csound;
+    char    orc[512];
+    snprintf(orc, sizeof(orc),
+             "sr = 44100\n"
+             "ksmps = 64\n"
+             "nchnls = 1\n"
+             "0dbfs = 1\n"
+             "gkvel[] init 128\n"
+             "maxalloc 1, 2, %d, 0.01\n"
+             "instr 1\n"
+             "setksmps 16\n"
+             "inote notnum\n"
+             "ivel veloc\n"
+             "kvel = ivel\n"
+             "gkvel[inote] = kvel\n"
+             "out oscili(kvel/127, 440)\n"
+             "endin\n"
+             "instr 2\n"
+             "chnset gkvel[60], \"v60\"\n"
+             "chnset gkvel[62], \"v62\"\n"
+             "chnset gkvel[64], \"v64\"\n"
+             "gkvel[60] = 0\n"
+             "gkvel[62] = 0\n"
+             "gkvel[64] = 0\n"
+             "endin\n"
+             "schedule 2, 0, -1\n", steal);
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-M0");
+    csoundSetHostImplementedMIDIIO(csound, 1);
+    csoundSetExternalMidiInOpenCallback(csound, midi_in_open);
+    csoundSetExternalMidiReadCallback(csound, midi_read);
+    csoundSetExternalMidiInCloseCallback(csound, NULL);
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, orc), 0);
+    csoundStart(csound);
+    play_note(csound, 60, 127, 4);
+    play_note(csound, 62, 10, 4);
+    play_note(csound, note3, 100, 20);
+    vel[0] = csoundGetControlChannel(csound, "v60", NULL);
+    vel[1] = csoundGetControlChannel(csound, "v62", NULL);
+    vel[2] = csoundGetControlChannel(csound, "v64", NULL);
+    csoundDestroy(csound);
+}
+
+void test_voice_stealing(void)
+{
+    MYFLT vel[3];
+    steal_notes(0, 64, vel);            /* no stealing: 64 is refused */
+    CU_ASSERT(vel[0] == 127 && vel[1] == 10 && vel[2] == 0);
+    steal_notes(1, 64, vel);            /* the oldest voice, 60 */
+    CU_ASSERT(vel[0] == 0 && vel[1] == 10 && vel[2] == 100);
+    steal_notes(2, 64, vel);            /* the quietest voice, 62 */
+    CU_ASSERT(vel[0] == 127 && vel[1] == 0 && vel[2] == 100);
+    steal_notes(3, 62, vel);            /* the voice playing 62 */
+    CU_ASSERT(vel[0] == 127 && vel[1] == 100 && vel[2] == 0);
+}
+
+/* A ramp mixed into a stem by an instrument at a local ksmps is read
+   back sample for sample, so every sub-cycle lands in its own place. */
+
+void test_stem_render(void)
+{
+    CSOUND  *csound;
+    int     i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 44100\n"
+                             "ksmps = 64\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "setksmps 16\n"
+                             "a1 linseg 0, 1, 1\n"
+                             "stemout \"stem_test.wav\", a1\n"
+                             "endin\n"
+                             "schedule 1, 0, 1\n");
+    csoundStart(csound);
+    for (i = 0; i < 400; i++)
+      csoundPerformKsmps(csound);
+    csoundDestroy(csound);
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 44100\n"
+                             "ksmps = 64\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "gkerr init 0\n"
+                             "instr 1\n"
+                             "a1 diskin2 \"stem_test.wav\"\n"
+                             "aref linseg 0, 1, 1\n"
+                             "kerr max_k a1 - aref, 1, 1\n"
+                             "gkerr = max(gkerr, kerr)\n"
+                             "chnset gkerr, \"err\"\n"
+                             "endin\n"
+                             "schedule 1, 0, 1\n");
+    csoundStart(csound);
+    for (i = 0; i < 300; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT(csoundGetControlChannel(csound, "err", NULL) < 0.001);
+    csoundDestroy(csound);
+    remove("stem_test.wav");
+}
+
+/* With --look-ahead, a score event sent between two buffers is heard
+   in the next one, not after the buffers already rendered. */
+
+void test_look_ahead(void)
+{
+    CSOUND  *csound;
+    MYFLT   *out;
+    MYFLT   pfields[3] = { 1, 0, 1 };
+    int     i, n;
+    csound = csoundCreate(NULL);
+    csoundSetHostImplementedAudioIO(csound, 1, 256);
+    csoundSetOption(csound, "-odac");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "--look-ahead=4");
+    csoundCompileOrc(csound, "sr = 44100\n"
+                             "ksmps = 32\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "a1 linseg 0.5, 1, 0.5\n"
+                             "out a1\n"
+                             "endin\n");
+    csoundStart(csound);
+    out = csoundGetOutputBuffer(csound);
+    n = csoundGetOutputBufferSize(csound);
+    for (i = 0; i < 8; i++)
+      csoundPerformBuffer(csound);
+    CU_ASSERT_EQUAL(out[n - 1], 0.0);
+    csoundSleep(100);                   /* the next 4 buffers are ready */
+    CU_ASSERT_EQUAL(csoundScoreEvent(csound, 'i', pfields, 3), 0);
+    csoundPerformBuffer(csound);
+    /* crossfaded in from the dropped buffer, so full at the end */
+    CU_ASSERT(out[n - 1] > 0.4);
+    csoundPerformBuffer(csound);
+    CU_ASSERT(out[0] > 0.49);
+    csoundDestroy(csound);
+}
+
+/* A text score sorted to a binary score with csoundScoreSortBinary()
+   plays back with its numbers and strings. */
+
+void test_score_binary(void)
+{
+    CSOUND  *csound;
+    FILE    *f, *out;
+    char    buf[64];
+    const char *argv[] = { "csound", "-n", "-d",
+                           "scorebin_test.orc", "scorebin_test.bsc" };
+    f = fopen("scorebin_test.sco", "w");
+    fputs("i1 0 0.1 42 \"hello\" \"world\"\n"
+          "i1 0.2 0.1 43 \"a\" \"c\"\n", f);
+    fclose(f);
+    f = fopen("scorebin_test.orc", "w");
+    fputs("instr 1\n"
+          "Sa strget p5\n"
+          "Sb strget p6\n"
+          "chnset Sa, \"a\"\n"
+          "chnset Sb, \"b\"\n"
+          "chnset p4, \"n\"\n"
+          "endin\n", f);
+    fclose(f);
+    f = fopen("scorebin_test.sco", "r");
+    out = fopen("scorebin_test.bsc", "wb");
+    csound = csoundCreate(NULL);
+    CU_ASSERT_EQUAL(csoundScoreSortBinary(csound, f, out), 0);
+    csoundDestroy(csound);
+    fclose(f);
+    fclose(out);
+    csound = csoundCreate(NULL);
+    CU_ASSERT_EQUAL(csoundCompile(csound, 5, argv), 0);
+    while (csoundPerformKsmps(csound) == 0) {
+      if (csoundGetControlChannel(csound, "n", NULL) == 42.0) {
+        csoundGetStringChannel(csound, "a", buf);
+        CU_ASSERT_STRING_EQUAL(buf, "hello");
+        csoundGetStringChannel(csound, "b", buf);
+        CU_ASSERT_STRING_EQUAL(buf, "world");
+      }
+    }
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n", NULL), 43.0);
+    csoundGetStringChannel(csound, "a", buf);
+    CU_ASSERT_STRING_EQUAL(buf, "a");
+    csoundGetStringChannel(csound, "b", buf);
+    CU_ASSERT_STRING_EQUAL(buf, "c");
+    csoundDestroy(csound);
+    remove("scorebin_test.sco");
+    remove("scorebin_test.orc");
+    remove("scorebin_test.bsc");
+}
+
+static void perform_until(CSOUND *csound, double t)
+{
+    while (csoundGetScoreTime(csound) < t)
+      if (csoundPerformKsmps(csound) != 0)
+        break;
+}
+
+/* Events and turnoffs due more than one revolution of the timing wheels
+   ahead (2^18 k-cycles, 262 seconds here) wait in their overflow lists;
+   they fire on time, and a turnoff taken out of the middle of the list
+   by turnoff2 leaves the others in place. */
+
+void test_timing_wheel_overflow(void)
+{
+    CSOUND  *csound;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 1000\n"
+                             "ksmps = 1\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "endin\n"
+                             "instr 2\n"
+                             "turnoff2 1.2, 4, 0\n"
+                             "endin\n"
+                             "instr 3\n"
+                             "chnset times:i(), \"fired\"\n"
+                             "endin\n"
+                             "instr 4\n"
+                             "chnset active:k(1), \"n1\"\n"
+                             "endin\n"
+                             "schedule 1.1, 0, 300\n"
+                             "schedule 1.2, 0, 301\n"
+                             "schedule 1.3, 0, 302\n"
+                             "schedule 2, 1, 0.01\n"
+                             "schedule 3, 280, 0.1\n"
+                             "schedule 4, 0, -1\n");
+    csoundStart(csound);
+    perform_until(csound, 0.5);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n1", NULL), 3.0);
+    perform_until(csound, 2.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n1", NULL), 2.0);
+    perform_until(csound, 281.0);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "fired", NULL),
+                           280.0, 0.01);
+    perform_until(csound, 300.5);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n1", NULL), 1.0);
+    perform_until(csound, 302.5);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "n1", NULL), 0.0);
+    csoundDestroy(csound);
+}
+
+/* whether the index of capture 'name' has a line starting with 'prefix'
+   and holding 'word' */
+
+static int capture_index_has(const char *name, const char *prefix,
+                             const char *word)
+{
+    char    idx[64], line[256];
+    FILE    *f;
+    int     found = 0;
+    snprintf(idx, sizeof(idx), "%s.idx", name);
+    if ((f = fopen(idx, "r")) == NULL)
+      return 0;
+    while (!found && fgets(line, sizeof(line), f) != NULL)
+      found = (strncmp(line, prefix, strlen(prefix)) == 0 &&
+               strstr(line, word) != NULL);
+    fclose(f);
+    return found;
+}
+
+/* the largest difference between a linseg ramp and what diskin2 reads
+   back from 'name' */
+
+static MYFLT ramp_error(const char *name)
+{
+    CSOUND  *csound;
+    char    orc[512];
+    MYFLT   err;
+    int     i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    snprintf(orc, sizeof(orc), "sr = 44100\n"
+                               "ksmps = 64\n"
+                               "nchnls = 1\n"
+                               "0dbfs = 1\n"
+                               "gkerr init 0\n"
+                               "instr 1\n"
+                               "a1 diskin2 \"%s\"\n"
+                               "aref linseg 0, 1, 1\n"
+                               "kerr max_k a1 - aref, 1, 1\n"
+                               "gkerr = max(gkerr, kerr)\n"
+                               "chnset gkerr, \"err\"\n"
+                               "endin\n"
+                               "schedule 1, 0, 1\n", name);
+    csoundCompileOrc(csound, orc);
+    csoundStart(csound);
+    for (i = 0; i < 600; i++)
+      csoundPerformKsmps(csound);
+    err = csoundGetControlChannel(csound, "err", NULL);
+    csoundDestroy(csound);
+    return err;
+}
+
+/* A capture written with --format=capture and capmark reads back through
+   diskin2 as it was rendered, and so do cap_export of it and cap_import
+   of that. */
+
+void test_capture_round_trip(void)
+{
+    CSOUND  *csound;
+    char    *exp_argv[] = { "cap_export", "cap_test.cap", "cap_test.wav" };
+    char    *imp_argv[] = { "cap_import", "cap_test.wav", "cap_test2.cap" };
+    int     i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-ocap_test.cap");
+    csoundSetOption(csound, "--format=capture");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 44100\n"
+                             "ksmps = 64\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "a1 linseg 0, 1, 1\n"
+                             "out a1\n"
+                             "endin\n"
+                             "instr 2\n"
+                             "capmark \"verse\"\n"
+                             "endin\n"
+                             "schedule 1, 0, 1\n"
+                             "schedule 2, 0.5, 0\n");
+    csoundStart(csound);
+    for (i = 0; i < 700; i++)
+      csoundPerformKsmps(csound);
+    csoundDestroy(csound);
+    CU_ASSERT(capture_index_has("cap_test.cap", "b 0 ", ""));
+    CU_ASSERT(capture_index_has("cap_test.cap", "m ", "verse"));
+    CU_ASSERT(ramp_error("cap_test.cap") < 1.0e-6);
+
+    /* the utilities are registered once the instance has started */
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "instr 1\nendin\n");
+    csoundStart(csound);
+    CU_ASSERT_EQUAL(csoundRunUtility(csound, "cap_export", 3, exp_argv), 0);
+    CU_ASSERT_EQUAL(csoundRunUtility(csound, "cap_import", 3, imp_argv), 0);
+    csoundDestroy(csound);
+    CU_ASSERT(ramp_error("cap_test.wav") < 1.0e-6);
+    CU_ASSERT(capture_index_has("cap_test2.cap", "b 0 ", ""));
+    CU_ASSERT(ramp_error("cap_test2.cap") < 1.0e-6);
+    remove("cap_test.cap");
+    remove("cap_test.cap.idx");
+    remove("cap_test.wav");
+    remove("cap_test2.cap");
+    remove("cap_test2.cap.idx");
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -73,6 +544,20 @@ int main()
     if ((NULL == CU_add_test(pSuite, "Test daemon mode", test_daemon))
         || (NULL == CU_add_test(pSuite, "Test evalcode", test_eval_code))
 	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async)) 
+	|| (NULL == CU_add_test(pSuite, "Test scoreEventStrings",
+	                        test_score_event_strings))
+	|| (NULL == CU_add_test(pSuite, "Test template with a source GEN",
+	                        test_template_source_gen))
+	|| (NULL == CU_add_test(pSuite, "Test voice stealing past maxalloc",
+	                        test_voice_stealing))
+	|| (NULL == CU_add_test(pSuite, "Test stem render", test_stem_render))
+	|| (NULL == CU_add_test(pSuite, "Test look-ahead", test_look_ahead))
+	|| (NULL == CU_add_test(pSuite, "Test binary score round trip",
+	                        test_score_binary))
+	|| (NULL == CU_add_test(pSuite, "Test timing wheel overflow",
+	                        test_timing_wheel_overflow))
+	|| (NULL == CU_add_test(pSuite, "Test capture round trip",
+	                        test_capture_round_trip))
 	)
     {
         CU_cleanup_registry();
@@ -0,0 +1,178 @@
+/*
+ * Tests of the ring that holds the messages of one OSClisten
+ * (Opcodes/osc_ring.h), read against a fake clock.
+ */
+
+#include <stdio.h>
+#include "csound.h"
+#include "osc_ring.h"
+#include "CUnit/Basic.h"
+
+#define SR      1000.0
+#define KSMPS   10.0
+
+/* wall clock in samples less the score time: score time 0 is 100 s */
+static double  clock_ofs = 100.0 * SR;
+static int     clock_calls = 0;
+
+static double fake_clock(void *data, double start)
+{
+    (void) data; (void) start;
+    clock_calls++;
+    return clock_ofs;
+}
+
+static void post(OSC_RING *r, MYFLT value, double time)
+{
+    OSC_ARG *m = osc_ring_next(r);
+    if (m != NULL) {
+      m[0].number = value;
+      osc_ring_push(r, time);
+    }
+}
+
+/* the value of the message due in the cycle from 'start', -1 if none */
+static MYFLT due(OSC_RING *r, double start, int32_t *offset)
+{
+    OSC_ARG *m = osc_ring_due(r, start, KSMPS, SR, fake_clock, NULL, offset);
+    MYFLT   value;
+    if (m == NULL)
+      return (MYFLT) -1;
+    value = m[0].number;
+    osc_ring_take(r);
+    return value;
+}
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+void test_osc_ring_full(void)
+{
+    CSOUND   *csound = csoundCreate(NULL);
+    OSC_RING r;
+    int32_t  offset;
+    osc_ring_init(csound, &r, 1, 3);
+    CU_ASSERT_EQUAL(r.size, 4);
+    post(&r, 1, 0.0);
+    post(&r, 2, 0.0);
+    post(&r, 3, 0.0);
+    post(&r, 4, 0.0);
+    CU_ASSERT_EQUAL(r.dropped, 0);
+    /* full: the next is dropped and counted */
+    CU_ASSERT_PTR_NULL(osc_ring_next(&r));
+    CU_ASSERT_EQUAL(r.dropped, 1);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 1);
+    post(&r, 5, 0.0);
+    CU_ASSERT_EQUAL(r.dropped, 1);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 2);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 3);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 4);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 5);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), -1);
+    /* messages not in a bundle never ask the clock */
+    CU_ASSERT_EQUAL(clock_calls, 0);
+    csound->Free(csound, r.args);
+    csound->Free(csound, r.time);
+    csoundDestroy(csound);
+}
+
+void test_osc_ring_due(void)
+{
+    CSOUND   *csound = csoundCreate(NULL);
+    OSC_RING r;
+    int32_t  offset;
+    osc_ring_init(csound, &r, 1, 16);
+    post(&r, 1, 100.505);               /* score sample 505 */
+    post(&r, 2, 0.0);                   /* now */
+    post(&r, 3, 100.6025);              /* score sample 602.5 */
+    /* the immediate message passes the held bundle */
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 2);
+    CU_ASSERT_EQUAL(offset, 0);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), -1);
+    CU_ASSERT(clock_calls > 0);
+    CU_ASSERT_EQUAL(due(&r, 490, &offset), -1);
+    /* each bundle in its cycle, at its sample */
+    CU_ASSERT_EQUAL(due(&r, 500, &offset), 1);
+    CU_ASSERT_EQUAL(offset, 5);
+    CU_ASSERT_EQUAL(due(&r, 500, &offset), -1);
+    CU_ASSERT_EQUAL(due(&r, 600, &offset), 3);
+    CU_ASSERT_EQUAL(offset, 2);
+    /* a bundle whose time has passed is due at once */
+    post(&r, 4, 100.2);
+    CU_ASSERT_EQUAL(due(&r, 700, &offset), 4);
+    CU_ASSERT_EQUAL(offset, 0);
+    csound->Free(csound, r.args);
+    csound->Free(csound, r.time);
+    csoundDestroy(csound);
+}
+
+void test_osc_ring_rotate(void)
+{
+    CSOUND   *csound = csoundCreate(NULL);
+    OSC_RING r;
+    int32_t  offset;
+    osc_ring_init(csound, &r, 1, 4);
+    /* move the read position so that what follows wraps round the end */
+    post(&r, 0, 0.0);
+    post(&r, 0, 0.0);
+    post(&r, 0, 0.0);
+    due(&r, 0, &offset);
+    due(&r, 0, &offset);
+    due(&r, 0, &offset);
+    post(&r, 1, 101.0);
+    post(&r, 2, 101.5);
+    post(&r, 3, 0.0);
+    post(&r, 4, 0.0);
+    /* the immediate ones first, in order, then the bundles in theirs */
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 3);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), 4);
+    CU_ASSERT_EQUAL(due(&r, 0, &offset), -1);
+    CU_ASSERT_EQUAL(due(&r, 1000, &offset), 1);
+    CU_ASSERT_EQUAL(due(&r, 1000, &offset), -1);
+    CU_ASSERT_EQUAL(due(&r, 1500, &offset), 2);
+    CU_ASSERT_EQUAL(r.dropped, 0);
+    csound->Free(csound, r.args);
+    csound->Free(csound, r.time);
+    csoundDestroy(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("OSC ring tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test full ring", test_osc_ring_full))
+        || (NULL == CU_add_test(pSuite, "Test due messages",
+                                test_osc_ring_due))
+        || (NULL == CU_add_test(pSuite, "Test rotation past held bundles",
+                                test_osc_ring_rotate))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -1,6 +1,8 @@
 #include "csound.hpp"
 #include "csPerfThread.hpp"
+#include "csPerfPool.hpp"
 #include <stdio.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 
 int init_suite1(void)
@@ -79,6 +81,118 @@ void test_record(void)
     csound.Reset();
 }
 
+/* Commands that spill to the locked message queue, because the queue is
+   full (the thread is paused) or they are too big for it, still run in
+   the order they were sent: instr 1 counts those that arrive out of
+   order. */
+
+void test_perfthread_order(void)
+{
+    MYFLT   p[40];
+    char    msg[64];
+    int     n;
+    CSOUND  *csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 1000\n"
+                             "ksmps = 10\n"
+                             "giprev init 0\n"
+                             "gibad init 0\n"
+                             "instr 1\n"
+                             "if p4 != giprev + 1 then\n"
+                             "gibad += 1\n"
+                             "endif\n"
+                             "giprev = p4\n"
+                             "chnset giprev, \"last\"\n"
+                             "chnset gibad, \"bad\"\n"
+                             "endin\n");
+    csoundReadScore(csound, "f 0 2\n");
+    csoundStart(csound);
+    {
+      CsoundPerformanceThread pt(csound);
+      memset(p, 0, sizeof(p));
+      p[0] = 1; p[2] = 0.01;
+      for (n = 1; n <= 1200; n++) {
+        if (n % 7 == 0) {
+          snprintf(msg, sizeof(msg), "i 1 0 0.01 %d", n);
+          CU_ASSERT_EQUAL(pt.InputMessage(msg), 0);
+        }
+        else {
+          /* now and then more p-fields than the queue holds */
+          int pcnt = (n % 100 == 50 ? 40 : 4);
+          p[3] = (MYFLT) n;
+          CU_ASSERT_EQUAL(pt.ScoreEvent(0, 'i', pcnt, p), 0);
+        }
+      }
+      pt.Play();
+      pt.Join();
+    }
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "last", NULL), 1200.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "bad", NULL), 0.0);
+    csoundDestroy(csound);
+}
+
+/* an instance that counts its k-cycles in channel "n" for 'dur' seconds */
+static CSOUND *pool_instance(double dur)
+{
+    char    sco[32];
+    CSOUND  *csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundCompileOrc(csound, "sr = 1000\n"
+                             "ksmps = 10\n"
+                             "gkn init 0\n"
+                             "instr 1\n"
+                             "gkn += 1\n"
+                             "chnset gkn, \"n\"\n"
+                             "endin\n");
+    snprintf(sco, sizeof(sco), "i 1 0 %g\n", dur);
+    csoundReadScore(csound, sco);
+    csoundStart(csound);
+    return csound;
+}
+
+void test_perf_pool(void)
+{
+    CsoundPerformancePool pool(2);
+    CSOUND  *cs[4];
+    int     h[4], i;
+    RTCLOCK clk;
+    /* two real-time instances, one that is stopped early, and two that
+       run as fast as they can beside them */
+    cs[0] = pool_instance(0.5);
+    cs[1] = pool_instance(100.0);
+    cs[2] = pool_instance(0.5);
+    cs[3] = pool_instance(0.5);
+    h[0] = pool.Add(cs[0], true);
+    h[1] = pool.Add(cs[1], true);
+    h[2] = pool.Add(cs[2], false);
+    h[3] = pool.Add(cs[3], false, 4);
+    for (i = 0; i < 4; i++) {
+      CU_ASSERT(h[i] >= 0);
+      pool.Play(h[i]);
+    }
+    csoundSleep(100);
+    /* a stopped instance finishes within a k-cycle or so */
+    csoundInitTimerStruct(&clk);
+    pool.Stop(h[1]);
+    while (pool.GetStatus(h[1]) == 0 && csoundGetRealTime(&clk) < 1.0)
+      csoundSleep(1);
+    CU_ASSERT(csoundGetRealTime(&clk) < 0.1);
+    CU_ASSERT(pool.Remove(h[1]) > 0);
+    pool.Join();
+    for (i = 0; i < 4; i++) {
+      if (i == 1)
+        continue;
+      CU_ASSERT(pool.GetStatus(h[i]) > 0);
+      /* 0.5 seconds of 10 ms k-cycles */
+      CU_ASSERT_EQUAL(csoundGetControlChannel(cs[i], "n", NULL), 50.0);
+      pool.Remove(h[i]);
+    }
+    for (i = 0; i < 4; i++)
+      csoundDestroy(cs[i]);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -97,6 +211,9 @@ int main()
     /* add the tests to the suite */
     if ((NULL == CU_add_test(pSuite, "Test Record", test_record))
             || (NULL == CU_add_test(pSuite, "Test Performance Thread", test_perfthread))
+            || (NULL == CU_add_test(pSuite, "Test Performance Pool", test_perf_pool))
+            || (NULL == CU_add_test(pSuite, "Test command order across a spill",
+                                    test_perfthread_order))
         )
     {
         CU_cleanup_registry();
@@ -0,0 +1,152 @@
+/*
+ * Tests of the decode-ahead stream reader (csoundStreamOpen() and
+ * friends in Engine/envvar.c), fed by a synthetic source whose every
+ * frame holds its own frame number.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include "csoundCore.h"
+#include "envvar.h"
+#include "CUnit/Basic.h"
+
+typedef struct {
+    int64_t pos, length;
+    int     seeks;
+} SOURCE;
+
+static int source_read(void *data, MYFLT *buf, int nframes)
+{
+    SOURCE  *s = (SOURCE*) data;
+    int     i;
+    for (i = 0; i < nframes && s->pos < s->length; i++)
+      buf[i] = (MYFLT) s->pos++;
+    return i;
+}
+
+static int source_seek(void *data, int64_t frame)
+{
+    SOURCE  *s = (SOURCE*) data;
+    if (frame < 0 || frame > s->length)
+      return -1;
+    s->pos = frame;
+    s->seeks++;
+    return 0;
+}
+
+/* reads nframes at 'frame' and checks they are frame, frame+1, ...
+   modulo 'wrap' */
+static int read_check(CSOUND *csound, void *r, int64_t frame, int nframes,
+                      int64_t first, int64_t wrap)
+{
+    MYFLT   buf[256];
+    int     i, n = csoundStreamRead(csound, r, frame, buf, nframes);
+    if (n != nframes)
+      return 0;
+    for (i = 0; i < n; i++)
+      if (buf[i] != (MYFLT) ((first + i) % wrap))
+        return 0;
+    return 1;
+}
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+void test_stream_seek(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    SOURCE  src = { 0, 100000, 0 };
+    MYFLT   x;
+    void    *r;
+    /* a ring of 1024 frames, half of it kept behind the reader */
+    r = csoundStreamOpen(csound, "test", 1, src.length, 1024,
+                         source_read, source_seek, &src,
+                         CS_STREAM_WAIT | CS_STREAM_BACK);
+    CU_ASSERT_PTR_NOT_NULL(r);
+    CU_ASSERT(read_check(csound, r, 0, 64, 0, src.length));
+    /* forward, into what is already decoded: skipped without a seek */
+    CU_ASSERT(read_check(csound, r, 300, 64, 300, src.length));
+    CU_ASSERT_EQUAL(src.seeks, 0);
+    /* backward, still in the ring */
+    CU_ASSERT(read_check(csound, r, 200, 64, 200, src.length));
+    CU_ASSERT(read_check(csound, r, -1, 64, 264, src.length));
+    CU_ASSERT_EQUAL(src.seeks, 0);
+    /* outside the ring: the source seeks */
+    CU_ASSERT(read_check(csound, r, 50000, 64, 50000, src.length));
+    CU_ASSERT_EQUAL(src.seeks, 1);
+    /* back within what has been read since */
+    CU_ASSERT(read_check(csound, r, 50010, 64, 50010, src.length));
+    CU_ASSERT_EQUAL(src.seeks, 1);
+    /* an i-time seek, then reading on from it */
+    csoundStreamSeek(csound, r, 70000);
+    CU_ASSERT_EQUAL(src.seeks, 2);
+    CU_ASSERT(read_check(csound, r, -1, 256, 70000, src.length));
+    CU_ASSERT(read_check(csound, r, 69900, 100, 69900, src.length));
+    CU_ASSERT_EQUAL(src.seeks, 2);
+    /* the end of the stream */
+    CU_ASSERT(read_check(csound, r, src.length - 10, 10,
+                         src.length - 10, src.length));
+    CU_ASSERT_EQUAL(csoundStreamRead(csound, r, -1, &x, 1), 0);
+    csoundStreamClose(csound, r);
+    csoundDestroy(csound);
+}
+
+void test_stream_loop(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    SOURCE  src = { 0, 1000, 0 };
+    void    *r;
+    int64_t frame;
+    int     ok = 1;
+    r = csoundStreamOpen(csound, "loop", 1, src.length, 512,
+                         source_read, source_seek, &src,
+                         CS_STREAM_WAIT | CS_STREAM_LOOP);
+    CU_ASSERT_PTR_NOT_NULL(r);
+    /* across the end three times, in blocks that do not divide it */
+    for (frame = 0; frame < 3000; frame += 96)
+      ok &= read_check(csound, r, -1, 96, frame, src.length);
+    CU_ASSERT(ok);
+    CU_ASSERT(src.seeks >= 3);
+    csoundStreamClose(csound, r);
+    csoundDestroy(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Stream reader tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test stream skip and seek",
+                             test_stream_seek))
+        || (NULL == CU_add_test(pSuite, "Test stream loop", test_stream_loop))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -155,6 +155,8 @@ def runTest():
         ["test_array_function_call.csd", "test synthesizing an array arg from a function-call"],
         ["test_array_operations.csd", "test multiple operations on multiple array types"],
         ["prints_number_no_crash.csd", "test prints does not crash when given a number arguments", 1],
+        ["test_maxalloc_pfields.csd", "p-fields of a note are unaffected by maxalloc voice stealing"],
+        ["test_streamrecv_loopback.csd", "streamsend to streamrecv over loopback"],
     ]
 
     arrayTests = [["arrays/arrays_i_local.csd", "local i[]"],
@@ -0,0 +1,5 @@
+
+#include "utilmain.h"
+
+UTIL_MAIN("cap_import")
+
@@ -0,0 +1,222 @@
+/*
+    capture.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* cap_export and cap_import: copy a capture file (--format=capture) to
+   an ordinary sound file, or a sound file to a capture. */
+
+#include "std_util.h"
+#include <sndfile.h>
+#include "soundio.h"
+
+#define CAP_FRAMES  4096
+
+static const struct {
+    const char  *name;
+    int         format;
+} cap_export_types[] = {
+    { "wav",  SF_FORMAT_WAV  | SF_FORMAT_FLOAT  },
+    { "aiff", SF_FORMAT_AIFF | SF_FORMAT_FLOAT  },
+    { "w64",  SF_FORMAT_W64  | SF_FORMAT_FLOAT  },
+    { "rf64", SF_FORMAT_RF64 | SF_FORMAT_FLOAT  },
+    { "caf",  SF_FORMAT_CAF  | SF_FORMAT_FLOAT  },
+    { "flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_24 },
+    { NULL,   0 }
+};
+
+/* copies frames first to last (-1: to the end) from one file to another;
+   if fd is the handle of a capture, its index counts each block written */
+
+static int32_t cap_copy(CSOUND *csound, SNDFILE *in, SNDFILE *out, void *fd,
+                        int32_t nchnls, int64_t first, int64_t last)
+{
+    MYFLT   *buf;
+    int64_t n;
+    sf_count_t got;
+    int32_t retval = 0;
+
+    if (first > 0 && sf_seek(in, (sf_count_t) first, SEEK_SET) < 0) {
+      csound->Message(csound, Str("cap: cannot seek to frame %ld\n"),
+                      (long) first);
+      return -1;
+    }
+    buf = (MYFLT*) csound->Malloc(csound,
+                                  sizeof(MYFLT) * CAP_FRAMES * nchnls);
+    for (n = first; last < 0 || n < last; n += got) {
+      sf_count_t want = CAP_FRAMES;
+      if (last >= 0 && last - n < want)
+        want = (sf_count_t) (last - n);
+      if ((got = sf_readf_MYFLT(in, buf, want)) <= 0)
+        break;
+      if (UNLIKELY(sf_writef_MYFLT(out, buf, got) != got)) {
+        csound->Message(csound, Str("cap: write error: %s\n"),
+                        sf_strerror(out));
+        retval = -1;
+        break;
+      }
+      if (fd != NULL)
+        csound->CaptureWrite(csound, fd, (int) got);
+    }
+    csound->Free(csound, buf);
+    return retval;
+}
+
+static void cap_export_usage(CSOUND *csound)
+{
+    csound->Message(csound, "%s",
+                    Str("Usage: cap_export [-t type] [-s start] [-e end] "
+                        "capture_file sound_file\n"
+                        "  type: wav (default), aiff, w64, rf64, caf "
+                        "or flac\n"
+                        "  start, end: in seconds\n"));
+}
+
+static int32_t cap_export(CSOUND *csound, int32_t argc, char **argv)
+{
+    SF_INFO sfinfo, osfinfo;
+    SNDFILE *in, *out;
+    char    *inname, *outname, *type = "wav";
+    double  start = 0.0, end = -1.0;
+    int32_t i, retval;
+
+    while (argc > 3 && argv[1][0] == '-') {
+      if (strcmp(argv[1], "-t") == 0)
+        type = argv[2];
+      else if (strcmp(argv[1], "-s") == 0)
+        start = atof(argv[2]);
+      else if (strcmp(argv[1], "-e") == 0)
+        end = atof(argv[2]);
+      else
+        break;
+      argc -= 2, argv += 2;
+    }
+    if (argc != 3) {
+      cap_export_usage(csound);
+      return 1;
+    }
+    for (i = 0; cap_export_types[i].name != NULL; i++)
+      if (strcmp(cap_export_types[i].name, type) == 0)
+        break;
+    if (UNLIKELY(cap_export_types[i].name == NULL)) {
+      cap_export_usage(csound);
+      return 1;
+    }
+    inname = csound->FindInputFile(csound, argv[1], "SFDIR;SSDIR");
+    if (UNLIKELY(inname == NULL)) {
+      csound->Message(csound, Str("Cannot open input file %s\n"), argv[1]);
+      return 1;
+    }
+    if (UNLIKELY(csound->CaptureInfo(csound, inname, &sfinfo) != 0)) {
+      csound->Message(csound, Str("%s: not a capture file (no index)\n"),
+                      inname);
+      csound->Free(csound, inname);
+      return 1;
+    }
+    in = sf_open(inname, SFM_READ, &sfinfo);
+    csound->Free(csound, inname);
+    if (UNLIKELY(in == NULL)) {
+      csound->Message(csound, Str("Cannot open input file %s\n"), argv[1]);
+      return 1;
+    }
+    memset(&osfinfo, 0, sizeof(SF_INFO));
+    osfinfo.samplerate = sfinfo.samplerate;
+    osfinfo.channels = sfinfo.channels;
+    osfinfo.format = cap_export_types[i].format;
+    outname = csound->FindOutputFile(csound, argv[2], "SFDIR");
+    out = (outname == NULL ? NULL : sf_open(outname, SFM_WRITE, &osfinfo));
+    if (UNLIKELY(out == NULL)) {
+      csound->Message(csound, Str("Cannot open output file %s\n"), argv[2]);
+      csound->Free(csound, outname);
+      sf_close(in);
+      return 1;
+    }
+    retval = cap_copy(csound, in, out, NULL, sfinfo.channels,
+                      (int64_t) (start * sfinfo.samplerate),
+                      (end < 0.0 ? -1 : (int64_t) (end * sfinfo.samplerate)));
+    sf_close(out);
+    sf_close(in);
+    csound->Free(csound, outname);
+    return (retval == 0 ? 0 : 1);
+}
+
+static int32_t cap_import(CSOUND *csound, int32_t argc, char **argv)
+{
+    SF_INFO sfinfo, osfinfo;
+    SNDFILE *in, *out;
+    void    *fd;
+    char    *inname;
+    int32_t retval;
+
+    if (argc != 3) {
+      csound->Message(csound, "%s",
+                      Str("Usage: cap_import sound_file capture_file\n"));
+      return 1;
+    }
+    inname = csound->FindInputFile(csound, argv[1], "SFDIR;SSDIR");
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    in = (inname == NULL ? NULL : sf_open(inname, SFM_READ, &sfinfo));
+    csound->Free(csound, inname);
+    if (UNLIKELY(in == NULL)) {
+      csound->Message(csound, Str("Cannot open input file %s\n"), argv[1]);
+      return 1;
+    }
+    /* opened as a capture, Csound writes the index */
+    memset(&osfinfo, 0, sizeof(SF_INFO));
+    osfinfo.samplerate = sfinfo.samplerate;
+    osfinfo.channels = sfinfo.channels;
+    osfinfo.format = TYPE2SF(TYP_CAPTURE);
+    fd = csound->FileOpen2(csound, &out, CSFILE_SND_W, argv[2], &osfinfo,
+                           "SFDIR", CSFTYPE_RAW_AUDIO, 0);
+    if (UNLIKELY(fd == NULL)) {
+      csound->Message(csound, Str("Cannot open output file %s\n"), argv[2]);
+      sf_close(in);
+      return 1;
+    }
+    retval = cap_copy(csound, in, out, fd, sfinfo.channels, 0, -1);
+    csound->FileClose(csound, fd);
+    sf_close(in);
+    return (retval == 0 ? 0 : 1);
+}
+
+/* module interface */
+
+int32_t cap_export_init_(CSOUND *csound)
+{
+    int32_t retval = csound->AddUtility(csound, "cap_export", cap_export);
+    if (!retval) {
+      retval =
+        csound->SetUtilityDescription(csound, "cap_export",
+                                      Str("translate a capture file "
+                                          "to a sound file"));
+    }
+    return retval;
+}
+
+int32_t cap_import_init_(CSOUND *csound)
+{
+    int32_t retval = csound->AddUtility(csound, "cap_import", cap_import);
+    if (!retval) {
+      retval =
+        csound->SetUtilityDescription(csound, "cap_import",
+                                      Str("translate a sound file "
+                                          "to a capture file"));
+    }
+    return retval;
+}
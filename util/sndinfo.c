@@ -68,6 +68,8 @@ static int32_t sndinfo(CSOUND *csound, int32_t argc, char **argv)
         continue;
       }
       memset(&sf_info, 0, sizeof(SF_INFO));
+      /* a capture file has no header, but has an index */
+      csound->CaptureInfo(csound, fname, &sf_info);
       hndl = sf_open(fname, SFM_READ, &sf_info);
       if (UNLIKELY(hndl == NULL)) {
         csound->Message(csound, Str("%s: Not a sound file\n"), fname);
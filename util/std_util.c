@@ -62,6 +62,8 @@ PUBLIC int32_t csoundModuleCreate(CSOUND *csound)
     int32_t   err = 0;
 
     err |= atsa_init_(csound);
+    err |= cap_export_init_(csound);
+    err |= cap_import_init_(csound);
     err |= envext_init_(csound);
     err |= het_export_init_(csound);
     err |= het_import_init_(csound);
@@ -26,6 +26,8 @@
 #include <inttypes.h>
 
 extern int32_t atsa_init_(CSOUND *);
+extern int32_t cap_export_init_(CSOUND *);
+extern int32_t cap_import_init_(CSOUND *);
 extern int32_t cvanal_init_(CSOUND *);
 extern int32_t dnoise_init_(CSOUND *);
 extern int32_t envext_init_(CSOUND *);